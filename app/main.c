@@ -1,4 +1,14 @@
 #include "renderer.h"
+#include "transform.h"
+
+#include <string.h>
+#include <time.h>
+
+// Rate of the game logic when the renderer has its own thread
+#define SIMULATION_RATE 120
+
+// Longest time the main loop sleeps with on demand rendering, in seconds
+#define IDLE_TIMEOUT 0.5
 
 int
 main(int argc, char** argv)
@@ -8,6 +18,29 @@ main(int argc, char** argv)
     // Initialise the renderer
     vur_init(&ctx, "VuR");
 
+    // With --render-thread the renderer draws on its own thread from published snapshots.
+    // With --on-demand it only draws when something changed and otherwise sleeps.
+    bool render_thread = false;
+    bool on_demand = false;
+    for (int i = 1; i < argc; i++) {
+        render_thread |= strcmp(argv[i], "--render-thread") == 0;
+        on_demand |= strcmp(argv[i], "--on-demand") == 0;
+    }
+
+    // The rotating triangle of the render thread changes every tick, so it never idles
+    if (on_demand && !render_thread) {
+        vur_set_on_demand(&ctx, true, IDLE_TIMEOUT);
+    }
+    if (render_thread) {
+        vur_start_render_thread(&ctx);
+    }
+
+    // The triangle of the render thread is a node of a transform hierarchy
+    float angle = 0.0f;
+    TransformHierarchy transforms;
+    vut_transform_hierarchy_init(1, &transforms);
+    uint32_t triangle = vut_transform_add(&transforms, VUT_TRANSFORM_ROOT);
+
     // Main render loop
     while (!ctx.should_quit) {
         // Get events from window
@@ -18,13 +51,39 @@ main(int argc, char** argv)
         }
 
         // Update game logic
+        if (render_thread) {
+            angle += GLM_PIf / SIMULATION_RATE;
+
+            versor rotation;
+            glm_quatv(rotation, angle, GLM_ZUP);
+            vut_transform_set_rotation(&transforms, triangle, rotation);
+            vut_transform_hierarchy_update(&transforms);
+
+            SceneSnapshot* snapshot = vur_begin_snapshot(&ctx);
+            glm_mat4_identity(snapshot->view);
+            glm_mat4_identity(snapshot->projection);
+            snapshot->features = 0;
 
-        // Renderer draw
-        vur_draw(&ctx);
+            DrawCommand* draw = vur_snapshot_alloc_draws(snapshot, 1);
+            if (draw != NULL) {
+                *draw = (DrawCommand){ .vertex_count = 3 };
+                vut_transform_world_mat4(&transforms, triangle, draw->data.transform);
+            }
+
+            vur_publish_snapshot(&ctx);
+
+            // The render thread draws meanwhile, at its own rate
+            nanosleep(&(struct timespec){ .tv_nsec = 1000 * 1000 * 1000 / SIMULATION_RATE },
+                      NULL);
+        } else {
+            // Renderer draw, skipped on demand while the triangle stays the same
+            vur_draw(&ctx);
+        }
     }
 
-    // Clean up the renderer
+    // Clean up the renderer, which stops the render thread
     vur_destroy(&ctx);
+    vut_transform_hierarchy_destroy(&transforms);
 
     return 0;
 }
@@ -0,0 +1,284 @@
+/**
+ * @file compute_bench.c
+ * @brief Run a compute shader over a storage buffer with direct and indirect dispatches
+ * and check the results on the CPU
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ * Every dispatch multiplies the buffer by 2 or by 0.5 in turn, so after an even amount of
+ * dispatches every value must be exactly what it started as. Exits with a failure when a
+ * value differs, which makes it usable as a check of the compute path.
+ *
+ * Runs headless, so it also works on lavapipe:
+ *     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./bin/compute_bench
+ */
+
+#include "compute.h"
+#include "vk_util.h"
+
+#include "shaders.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define VALUE_COUNT (1024 * 1024)
+#define GROUP_SIZE 64
+#define ITERATIONS 100
+
+typedef struct
+{
+    float scale;
+    uint32_t count;
+} ScaleParams;
+
+typedef struct
+{
+    VkDevice device;
+    VkQueue queue;
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffer;
+    VkFence fence;
+    LayoutCache layout_cache;
+    DescriptorAllocator set_allocator;
+    ComputeProgram program;
+    VkDescriptorSet set;
+
+    // Host visible, so the results are read straight from the mapping
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    float* values;
+
+    VkBuffer indirect_buffer;
+    VkDeviceMemory indirect_memory;
+} Bench;
+
+static double
+now_ms(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+static uint32_t
+find_graphics_queue_family(VkPhysicalDevice gpu)
+{
+    uint32_t family_count;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, NULL);
+    ArenaScope scope = vut_arena_begin_scope(vut_get_scratch_arena());
+    VkQueueFamilyProperties* families =
+        VUT_ARENA_ALLOC(vut_get_scratch_arena(), VkQueueFamilyProperties, family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, families);
+
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < family_count; i++) {
+        if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            index = i;
+            break;
+        }
+    }
+
+    vut_arena_end_scope(scope);
+    return index;
+}
+
+static void
+bench_init(VkPhysicalDevice gpu,
+           VkDevice device,
+           VkQueue queue,
+           uint32_t queue_family_index,
+           Bench* bench)
+{
+    bench->device = device;
+    bench->queue = queue;
+    vut_init_command_pool(device, queue_family_index, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                          &bench->command_pool);
+    vut_alloc_command_buffer(device, bench->command_pool, 1, &bench->command_buffer);
+    vut_init_fence(device, 0, &bench->fence);
+
+    vut_layout_cache_init(device, false, &bench->layout_cache);
+    if (vur_init_compute_program(device, &bench->layout_cache, VK_NULL_HANDLE, NULL,
+                                 scale_comp_spv, scale_comp_spv_size,
+                                 &bench->program) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the compute program\n");
+        abort();
+    }
+
+    const VkMemoryPropertyFlags host_memory =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (vut_init_buffer(device, gpu, VALUE_COUNT * sizeof(float),
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host_memory, &bench->buffer,
+                        &bench->memory) != VK_SUCCESS ||
+        vut_init_buffer(device, gpu, sizeof(VkDispatchIndirectCommand),
+                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, host_memory,
+                        &bench->indirect_buffer, &bench->indirect_memory) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the buffers\n");
+        abort();
+    }
+    vkMapMemory(device, bench->memory, 0, VK_WHOLE_SIZE, 0, (void**)&bench->values);
+
+    VkDispatchIndirectCommand* command;
+    vkMapMemory(device, bench->indirect_memory, 0, VK_WHOLE_SIZE, 0, (void**)&command);
+    *command = (VkDispatchIndirectCommand){ VALUE_COUNT / GROUP_SIZE, 1, 1 };
+    vkUnmapMemory(device, bench->indirect_memory);
+
+    const VkDescriptorPoolSize pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+    };
+    vur_descriptor_allocator_init(device, 1, 1, &pool_size, &bench->set_allocator);
+    vur_compute_alloc_set(&bench->program, &bench->set_allocator, 0, &bench->set);
+    vut_write_buffer_descriptor(device, bench->set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                bench->buffer, VK_WHOLE_SIZE);
+}
+
+static void
+bench_destroy(Bench* bench)
+{
+    vkDestroyBuffer(bench->device, bench->buffer, NULL);
+    vkFreeMemory(bench->device, bench->memory, NULL);
+    vkDestroyBuffer(bench->device, bench->indirect_buffer, NULL);
+    vkFreeMemory(bench->device, bench->indirect_memory, NULL);
+    vur_descriptor_allocator_destroy(&bench->set_allocator);
+    vur_destroy_compute_program(bench->device, &bench->program);
+    vut_layout_cache_destroy(&bench->layout_cache);
+    vkDestroyFence(bench->device, bench->fence, NULL);
+    vkDestroyCommandPool(bench->device, bench->command_pool, NULL);
+}
+
+// Returns the time from submit until the results are visible to the host, -1 on a mismatch
+static double
+bench_run(Bench* bench, bool indirect)
+{
+    for (uint32_t i = 0; i < VALUE_COUNT; i++) {
+        bench->values[i] = (float)i;
+    }
+
+    vkResetCommandPool(bench->device, bench->command_pool, 0);
+    vut_begin_command_buffer(bench->command_buffer);
+    vur_compute_bind(bench->command_buffer, &bench->program, 0, 1, &bench->set);
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        const ScaleParams params = {
+            .scale = (i % 2) ? 0.5f : 2.0f,
+            .count = VALUE_COUNT,
+        };
+        vur_compute_push_constants(bench->command_buffer, &bench->program, sizeof(params),
+                                   &params);
+        if (indirect) {
+            vut_dispatch_indirect(bench->command_buffer, bench->indirect_buffer, 0);
+        } else {
+            vut_dispatch(bench->command_buffer, VALUE_COUNT / GROUP_SIZE, 1, 1);
+        }
+
+        // Every dispatch reads what the previous one wrote
+        vut_memory_barrier(bench->command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+    vut_memory_barrier(bench->command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                       VK_ACCESS_HOST_READ_BIT);
+    vkEndCommandBuffer(bench->command_buffer);
+
+    const VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &bench->command_buffer,
+    };
+
+    double start = now_ms();
+    vkResetFences(bench->device, 1, &bench->fence);
+    vkQueueSubmit(bench->queue, 1, &submit_info, bench->fence);
+    vkWaitForFences(bench->device, 1, &bench->fence, VK_TRUE, UINT64_MAX);
+    double time = now_ms() - start;
+
+    for (uint32_t i = 0; i < VALUE_COUNT; i++) {
+        if (bench->values[i] != (float)i) {
+            fprintf(stderr, "Value %u is %f instead of %u\n", i, bench->values[i], i);
+            return -1.0;
+        }
+    }
+
+    return time;
+}
+
+int
+main(void)
+{
+    // Enumerations of the vut_ functions allocate their arrays from it
+    Arena arena;
+    vut_arena_init(64 * 1024, &arena);
+    vut_set_scratch_arena(&arena);
+
+    const VkApplicationInfo app_info = {
+        .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+        .pNext = NULL,
+        .pApplicationName = "compute_bench",
+        .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
+        .apiVersion = VK_API_VERSION_1_2,
+        .pEngineName = "No Engine",
+    };
+    const VkInstanceCreateInfo instance_info = {
+        .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .pApplicationInfo = &app_info,
+        .enabledExtensionCount = 0,
+        .ppEnabledExtensionNames = NULL,
+        .enabledLayerCount = 0,
+        .ppEnabledLayerNames = NULL,
+    };
+    VkInstance instance;
+    if (vkCreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the instance\n");
+        return EXIT_FAILURE;
+    }
+
+    uint32_t gpu_count;
+    vut_get_physical_devices(instance, &gpu_count, NULL);
+    VkPhysicalDevice* gpus = VUT_ARENA_ALLOC(&arena, VkPhysicalDevice, gpu_count);
+    vut_get_physical_devices(instance, &gpu_count, gpus);
+    VkPhysicalDevice gpu;
+    vut_pick_physical_device(gpus, gpu_count, &gpu);
+
+    // Dispatches go to the queue the renderer would use for async compute
+    uint32_t graphics_family = find_graphics_queue_family(gpu);
+    uint32_t compute_family, compute_index;
+    vut_get_compute_queue(gpu, graphics_family, &compute_family, &compute_index);
+
+    const DeviceFeatures features = { 0 };
+    VkDevice device;
+    if (vut_init_device(gpu, graphics_family, compute_family, compute_index, &features,
+                        &device) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the device\n");
+        return EXIT_FAILURE;
+    }
+    VkQueue queue;
+    vkGetDeviceQueue(device, compute_family, compute_index, &queue);
+
+    Bench bench;
+    bench_init(gpu, device, queue, compute_family, &bench);
+    double direct_ms = bench_run(&bench, false);
+    double indirect_ms = bench_run(&bench, true);
+    bench_destroy(&bench);
+
+    vkDestroyDevice(device, NULL);
+    vkDestroyInstance(instance, NULL);
+    vut_set_scratch_arena(NULL);
+    vut_arena_destroy(&arena);
+
+    if (direct_ms < 0.0 || indirect_ms < 0.0) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%u values x %u dispatches\n", VALUE_COUNT, ITERATIONS);
+    printf("direct:   %8.2f ms, %6.1f us per dispatch\n", direct_ms,
+           direct_ms * 1000.0 / ITERATIONS);
+    printf("indirect: %8.2f ms, %6.1f us per dispatch\n", indirect_ms,
+           indirect_ms * 1000.0 / ITERATIONS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file descriptor_bench.c
+ * @brief Compare the CPU cost of per draw descriptors with descriptor sets and with
+ * VK_EXT_descriptor_buffer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ * Every draw points a uniform buffer binding at its own range of a buffer, like the draw
+ * data fallback of the renderer. The classic path allocates, updates and binds a set per
+ * draw, the descriptor buffer path writes the descriptor into mapped memory and sets an
+ * offset. Only recording is timed.
+ *
+ * Runs headless, so it also works on lavapipe:
+ *     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./bin/descriptor_bench
+ */
+
+#include "descriptor_buffer.h"
+#include "layout_cache.h"
+#include "vk_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DRAW_COUNT 10000
+#define ITERATIONS 100
+#define DRAW_STRIDE 256
+
+typedef struct
+{
+    VkDevice device;
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffer;
+    LayoutCache layout_cache;
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+} Bench;
+
+static const ReflectedSet draw_set = {
+    .binding_count = 1,
+    .bindings = { {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .pImmutableSamplers = NULL,
+    } },
+    .unsized = false,
+};
+
+static double
+now_ms(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+static uint32_t
+find_graphics_queue_family(VkPhysicalDevice gpu)
+{
+    uint32_t family_count;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, NULL);
+    ArenaScope scope = vut_arena_begin_scope(vut_get_scratch_arena());
+    VkQueueFamilyProperties* families =
+        VUT_ARENA_ALLOC(vut_get_scratch_arena(), VkQueueFamilyProperties, family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, families);
+
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < family_count; i++) {
+        if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            index = i;
+            break;
+        }
+    }
+
+    vut_arena_end_scope(scope);
+    return index;
+}
+
+static void
+bench_init(VkPhysicalDevice gpu,
+           VkDevice device,
+           uint32_t queue_family_index,
+           bool descriptor_buffer,
+           Bench* bench)
+{
+    bench->device = device;
+    vut_init_command_pool(device, queue_family_index, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                          &bench->command_pool);
+    vut_alloc_command_buffer(device, bench->command_pool, 1, &bench->command_buffer);
+
+    vut_layout_cache_init(device, descriptor_buffer, &bench->layout_cache);
+    ShaderReflection reflection = { .stages = VK_SHADER_STAGE_VERTEX_BIT, .set_count = 1 };
+    reflection.sets[0] = draw_set;
+    vut_layout_cache_get_set_layout(&bench->layout_cache, &draw_set, &bench->set_layout);
+    vut_layout_cache_get_pipeline_layout(&bench->layout_cache, &reflection,
+                                         &bench->pipeline_layout);
+
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (descriptor_buffer) {
+        usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+    if (vut_init_buffer(device, gpu, DRAW_COUNT * DRAW_STRIDE, usage,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &bench->buffer,
+                        &bench->memory) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the draw buffer\n");
+        abort();
+    }
+}
+
+static void
+bench_destroy(Bench* bench)
+{
+    vkDestroyBuffer(bench->device, bench->buffer, NULL);
+    vkFreeMemory(bench->device, bench->memory, NULL);
+    vut_layout_cache_destroy(&bench->layout_cache);
+    vkDestroyCommandPool(bench->device, bench->command_pool, NULL);
+}
+
+static double
+bench_descriptor_sets(Bench* bench)
+{
+    const VkDescriptorPoolSize pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorCount = DRAW_COUNT,
+    };
+    VkDescriptorPool pool;
+    vut_init_descriptor_pool(bench->device, 0, DRAW_COUNT, 1, &pool_size, &pool);
+
+    double start = now_ms();
+    for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++) {
+        vkResetCommandPool(bench->device, bench->command_pool, 0);
+        vkResetDescriptorPool(bench->device, pool, 0);
+        vut_begin_command_buffer(bench->command_buffer);
+
+        for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+            VkDescriptorSet set;
+            vut_alloc_descriptor_set(bench->device, pool, bench->set_layout, &set);
+
+            const VkDescriptorBufferInfo buffer_info = {
+                .buffer = bench->buffer,
+                .offset = i * DRAW_STRIDE,
+                .range = DRAW_STRIDE,
+            };
+            const VkWriteDescriptorSet write = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .pNext = NULL,
+                .dstSet = set,
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .pImageInfo = NULL,
+                .pBufferInfo = &buffer_info,
+                .pTexelBufferView = NULL,
+            };
+            vkUpdateDescriptorSets(bench->device, 1, &write, 0, NULL);
+            vkCmdBindDescriptorSets(bench->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                    bench->pipeline_layout, 0, 1, &set, 0, NULL);
+        }
+
+        vkEndCommandBuffer(bench->command_buffer);
+    }
+    double elapsed = now_ms() - start;
+
+    vkDestroyDescriptorPool(bench->device, pool, NULL);
+    return elapsed;
+}
+
+static double
+bench_descriptor_buffer(VkPhysicalDevice gpu, Bench* bench)
+{
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT properties;
+    vut_get_descriptor_buffer_properties(gpu, &properties);
+    VkDeviceSize alignment = properties.descriptorBufferOffsetAlignment;
+    VkDeviceSize set_size = vut_get_descriptor_set_layout_size(bench->device, bench->set_layout);
+    set_size = (set_size + alignment - 1) & ~(alignment - 1);
+    VkDeviceSize binding_offset = vut_get_descriptor_binding_offset(bench->device,
+                                                                    bench->set_layout, 0);
+
+    DescriptorBuffer descriptors;
+    if (vur_descriptor_buffer_init(bench->device, gpu, DRAW_COUNT * set_size, &descriptors) !=
+        VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the descriptor buffer\n");
+        abort();
+    }
+    VkDeviceAddress address = vut_get_buffer_address(bench->device, bench->buffer);
+    const VkDescriptorBufferBindingInfoEXT binding = vur_descriptor_buffer_binding(&descriptors);
+    const uint32_t buffer_index = 0;
+
+    double start = now_ms();
+    for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++) {
+        vkResetCommandPool(bench->device, bench->command_pool, 0);
+        vur_descriptor_buffer_reset(&descriptors);
+        vut_begin_command_buffer(bench->command_buffer);
+        vut_bind_descriptor_buffers(bench->command_buffer, 1, &binding);
+
+        for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+            VkDeviceSize offset;
+            vur_descriptor_buffer_alloc(&descriptors, set_size, &offset);
+            vur_descriptor_buffer_write_buffer(&descriptors, offset + binding_offset,
+                                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                               address + i * DRAW_STRIDE, DRAW_STRIDE);
+            vut_set_descriptor_buffer_offsets(bench->command_buffer,
+                                              VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                              bench->pipeline_layout, 0, 1, &buffer_index,
+                                              &offset);
+        }
+
+        vkEndCommandBuffer(bench->command_buffer);
+    }
+    double elapsed = now_ms() - start;
+
+    vur_descriptor_buffer_destroy(&descriptors);
+    return elapsed;
+}
+
+int
+main(void)
+{
+    // Enumerations of the vut_ functions allocate their arrays from it
+    Arena arena;
+    vut_arena_init(64 * 1024, &arena);
+    vut_set_scratch_arena(&arena);
+
+    const VkApplicationInfo app_info = {
+        .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+        .pNext = NULL,
+        .pApplicationName = "descriptor_bench",
+        .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
+        .apiVersion = VK_API_VERSION_1_2,
+        .pEngineName = "No Engine",
+    };
+    const VkInstanceCreateInfo instance_info = {
+        .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .pApplicationInfo = &app_info,
+        .enabledExtensionCount = 0,
+        .ppEnabledExtensionNames = NULL,
+        .enabledLayerCount = 0,
+        .ppEnabledLayerNames = NULL,
+    };
+    VkInstance instance;
+    if (vkCreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the instance\n");
+        return EXIT_FAILURE;
+    }
+
+    uint32_t gpu_count;
+    vut_get_physical_devices(instance, &gpu_count, NULL);
+    VkPhysicalDevice* gpus = VUT_ARENA_ALLOC(&arena, VkPhysicalDevice, gpu_count);
+    vut_get_physical_devices(instance, &gpu_count, gpus);
+    VkPhysicalDevice gpu;
+    vut_pick_physical_device(gpus, gpu_count, &gpu);
+
+    DeviceFeatures features;
+    vut_query_device_features(gpu, &features);
+    if (!features.descriptor_buffer) {
+        fprintf(stderr, "VK_EXT_descriptor_buffer is not supported\n");
+        vkDestroyInstance(instance, NULL);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t queue_family_index = find_graphics_queue_family(gpu);
+    VkDevice device;
+    if (vut_init_device(gpu, queue_family_index, queue_family_index, 0, &features,
+                        &device) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the device\n");
+        return EXIT_FAILURE;
+    }
+
+    Bench bench;
+    bench_init(gpu, device, queue_family_index, false, &bench);
+    double sets_ms = bench_descriptor_sets(&bench);
+    bench_destroy(&bench);
+
+    bench_init(gpu, device, queue_family_index, true, &bench);
+    double buffer_ms = bench_descriptor_buffer(gpu, &bench);
+    bench_destroy(&bench);
+
+    const double draws = (double)DRAW_COUNT * ITERATIONS;
+    printf("%u draws x %u frames\n", DRAW_COUNT, ITERATIONS);
+    printf("descriptor sets:   %8.2f ms, %6.1f ns per draw\n", sets_ms,
+           sets_ms * 1000000.0 / draws);
+    printf("descriptor buffer: %8.2f ms, %6.1f ns per draw\n", buffer_ms,
+           buffer_ms * 1000000.0 / draws);
+
+    vkDestroyDevice(device, NULL);
+    vkDestroyInstance(instance, NULL);
+    vut_set_scratch_arena(NULL);
+    vut_arena_destroy(&arena);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file draw_sort_bench.c
+ * @brief Time the radix sort of draw keys against qsort and count the state changes left
+ * in a sorted and an unsorted draw list
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ * The draws get random passes, pipeline variants, materials, meshes and depths. State
+ * changes are counted the way vur_record_frame binds: a pipeline where the pass or variant
+ * changes. Materials and meshes are not bound, they are counted to show the grouping.
+ * Needs no GPU.
+ */
+
+#include "draw_sort.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DRAW_COUNT 100000
+#define ITERATIONS 100
+
+#define PIPELINE_COUNT 16
+#define MATERIAL_COUNT 256
+#define MESH_COUNT 64
+// One draw in this many is transparent
+#define TRANSPARENT_RATIO 8
+
+typedef struct
+{
+    uint32_t pass;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+    float depth;
+} Draw;
+
+typedef struct
+{
+    uint32_t pipeline_changes;
+    uint32_t material_changes;
+    uint32_t mesh_changes;
+} StateChanges;
+
+static double
+now_ms(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+static int
+compare_keys(const void* a, const void* b)
+{
+    uint64_t left = *(const uint64_t*)a;
+    uint64_t right = *(const uint64_t*)b;
+    return (left > right) - (left < right);
+}
+
+static StateChanges
+count_changes(const Draw draws[], const uint32_t order[])
+{
+    StateChanges changes = { 0 };
+    const Draw* previous = NULL;
+
+    for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+        const Draw* draw = &draws[order[i]];
+        if (previous == NULL || draw->pass != previous->pass ||
+            draw->pipeline != previous->pipeline) {
+            changes.pipeline_changes++;
+        }
+        if (previous == NULL || draw->material != previous->material) {
+            changes.material_changes++;
+        }
+        if (previous == NULL || draw->mesh != previous->mesh) {
+            changes.mesh_changes++;
+        }
+        previous = draw;
+    }
+
+    return changes;
+}
+
+static bool
+check(const Draw draws[], const uint64_t keys[], const uint32_t order[])
+{
+    for (uint32_t i = 1; i < DRAW_COUNT; i++) {
+        const Draw* previous = &draws[order[i - 1]];
+        const Draw* draw = &draws[order[i]];
+
+        if (keys[i - 1] > keys[i]) {
+            fprintf(stderr, "Keys %u and %u are out of order\n", i - 1, i);
+            return false;
+        }
+        if (previous->pass > draw->pass) {
+            fprintf(stderr, "Pass of draw %u is out of order\n", i);
+            return false;
+        }
+        if (previous->pass == VUR_PASS_TRANSPARENT && previous->depth < draw->depth * 0.99f) {
+            fprintf(stderr, "Transparent draw %u is not back to front\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int
+main(void)
+{
+    Draw* draws = malloc(DRAW_COUNT * sizeof(Draw));
+    uint64_t* draw_keys = malloc(DRAW_COUNT * sizeof(uint64_t));
+    uint64_t* keys = malloc(2 * DRAW_COUNT * sizeof(uint64_t));
+    uint32_t* order = malloc(2 * DRAW_COUNT * sizeof(uint32_t));
+    uint32_t* submitted = malloc(DRAW_COUNT * sizeof(uint32_t));
+
+    srand(1);
+    for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+        Draw* draw = &draws[i];
+        draw->pass = rand() % TRANSPARENT_RATIO ? VUR_PASS_OPAQUE : VUR_PASS_TRANSPARENT;
+        draw->pipeline = (uint32_t)rand() % PIPELINE_COUNT;
+        draw->material = (uint32_t)rand() % MATERIAL_COUNT;
+        draw->mesh = (uint32_t)rand() % MESH_COUNT;
+        draw->depth = 1000.0f * (float)rand() / (float)RAND_MAX;
+
+        draw_keys[i] = vur_draw_key(draw->pass, draw->pipeline, draw->material, draw->mesh,
+                                    draw->depth);
+        submitted[i] = i;
+    }
+
+    double radix_ms = now_ms();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        memcpy(keys, draw_keys, DRAW_COUNT * sizeof(uint64_t));
+        memcpy(order, submitted, DRAW_COUNT * sizeof(uint32_t));
+        vut_radix_sort(keys, order, DRAW_COUNT, keys + DRAW_COUNT, order + DRAW_COUNT);
+    }
+    radix_ms = (now_ms() - radix_ms) / ITERATIONS;
+
+    if (!check(draws, keys, order)) {
+        return EXIT_FAILURE;
+    }
+
+    // Only the keys, the indices would need a wider element
+    double qsort_ms = now_ms();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        memcpy(keys + DRAW_COUNT, draw_keys, DRAW_COUNT * sizeof(uint64_t));
+        qsort(keys + DRAW_COUNT, DRAW_COUNT, sizeof(uint64_t), compare_keys);
+    }
+    qsort_ms = (now_ms() - qsort_ms) / ITERATIONS;
+
+    if (memcmp(keys, keys + DRAW_COUNT, DRAW_COUNT * sizeof(uint64_t)) != 0) {
+        fprintf(stderr, "The radix sort and qsort disagree\n");
+        return EXIT_FAILURE;
+    }
+
+    StateChanges unsorted = count_changes(draws, submitted);
+    StateChanges sorted = count_changes(draws, order);
+
+    printf("%u draws\n", DRAW_COUNT);
+    printf("radix sort: %8.3f ms, %6.1f ns per draw\n", radix_ms,
+           radix_ms * 1000000.0 / DRAW_COUNT);
+    printf("qsort:      %8.3f ms, %6.1f ns per draw\n", qsort_ms,
+           qsort_ms * 1000000.0 / DRAW_COUNT);
+    printf("              unsorted    sorted\n");
+    printf("pipelines     %8u  %8u\n", unsorted.pipeline_changes, sorted.pipeline_changes);
+    printf("materials     %8u  %8u\n", unsorted.material_changes, sorted.material_changes);
+    printf("meshes        %8u  %8u\n", unsorted.mesh_changes, sorted.mesh_changes);
+
+    free(submitted);
+    free(order);
+    free(keys);
+    free(draw_keys);
+    free(draws);
+
+    return EXIT_SUCCESS;
+}
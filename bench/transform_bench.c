@@ -0,0 +1,166 @@
+/**
+ * @file transform_bench.c
+ * @brief Time the propagation of world matrices through a large transform hierarchy and
+ * check it against cglm
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ * A random hierarchy is built with children added after deeper nodes, so the first update
+ * also sorts. Timed are a full update and updates where a small part of the nodes moved.
+ * Build with and without -DVUR_USE_AVX2=ON to compare the kernels. Needs no GPU.
+ */
+
+#include "transform.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NODE_COUNT 100000
+#define ROOT_COUNT 100
+#define ITERATIONS 100
+
+// Nodes moved per iteration of the partial updates
+#define MOVED_COUNT (NODE_COUNT / 100)
+
+typedef struct
+{
+    vec3 position;
+    versor rotation;
+    vec3 scale;
+    uint32_t parent;
+    mat4 world;
+} Node;
+
+static double
+now_ms(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+static float
+random_float(float min, float max)
+{
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+// World matrices with cglm, parents have smaller handles than their children
+static void
+reference_update(Node nodes[])
+{
+    for (uint32_t i = 0; i < NODE_COUNT; i++) {
+        Node* node = &nodes[i];
+
+        mat4 local;
+        glm_translate_make(local, node->position);
+        glm_quat_rotate(local, node->rotation, local);
+        glm_scale(local, node->scale);
+
+        if (node->parent == VUT_TRANSFORM_ROOT) {
+            glm_mat4_copy(local, node->world);
+        } else {
+            glm_mat4_mul(nodes[node->parent].world, local, node->world);
+        }
+    }
+}
+
+static bool
+check(const TransformHierarchy* hierarchy, const Node nodes[])
+{
+    for (uint32_t i = 0; i < NODE_COUNT; i++) {
+        const TransformMatrix* world = &hierarchy->world[vut_transform_index(hierarchy, i)];
+        for (uint32_t r = 0; r < 3; r++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                // cglm matrices are column major
+                float expected = nodes[i].world[c][r];
+                if (fabsf(world->rows[r][c] - expected) > 1e-3f * (1.0f + fabsf(expected))) {
+                    fprintf(stderr, "Node %u [%u][%u] is %f instead of %f\n", i, r, c,
+                            world->rows[r][c], expected);
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+int
+main(void)
+{
+    Node* nodes = malloc(NODE_COUNT * sizeof(Node));
+    TransformHierarchy hierarchy;
+    vut_transform_hierarchy_init(NODE_COUNT, &hierarchy);
+
+    srand(1);
+    for (uint32_t i = 0; i < NODE_COUNT; i++) {
+        Node* node = &nodes[i];
+        node->parent = i < ROOT_COUNT ? VUT_TRANSFORM_ROOT : (uint32_t)rand() % i;
+        vut_transform_add(&hierarchy, node->parent);
+
+        // Keep the scale near one, so deep chains neither vanish nor explode
+        glm_vec3_copy((vec3){ random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f),
+                              random_float(-1.0f, 1.0f) },
+                      node->position);
+        glm_quatv(node->rotation, random_float(0.0f, GLM_PIf),
+                  (vec3){ random_float(-1.0f, 1.0f), 1.0f, random_float(-1.0f, 1.0f) });
+        glm_quat_normalize(node->rotation);
+        glm_vec3_fill(node->scale, random_float(0.95f, 1.05f));
+
+        vut_transform_set_position(&hierarchy, i, node->position);
+        vut_transform_set_rotation(&hierarchy, i, node->rotation);
+        vut_transform_set_scale(&hierarchy, i, node->scale);
+    }
+
+    double sort_ms = now_ms();
+    vut_transform_hierarchy_update(&hierarchy);
+    sort_ms = now_ms() - sort_ms;
+
+    reference_update(nodes);
+    if (!check(&hierarchy, nodes)) {
+        return EXIT_FAILURE;
+    }
+
+    // Every node dirty
+    double full_ms = now_ms();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        for (uint32_t r = 0; r < ROOT_COUNT; r++) {
+            vut_transform_set_position(&hierarchy, r, nodes[r].position);
+        }
+        vut_transform_hierarchy_update(&hierarchy);
+    }
+    full_ms = (now_ms() - full_ms) / ITERATIONS;
+
+    // A few nodes anywhere in the hierarchy move
+    double partial_ms = now_ms();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        for (uint32_t m = 0; m < MOVED_COUNT; m++) {
+            uint32_t handle = (uint32_t)rand() % NODE_COUNT;
+            nodes[handle].position[1] += 0.01f;
+            vut_transform_set_position(&hierarchy, handle, nodes[handle].position);
+        }
+        vut_transform_hierarchy_update(&hierarchy);
+    }
+    partial_ms = (now_ms() - partial_ms) / ITERATIONS;
+
+    reference_update(nodes);
+    if (!check(&hierarchy, nodes)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%u nodes in %u levels\n", NODE_COUNT, hierarchy.level_count);
+    printf("first update with sort: %8.3f ms\n", sort_ms);
+    printf("all nodes dirty:        %8.3f ms, %6.1f ns per node\n", full_ms,
+           full_ms * 1000000.0 / NODE_COUNT);
+    printf("%u nodes moved:       %8.3f ms\n", MOVED_COUNT, partial_ms);
+
+    vut_transform_hierarchy_destroy(&hierarchy);
+    free(nodes);
+
+    return EXIT_SUCCESS;
+}
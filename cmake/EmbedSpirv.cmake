@@ -0,0 +1,29 @@
+# Convert a SPIR-V binary into a C source file containing a uint32_t array
+#
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.c> -DSYMBOL=<name> -DSHADER=<source>
+#              -P EmbedSpirv.cmake
+
+file(READ "${INPUT}" hex HEX)
+
+string(LENGTH "${hex}" hex_length)
+math(EXPR remainder "${hex_length} % 8")
+if(hex_length EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary")
+endif()
+
+# SPIR-V is a stream of little endian 32 bit words. Swap every group of four
+# bytes so the words end up in host order on little endian machines.
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u," words "${hex}")
+
+# Put eight words on each line (CMake regexes have no {n} quantifier)
+set(word "0x[0-9a-f]+u,")
+string(REGEX REPLACE "(${word}${word}${word}${word}${word}${word}${word}${word})" "\\1\n    "
+       words "${words}")
+
+file(WRITE "${OUTPUT}"
+    "/* Generated from ${SHADER} by EmbedSpirv.cmake. Do not edit. */\n\n"
+    "#include <stddef.h>\n"
+    "#include <stdint.h>\n\n"
+    "const uint32_t ${SYMBOL}[] = {\n    ${words}\n};\n\n"
+    "const size_t ${SYMBOL}_size = sizeof(${SYMBOL});\n"
+)
@@ -0,0 +1,102 @@
+# Compile GLSL shaders to SPIR-V at build time and embed the result in a target
+#
+# Every shader is compiled with glslangValidator, optimized with spirv-opt (when
+# available) and converted to a `const uint32_t <name>_spv[]` array. A header
+# called shaders.h declaring all arrays is generated for the target.
+#
+# A shader given as `<file>@<DEFINE>` is compiled with DEFINE set and embedded as
+# `<name>_<define>_spv`, so one source can provide several variants.
+
+set(VUR_SHADERS_CMAKE_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+find_program(GLSLANG_VALIDATOR
+    NAMES glslangValidator
+    HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin"
+)
+find_program(SPIRV_OPT
+    NAMES spirv-opt
+    HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin"
+)
+
+if(NOT GLSLANG_VALIDATOR)
+    message(FATAL_ERROR "glslangValidator not found, it is required to compile the shaders")
+endif()
+
+if(NOT SPIRV_OPT)
+    message(STATUS "spirv-opt not found, shaders will be embedded without optimization")
+endif()
+
+function(vur_add_shaders target)
+    set(out_dir "${CMAKE_CURRENT_BINARY_DIR}/shaders")
+    file(MAKE_DIRECTORY "${out_dir}")
+
+    set(header "/* Generated by Shaders.cmake. Do not edit. */\n")
+    string(APPEND header "#ifndef SHADERS_H\n#define SHADERS_H\n\n")
+    string(APPEND header "#include <stddef.h>\n#include <stdint.h>\n\n")
+
+    foreach(entry ${ARGN})
+        string(REPLACE "@" ";" parts "${entry}")
+        list(GET parts 0 shader)
+        list(LENGTH parts part_count)
+
+        get_filename_component(name "${shader}" NAME)
+        set(defines "")
+        if(part_count GREATER 1)
+            list(GET parts 1 define)
+            string(TOLOWER "${define}" variant)
+            set(name "${name}_${variant}")
+            set(defines "-D${define}")
+        endif()
+        string(MAKE_C_IDENTIFIER "${name}_spv" symbol)
+
+        set(spv "${out_dir}/${name}.spv")
+        set(source "${out_dir}/${symbol}.c")
+
+        add_custom_command(
+            OUTPUT "${spv}"
+            COMMAND "${GLSLANG_VALIDATOR}" -V ${defines} -o "${spv}" "${shader}"
+            DEPENDS "${shader}"
+            COMMENT "Compiling shader ${name}"
+            VERBATIM
+        )
+
+        if(SPIRV_OPT)
+            set(embed_input "${out_dir}/${name}.opt.spv")
+            add_custom_command(
+                OUTPUT "${embed_input}"
+                COMMAND "${SPIRV_OPT}" -O "${spv}" -o "${embed_input}"
+                DEPENDS "${spv}"
+                COMMENT "Optimizing shader ${name}"
+                VERBATIM
+            )
+        else()
+            set(embed_input "${spv}")
+        endif()
+
+        add_custom_command(
+            OUTPUT "${source}"
+            COMMAND "${CMAKE_COMMAND}"
+                -DINPUT=${embed_input}
+                -DOUTPUT=${source}
+                -DSYMBOL=${symbol}
+                -DSHADER=${name}
+                -P "${VUR_SHADERS_CMAKE_DIR}/EmbedSpirv.cmake"
+            DEPENDS "${embed_input}" "${VUR_SHADERS_CMAKE_DIR}/EmbedSpirv.cmake"
+            COMMENT "Embedding shader ${name}"
+            VERBATIM
+        )
+
+        target_sources(${target} PRIVATE "${source}")
+
+        string(APPEND header "extern const uint32_t ${symbol}[];\n")
+        string(APPEND header "extern const size_t ${symbol}_size;\n\n")
+    endforeach()
+
+    string(APPEND header "#endif // SHADERS_H\n")
+
+    # Only touch the header when the shader list changed to avoid needless rebuilds
+    file(WRITE "${out_dir}/shaders.h.in" "${header}")
+    configure_file("${out_dir}/shaders.h.in" "${out_dir}/shaders.h" COPYONLY)
+
+    target_include_directories(${target} PRIVATE "${out_dir}")
+endfunction()
@@ -1,10 +1,66 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// Built twice, with BINDLESS for devices with descriptor indexing and without for the rest.
+// Without the arrays TEXTURED has no effect.
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+// Variant features, set per pipeline with specialization constants.
+// The ids must match the VUR_SPEC_* defines in pipeline.h.
+layout(constant_id = 0) const bool FOG = false;
+layout(constant_id = 1) const bool ALPHA_TEST = false;
+layout(constant_id = 2) const uint LIGHT_COUNT = 0;
+layout(constant_id = 4) const bool TEXTURED = false;
+
+#ifdef BINDLESS
+// Bindless arrays, indexed by material. Must match bindless.h. Material 0 has no texture
+// and sampler 0 is the default one, see VUR_BINDLESS_NONE.
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 1) uniform sampler samplers[];
+#endif
+
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUV;
+layout(location = 2) flat in uint fragMaterial;
 
 layout(location = 0) out vec4 outColor;
 
+const vec3 fogColor = vec3(0.5, 0.6, 0.7);
+const float alphaCutoff = 0.5;
+
+const vec3 lightColors[4] = vec3[](
+    vec3(1.0, 0.9, 0.8),
+    vec3(0.2, 0.3, 0.5),
+    vec3(0.4, 0.2, 0.1),
+    vec3(0.1, 0.4, 0.2)
+);
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
-}
\ No newline at end of file
+    vec3 color = fragColor;
+    float alpha = 1.0;
+
+#ifdef BINDLESS
+    if (TEXTURED && fragMaterial != 0) {
+        vec4 texel = texture(sampler2D(textures[nonuniformEXT(fragMaterial)], samplers[0]), fragUV);
+        color *= texel.rgb;
+        alpha = texel.a;
+    }
+#endif
+
+    // Without normals every light only adds an ambient term for now
+    for (uint i = 0; i < min(LIGHT_COUNT, 4u); i++) {
+        color += 0.1 * lightColors[i];
+    }
+
+    if (ALPHA_TEST && alpha < alphaCutoff) {
+        discard;
+    }
+
+    if (FOG) {
+        color = mix(color, fogColor, gl_FragCoord.z);
+    }
+
+    outColor = vec4(color, alpha);
+}
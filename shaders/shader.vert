@@ -1,7 +1,28 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// Per draw data comes from push constants, unless it is larger than the device allows.
+// Then it is read from a dynamic uniform buffer. The id must match
+// VUR_SPEC_DRAW_DATA_IN_BUFFER in pipeline.h.
+layout(constant_id = 3) const bool DRAW_DATA_IN_BUFFER = false;
+
+// Must match DrawData in renderer.h
+struct DrawData {
+    mat4 transform;
+    uint material;
+};
+
+layout(push_constant) uniform DrawConstants {
+    DrawData data;
+} drawConstants;
+
+layout(set = 0, binding = 0) uniform DrawBuffer {
+    DrawData data;
+} drawBuffer;
+
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragMaterial;
 
 vec2 positions[3] = vec2[](
     vec2(0.0, -0.5),
@@ -16,6 +37,10 @@ vec3 colors[3] = vec3[](
 );
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-}
\ No newline at end of file
+    DrawData draw = DRAW_DATA_IN_BUFFER ? drawBuffer.data : drawConstants.data;
+
+    gl_Position = draw.transform * vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    fragColor = colors[(gl_VertexIndex + draw.material) % 3];
+    fragUV = positions[gl_VertexIndex] + 0.5;
+    fragMaterial = draw.material;
+}
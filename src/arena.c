@@ -0,0 +1,75 @@
+/**
+ * @file arena.c
+ * @brief Linear allocator for temporary CPU side data, freed all at once
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void
+vut_arena_init(size_t size, Arena* arena)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->size = size;
+    arena->data = malloc(size);
+    if (arena->data == NULL) {
+        fprintf(stderr, "Failed to allocate an arena of %zu bytes\n", size);
+        abort();
+    }
+}
+
+void*
+vut_arena_alloc(Arena* arena, size_t size, size_t alignment)
+{
+    // The address is aligned, malloc only guarantees the alignment of max_align_t
+    uintptr_t base = (uintptr_t)arena->data;
+    size_t start = ((base + arena->head + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    if (start + size > arena->size) {
+        fprintf(stderr, "Arena of %zu bytes is out of memory, %zu bytes requested\n",
+                arena->size, size);
+        abort();
+    }
+
+    arena->head = start + size;
+    if (arena->head > arena->peak) {
+        arena->peak = arena->head;
+    }
+
+    return arena->data + start;
+}
+
+ArenaScope
+vut_arena_begin_scope(Arena* arena)
+{
+    return (ArenaScope){
+        .arena = arena,
+        .head = arena->head,
+    };
+}
+
+void
+vut_arena_end_scope(ArenaScope scope)
+{
+    scope.arena->head = scope.head;
+}
+
+void
+vut_arena_reset(Arena* arena)
+{
+    arena->head = 0;
+}
+
+void
+vut_arena_destroy(Arena* arena)
+{
+    free(arena->data);
+    memset(arena, 0, sizeof(*arena));
+}
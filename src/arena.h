@@ -0,0 +1,99 @@
+/**
+ * @file arena.h
+ * @brief Linear allocator for temporary CPU side data, freed all at once
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Memory of a fixed size that allocations are bumped from. Nothing is freed on its
+ * own, the arena is reset as a whole or rolled back to a scope. Not thread safe, every
+ * arena belongs to the thread that uses it.
+ */
+typedef struct
+{
+    uint8_t* data;
+    size_t size;
+    size_t head;
+
+    // The highest the head has been, to size the arena
+    size_t peak;
+} Arena;
+
+/**
+ * @brief A point in an arena to roll back to. Scopes must be ended in reverse order.
+ */
+typedef struct
+{
+    Arena* arena;
+    size_t head;
+} ArenaScope;
+
+// Allocate count elements of type, aligned for that type
+#define VUT_ARENA_ALLOC(arena, type, count)                                                       \
+    ((type*)vut_arena_alloc((arena), (count) * sizeof(type), _Alignof(type)))
+
+/**
+ * @brief Allocate the memory of an arena
+ *
+ * @param[in] size Capacity in bytes, the arena never grows
+ * @param[out] arena The arena
+ */
+void
+vut_arena_init(size_t size, Arena* arena);
+
+/**
+ * @brief Allocate from the arena. Running out of space is a sizing bug and aborts.
+ *
+ * @param[in] arena The arena
+ * @param[in] size Size in bytes
+ * @param[in] alignment Power of two alignment of the allocation
+ * @return void* The memory, uninitialized
+ */
+void*
+vut_arena_alloc(Arena* arena, size_t size, size_t alignment);
+
+/**
+ * @brief Remember the current head, everything allocated after it is freed by
+ * vut_arena_end_scope
+ *
+ * @param[in] arena The arena
+ * @return ArenaScope The scope
+ */
+ArenaScope
+vut_arena_begin_scope(Arena* arena);
+
+/**
+ * @brief Free everything allocated since the scope began
+ *
+ * @param[in] scope The scope returned by vut_arena_begin_scope
+ */
+void
+vut_arena_end_scope(ArenaScope scope);
+
+/**
+ * @brief Free every allocation in the arena
+ *
+ * @param[in] arena The arena
+ */
+void
+vut_arena_reset(Arena* arena);
+
+/**
+ * @brief Free the memory of the arena
+ *
+ * @param[in] arena The arena
+ */
+void
+vut_arena_destroy(Arena* arena);
+
+#endif // ARENA_H
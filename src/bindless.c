@@ -0,0 +1,303 @@
+/**
+ * @file bindless.c
+ * @brief One global descriptor set with large arrays of textures, samplers and buffers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "bindless.h"
+#include "vk_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const VkDescriptorType bindless_types[VUR_BINDLESS_BINDING_COUNT] = {
+    [VUR_BINDLESS_TEXTURE_BINDING] = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    [VUR_BINDLESS_SAMPLER_BINDING] = VK_DESCRIPTOR_TYPE_SAMPLER,
+    [VUR_BINDLESS_BUFFER_BINDING] = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+};
+
+static uint32_t
+min_u32(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+static uint32_t
+bindless_alloc(BindlessTable* table, uint32_t binding)
+{
+    BindlessArray* array = &table->arrays[binding];
+
+    uint32_t index;
+    if (array->free_count) {
+        index = array->free_slots[--array->free_count];
+    } else if (array->count < array->capacity) {
+        index = array->count++;
+    } else {
+        return VUR_BINDLESS_INVALID;
+    }
+
+    array->used[index / 32] |= 1u << (index % 32);
+    return index;
+}
+
+static void
+bindless_write(BindlessTable* table,
+               uint32_t binding,
+               uint32_t index,
+               const VkDescriptorImageInfo* image_info,
+               const VkDescriptorBufferInfo* buffer_info)
+{
+    if (table->use_descriptor_buffer) {
+        size_t descriptor_size =
+            vur_descriptor_buffer_descriptor_size(&table->descriptors, bindless_types[binding]);
+        VkDeviceSize offset =
+            table->set_offset + table->binding_offsets[binding] + index * descriptor_size;
+
+        if (buffer_info) {
+            VkDeviceAddress address = vut_get_buffer_address(table->device, buffer_info->buffer);
+            vur_descriptor_buffer_write_buffer(&table->descriptors, offset, bindless_types[binding],
+                                               address + buffer_info->offset, buffer_info->range);
+        } else {
+            vur_descriptor_buffer_write_image(&table->descriptors, offset, bindless_types[binding],
+                                              image_info);
+        }
+        return;
+    }
+
+    const VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = NULL,
+        .dstSet = table->descriptor_set,
+        .dstBinding = binding,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = bindless_types[binding],
+        .pImageInfo = image_info,
+        .pBufferInfo = buffer_info,
+        .pTexelBufferView = NULL,
+    };
+
+    vkUpdateDescriptorSets(table->device, 1, &write, 0, NULL);
+}
+
+// Take the VUR_BINDLESS_NONE slot of every array and put the default sampler in its slot
+static VkResult
+bindless_write_defaults(BindlessTable* table)
+{
+    for (uint32_t i = 0; i < VUR_BINDLESS_BINDING_COUNT; i++) {
+        if (bindless_alloc(table, i) != VUR_BINDLESS_NONE) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    const VkSamplerCreateInfo sampler_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .maxLod = VK_LOD_CLAMP_NONE,
+    };
+    VkResult result =
+        vkCreateSampler(table->device, &sampler_info, vut_get_allocator(), &table->default_sampler);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    const VkDescriptorImageInfo image_info = {
+        .sampler = table->default_sampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    bindless_write(table, VUR_BINDLESS_SAMPLER_BINDING, VUR_BINDLESS_NONE, &image_info, NULL);
+
+    return VK_SUCCESS;
+}
+
+VkResult
+vur_bindless_init(VkDevice device,
+                  VkPhysicalDevice gpu,
+                  LayoutCache* layout_cache,
+                  const uint32_t capacities[VUR_BINDLESS_BINDING_COUNT],
+                  BindlessTable* table)
+{
+    memset(table, 0, sizeof(*table));
+    table->device = device;
+
+    // Every array counts against both the per stage and the per set limits
+    VkPhysicalDeviceDescriptorIndexingProperties limits;
+    vut_get_descriptor_indexing_properties(gpu, &limits);
+
+    const uint32_t max_counts[VUR_BINDLESS_BINDING_COUNT] = {
+        [VUR_BINDLESS_TEXTURE_BINDING] =
+            min_u32(limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                    limits.maxDescriptorSetUpdateAfterBindSampledImages),
+        [VUR_BINDLESS_SAMPLER_BINDING] =
+            min_u32(limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+                    limits.maxDescriptorSetUpdateAfterBindSamplers),
+        [VUR_BINDLESS_BUFFER_BINDING] =
+            min_u32(limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                    limits.maxDescriptorSetUpdateAfterBindStorageBuffers),
+    };
+
+    VkDescriptorPoolSize pool_sizes[VUR_BINDLESS_BINDING_COUNT];
+    for (uint32_t i = 0; i < VUR_BINDLESS_BINDING_COUNT; i++) {
+        uint32_t capacity = min_u32(capacities[i], max_counts[i]);
+
+        table->arrays[i].capacity = capacity;
+        table->arrays[i].free_slots = malloc(capacity * sizeof(uint32_t));
+        table->arrays[i].used = calloc((capacity + 31) / 32, sizeof(uint32_t));
+        if (table->arrays[i].free_slots == NULL || table->arrays[i].used == NULL) {
+            vur_bindless_destroy(table);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
+        // Compute shaders index the same arrays, so every stage sees the set
+        table->set.bindings[i] = (VkDescriptorSetLayoutBinding){
+            .binding = i,
+            .descriptorType = bindless_types[i],
+            .descriptorCount = capacity,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .pImmutableSamplers = NULL,
+        };
+
+        pool_sizes[i] = (VkDescriptorPoolSize){
+            .type = bindless_types[i],
+            .descriptorCount = capacity,
+        };
+    }
+    table->set.binding_count = VUR_BINDLESS_BINDING_COUNT;
+    table->set.unsized = true;
+
+    VkResult result = vut_layout_cache_get_set_layout(layout_cache, &table->set, &table->layout);
+    if (result == VK_SUCCESS && layout_cache->descriptor_buffer) {
+        // The set is the only one in its descriptor buffer and never moves
+        table->use_descriptor_buffer = true;
+        VkDeviceSize set_size = vut_get_descriptor_set_layout_size(device, table->layout);
+        for (uint32_t i = 0; i < VUR_BINDLESS_BINDING_COUNT; i++) {
+            table->binding_offsets[i] = vut_get_descriptor_binding_offset(device, table->layout, i);
+        }
+
+        result = vur_descriptor_buffer_init(device, gpu, set_size, &table->descriptors);
+        if (result == VK_SUCCESS) {
+            result = vur_descriptor_buffer_alloc(&table->descriptors, set_size, &table->set_offset);
+        }
+    } else if (result == VK_SUCCESS) {
+        result = vut_init_descriptor_pool(device, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+                                          1, VUR_BINDLESS_BINDING_COUNT, pool_sizes, &table->pool);
+        if (result == VK_SUCCESS) {
+            result = vut_alloc_descriptor_set(device, table->pool, table->layout,
+                                              &table->descriptor_set);
+        }
+    }
+
+    if (result == VK_SUCCESS) {
+        result = bindless_write_defaults(table);
+    }
+
+    if (result != VK_SUCCESS) {
+        vur_bindless_destroy(table);
+    }
+
+    return result;
+}
+
+uint32_t
+vur_bindless_add_texture(BindlessTable* table, VkImageView view, VkImageLayout layout)
+{
+    uint32_t index = bindless_alloc(table, VUR_BINDLESS_TEXTURE_BINDING);
+    if (index == VUR_BINDLESS_INVALID) {
+        return index;
+    }
+
+    const VkDescriptorImageInfo image_info = {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = view,
+        .imageLayout = layout,
+    };
+    bindless_write(table, VUR_BINDLESS_TEXTURE_BINDING, index, &image_info, NULL);
+
+    return index;
+}
+
+uint32_t
+vur_bindless_add_sampler(BindlessTable* table, VkSampler sampler)
+{
+    uint32_t index = bindless_alloc(table, VUR_BINDLESS_SAMPLER_BINDING);
+    if (index == VUR_BINDLESS_INVALID) {
+        return index;
+    }
+
+    const VkDescriptorImageInfo image_info = {
+        .sampler = sampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    bindless_write(table, VUR_BINDLESS_SAMPLER_BINDING, index, &image_info, NULL);
+
+    return index;
+}
+
+uint32_t
+vur_bindless_add_buffer(BindlessTable* table,
+                        VkBuffer buffer,
+                        VkDeviceSize offset,
+                        VkDeviceSize range)
+{
+    uint32_t index = bindless_alloc(table, VUR_BINDLESS_BUFFER_BINDING);
+    if (index == VUR_BINDLESS_INVALID) {
+        return index;
+    }
+
+    const VkDescriptorBufferInfo buffer_info = {
+        .buffer = buffer,
+        .offset = offset,
+        .range = range,
+    };
+    bindless_write(table, VUR_BINDLESS_BUFFER_BINDING, index, NULL, &buffer_info);
+
+    return index;
+}
+
+bool
+vur_bindless_remove(BindlessTable* table, uint32_t binding, uint32_t index)
+{
+    if (binding >= VUR_BINDLESS_BINDING_COUNT) {
+        return false;
+    }
+
+    // The reserved slot is never released, a slot released twice would be handed out twice
+    BindlessArray* array = &table->arrays[binding];
+    if (index == VUR_BINDLESS_NONE || index >= array->count ||
+        !(array->used[index / 32] & (1u << (index % 32)))) {
+        return false;
+    }
+
+    // The descriptor stays written, partially bound sets allow stale slots nobody reads
+    array->used[index / 32] &= ~(1u << (index % 32));
+    array->free_slots[array->free_count++] = index;
+    return true;
+}
+
+void
+vur_bindless_destroy(BindlessTable* table)
+{
+    vkDestroyDescriptorPool(table->device, table->pool, vut_get_allocator());
+    vkDestroySampler(table->device, table->default_sampler, vut_get_allocator());
+    if (table->use_descriptor_buffer) {
+        vur_descriptor_buffer_destroy(&table->descriptors);
+    }
+
+    for (uint32_t i = 0; i < VUR_BINDLESS_BINDING_COUNT; i++) {
+        free(table->arrays[i].free_slots);
+        free(table->arrays[i].used);
+    }
+
+    memset(table, 0, sizeof(*table));
+}
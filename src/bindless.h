@@ -0,0 +1,150 @@
+/**
+ * @file bindless.h
+ * @brief One global descriptor set with large arrays of textures, samplers and buffers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef BINDLESS_H
+#define BINDLESS_H
+
+#include "descriptor_buffer.h"
+#include "layout_cache.h"
+
+// Set and bindings of the arrays, must match the bindless declarations in the shaders
+#define VUR_BINDLESS_SET 1
+#define VUR_BINDLESS_TEXTURE_BINDING 0
+#define VUR_BINDLESS_SAMPLER_BINDING 1
+#define VUR_BINDLESS_BUFFER_BINDING 2
+#define VUR_BINDLESS_BINDING_COUNT 3
+
+#define VUR_BINDLESS_INVALID UINT32_MAX
+
+// Slot 0 of every array is reserved. Material 0 samples no texture, and sampler 0 is a
+// linear repeating sampler written at init, so the shaders never read an unwritten slot.
+#define VUR_BINDLESS_NONE 0
+
+/**
+ * @brief Slots of one array in the table. Removed slots are reused before new ones.
+ */
+typedef struct
+{
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t free_count;
+    uint32_t* free_slots;
+    // A bit per slot, set while the slot is handed out
+    uint32_t* used;
+} BindlessArray;
+
+/**
+ * @brief A single update after bind descriptor set that stays bound for the whole frame.
+ * Shaders index the arrays with the material of a draw, so draws never bind descriptors.
+ * Slots may be written while the set is in use by frames in flight, as long as those
+ * frames do not read the written slots. When the layout cache uses descriptor buffers the
+ * set lives in a descriptor buffer instead of a pool.
+ */
+typedef struct
+{
+    VkDevice device;
+
+    // The interface every program with a VUR_BINDLESS_SET shares
+    ReflectedSet set;
+
+    VkDescriptorSetLayout layout;
+    VkDescriptorPool pool;
+    VkDescriptorSet descriptor_set;
+
+    // Descriptor buffer backend
+    bool use_descriptor_buffer;
+    DescriptorBuffer descriptors;
+    VkDeviceSize set_offset;
+    VkDeviceSize binding_offsets[VUR_BINDLESS_BINDING_COUNT];
+
+    BindlessArray arrays[VUR_BINDLESS_BINDING_COUNT];
+
+    // In the VUR_BINDLESS_NONE slot of the sampler array
+    VkSampler default_sampler;
+} BindlessTable;
+
+/**
+ * @brief Create the descriptor set. The capacities are clamped to the update after bind
+ * limits of the device, which must support descriptor indexing. Also creates the default
+ * sampler.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] gpu The physical device the limits are read from
+ * @param[in] layout_cache Cache that owns the set layout
+ * @param[in] capacities Wanted size of each array, indexed by binding
+ * @param[out] table The table
+ * @return VkResult
+ */
+VkResult
+vur_bindless_init(VkDevice device,
+                  VkPhysicalDevice gpu,
+                  LayoutCache* layout_cache,
+                  const uint32_t capacities[VUR_BINDLESS_BINDING_COUNT],
+                  BindlessTable* table);
+
+/**
+ * @brief Write a sampled image into a free slot of the texture array
+ *
+ * @param[in] table The table
+ * @param[in] view The image view
+ * @param[in] layout The layout the image is in when it is sampled
+ * @return uint32_t The index for the shaders, VUR_BINDLESS_INVALID when the array is full
+ */
+uint32_t
+vur_bindless_add_texture(BindlessTable* table, VkImageView view, VkImageLayout layout);
+
+/**
+ * @brief Write a sampler into a free slot of the sampler array
+ *
+ * @param[in] table The table
+ * @param[in] sampler The sampler
+ * @return uint32_t The index for the shaders, VUR_BINDLESS_INVALID when the array is full
+ */
+uint32_t
+vur_bindless_add_sampler(BindlessTable* table, VkSampler sampler);
+
+/**
+ * @brief Write a storage buffer range into a free slot of the buffer array
+ *
+ * @param[in] table The table
+ * @param[in] buffer The buffer. With descriptor buffers it must have been created with
+ * VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+ * @param[in] offset Start of the range
+ * @param[in] range Size of the range, VK_WHOLE_SIZE is not allowed with descriptor buffers
+ * @return uint32_t The index for the shaders, VUR_BINDLESS_INVALID when the array is full
+ */
+uint32_t
+vur_bindless_add_buffer(BindlessTable* table,
+                        VkBuffer buffer,
+                        VkDeviceSize offset,
+                        VkDeviceSize range);
+
+/**
+ * @brief Release a slot so it can be reused. No frame in flight may still read it.
+ *
+ * @param[in] table The table
+ * @param[in] binding The VUR_BINDLESS_*_BINDING of the array
+ * @param[in] index The index returned when the descriptor was added
+ * @return true The slot was in use and is free now, false for VUR_BINDLESS_NONE, indices
+ * out of range and slots that are already free
+ */
+bool
+vur_bindless_remove(BindlessTable* table, uint32_t binding, uint32_t index);
+
+/**
+ * @brief Destroy the descriptor pool or buffer and the default sampler. The set layout is
+ * owned by the layout cache.
+ *
+ * @param[in] table The table
+ */
+void
+vur_bindless_destroy(BindlessTable* table);
+
+#endif // BINDLESS_H
@@ -0,0 +1,402 @@
+/**
+ * @file capture.c
+ * @brief Write rendered frames to numbered image files on worker threads
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "capture.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stored deflate blocks hold at most this many bytes
+#define DEFLATE_BLOCK_SIZE 65535
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void
+crc_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (uint32_t k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t
+crc_update(uint32_t crc, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint8_t*
+put_u32_be(uint8_t* out, uint32_t value)
+{
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+    return out + 4;
+}
+
+// Writes length, type and data of a chunk and returns the end, where the CRC goes
+static uint8_t*
+png_chunk(uint8_t* out, const char type[4], const uint8_t* data, uint32_t size)
+{
+    uint8_t* start = out + 4;
+    out = put_u32_be(out, size);
+    memcpy(out, type, 4);
+    if (size > 0 && data != out + 4) {
+        memmove(out + 4, data, size);
+    }
+    out += 4 + size;
+    return put_u32_be(out, crc_update(0xFFFFFFFFu, start, size + 4) ^ 0xFFFFFFFFu);
+}
+
+// Converts the texels to rows of RGB, each row starts with its PNG filter when filtered
+static void
+capture_to_rgb(const FrameCapture* capture,
+               const CaptureSlot* slot,
+               bool filtered,
+               uint8_t* out)
+{
+    const uint32_t red = capture->bgra ? 2 : 0;
+    const uint32_t blue = capture->bgra ? 0 : 2;
+    for (uint32_t y = 0; y < slot->height; y++) {
+        const uint8_t* texel = slot->pixels + (size_t)y * slot->width * 4;
+        if (filtered) {
+            *out++ = 0;
+        }
+        for (uint32_t x = 0; x < slot->width; x++, texel += 4) {
+            *out++ = texel[red];
+            *out++ = texel[1];
+            *out++ = texel[blue];
+        }
+    }
+}
+
+// Uncompressed PNG, the encoder stays cheap enough to keep up with the GPU
+static size_t
+capture_encode_png(const FrameCapture* capture, const CaptureSlot* slot, uint8_t* out)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t* start = out;
+    memcpy(out, signature, sizeof(signature));
+    out += sizeof(signature);
+
+    uint8_t header[13];
+    put_u32_be(header, slot->width);
+    put_u32_be(header + 4, slot->height);
+    header[8] = 8;  // Bit depth
+    header[9] = 2;  // RGB
+    header[10] = 0; // Deflate
+    header[11] = 0; // Adaptive filtering
+    header[12] = 0; // No interlace
+    out = png_chunk(out, "IHDR", header, sizeof(header));
+
+    // The image data is built in place behind the chunk header
+    size_t raw_size = (size_t)slot->height * (1 + (size_t)slot->width * 3);
+    size_t block_count = (raw_size + DEFLATE_BLOCK_SIZE - 1) / DEFLATE_BLOCK_SIZE;
+    uint8_t* raw = out + 8 + 2 + block_count * 5;
+    capture_to_rgb(capture, slot, true, raw);
+
+    uint8_t* data = out + 8;
+    uint8_t* zlib = data;
+    *zlib++ = 0x78;
+    *zlib++ = 0x01;
+
+    uint32_t a = 1, b = 0;
+    for (size_t offset = 0; offset < raw_size; offset += DEFLATE_BLOCK_SIZE) {
+        uint16_t size = raw_size - offset < DEFLATE_BLOCK_SIZE ? raw_size - offset
+                                                               : DEFLATE_BLOCK_SIZE;
+        *zlib++ = offset + size == raw_size ? 1 : 0;
+        *zlib++ = size & 0xFF;
+        *zlib++ = size >> 8;
+        *zlib++ = ~size & 0xFF;
+        *zlib++ = (uint16_t)~size >> 8;
+
+        // The block headers are as large as the gap in front of the raw data
+        memmove(zlib, raw + offset, size);
+        for (uint16_t i = 0; i < size; i++) {
+            a = (a + zlib[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        zlib += size;
+    }
+    zlib = put_u32_be(zlib, (b << 16) | a);
+
+    out = png_chunk(out, "IDAT", data, zlib - data);
+    out = png_chunk(out, "IEND", NULL, 0);
+
+    return out - start;
+}
+
+static size_t
+capture_encoded_size(const FrameCapture* capture, const CaptureSlot* slot)
+{
+    size_t texels = (size_t)slot->width * slot->height;
+    switch (capture->format) {
+    case VUR_CAPTURE_PPM:
+        return texels * 3;
+    case VUR_CAPTURE_PNG: {
+        size_t raw_size = (size_t)slot->height * (1 + (size_t)slot->width * 3);
+        size_t block_count = (raw_size + DEFLATE_BLOCK_SIZE - 1) / DEFLATE_BLOCK_SIZE;
+        // Signature, IHDR, IDAT with the zlib header, blocks and checksum, and IEND
+        return 8 + 25 + 12 + 2 + block_count * 5 + raw_size + 4 + 12;
+    }
+    case VUR_CAPTURE_RAW:
+    default:
+        return texels * 4;
+    }
+}
+
+static bool
+capture_write(const FrameCapture* capture,
+              const CaptureSlot* slot,
+              uint8_t** scratch,
+              size_t* scratch_size)
+{
+    static const char* extensions[] = {
+        [VUR_CAPTURE_PPM] = "ppm",
+        [VUR_CAPTURE_PNG] = "png",
+        [VUR_CAPTURE_RAW] = "raw",
+    };
+
+    size_t size = capture_encoded_size(capture, slot);
+    if (size > *scratch_size) {
+        uint8_t* grown = realloc(*scratch, size);
+        if (grown == NULL) {
+            fprintf(stderr, "Failed to allocate %zu bytes to encode a capture\n", size);
+            return false;
+        }
+        *scratch = grown;
+        *scratch_size = size;
+    }
+
+    const uint8_t* data = *scratch;
+    switch (capture->format) {
+    case VUR_CAPTURE_PPM:
+        capture_to_rgb(capture, slot, false, *scratch);
+        break;
+    case VUR_CAPTURE_PNG:
+        size = capture_encode_png(capture, slot, *scratch);
+        break;
+    case VUR_CAPTURE_RAW:
+        if (capture->bgra) {
+            for (size_t i = 0; i < size; i += 4) {
+                (*scratch)[i] = slot->pixels[i + 2];
+                (*scratch)[i + 1] = slot->pixels[i + 1];
+                (*scratch)[i + 2] = slot->pixels[i];
+                (*scratch)[i + 3] = slot->pixels[i + 3];
+            }
+        } else {
+            data = slot->pixels;
+        }
+        break;
+    }
+
+    char path[VUR_MAX_CAPTURE_PATH + 32];
+    snprintf(path, sizeof(path), "%s%06" PRIu64 ".%s", capture->prefix, slot->frame,
+             extensions[capture->format]);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s for the capture\n", path);
+        return false;
+    }
+
+    bool written = true;
+    if (capture->format == VUR_CAPTURE_PPM) {
+        written = fprintf(file, "P6\n%u %u\n255\n", slot->width, slot->height) > 0;
+    }
+    written = written && fwrite(data, 1, size, file) == size;
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        fprintf(stderr, "Failed to write %s\n", path);
+    }
+
+    return written;
+}
+
+static void*
+capture_worker(void* data)
+{
+    FrameCapture* capture = data;
+
+    // Encoded files are built here before they are written in one go
+    uint8_t* scratch = NULL;
+    size_t scratch_size = 0;
+
+    pthread_mutex_lock(&capture->mutex);
+    for (;;) {
+        while (capture->queue_count == 0 && !capture->quit) {
+            pthread_cond_wait(&capture->slot_ready, &capture->mutex);
+        }
+        if (capture->queue_count == 0) {
+            // Quitting and nothing left to write
+            break;
+        }
+
+        CaptureSlot* slot = &capture->slots[capture->queue[capture->queue_head]];
+        capture->queue_head = (capture->queue_head + 1) % VUR_MAX_CAPTURE_SLOTS;
+        capture->queue_count--;
+
+        // The slot belongs to this worker until it is marked free
+        pthread_mutex_unlock(&capture->mutex);
+        bool written = capture_write(capture, slot, &scratch, &scratch_size);
+        pthread_mutex_lock(&capture->mutex);
+
+        if (written) {
+            capture->written++;
+        } else {
+            capture->failed++;
+        }
+        slot->state = CAPTURE_SLOT_FREE;
+        pthread_cond_signal(&capture->slot_free);
+    }
+    pthread_mutex_unlock(&capture->mutex);
+
+    free(scratch);
+    return NULL;
+}
+
+bool
+vur_capture_init(const char prefix[],
+                 CaptureFormat format,
+                 bool bgra,
+                 uint32_t slot_count,
+                 uint32_t thread_count,
+                 FrameCapture* capture)
+{
+    memset(capture, 0, sizeof(*capture));
+    snprintf(capture->prefix, sizeof(capture->prefix), "%s", prefix);
+    capture->format = format;
+    capture->bgra = bgra;
+    capture->slot_count = slot_count < VUR_MAX_CAPTURE_SLOTS ? slot_count : VUR_MAX_CAPTURE_SLOTS;
+    pthread_once(&crc_once, crc_init);
+
+    pthread_mutex_init(&capture->mutex, NULL);
+    pthread_cond_init(&capture->slot_ready, NULL);
+    pthread_cond_init(&capture->slot_free, NULL);
+
+    if (thread_count > VUR_MAX_CAPTURE_THREADS) {
+        thread_count = VUR_MAX_CAPTURE_THREADS;
+    }
+    for (uint32_t i = 0; i < thread_count; i++) {
+        if (pthread_create(&capture->threads[i], NULL, capture_worker, capture) != 0) {
+            break;
+        }
+        capture->thread_count++;
+    }
+
+    if (capture->thread_count == 0) {
+        vur_capture_destroy(capture);
+        return false;
+    }
+
+    return true;
+}
+
+CaptureSlot*
+vur_capture_acquire(FrameCapture* capture, uint32_t width, uint32_t height)
+{
+    CaptureSlot* slot = NULL;
+
+    pthread_mutex_lock(&capture->mutex);
+    while (slot == NULL) {
+        bool encoding = false;
+        for (uint32_t i = 0; i < capture->slot_count; i++) {
+            if (capture->slots[i].state == CAPTURE_SLOT_FREE) {
+                slot = &capture->slots[i];
+                break;
+            }
+            encoding |= capture->slots[i].state == CAPTURE_SLOT_ENCODING;
+        }
+        if (slot != NULL) {
+            break;
+        }
+
+        // Slots still READING are only completed by this thread, waiting on them never ends
+        if (!encoding) {
+            pthread_mutex_unlock(&capture->mutex);
+            return NULL;
+        }
+        pthread_cond_wait(&capture->slot_free, &capture->mutex);
+    }
+    slot->state = CAPTURE_SLOT_READING;
+    slot->frame = capture->next_frame++;
+    pthread_mutex_unlock(&capture->mutex);
+
+    // Slots only grow, a resize to a smaller window reuses the memory
+    size_t size = (size_t)width * height * 4;
+    if (size > slot->capacity) {
+        uint8_t* pixels = realloc(slot->pixels, size);
+        if (pixels == NULL) {
+            vur_capture_release(capture, slot);
+            return NULL;
+        }
+        slot->pixels = pixels;
+        slot->capacity = size;
+    }
+    slot->width = width;
+    slot->height = height;
+
+    return slot;
+}
+
+void
+vur_capture_submit(FrameCapture* capture, CaptureSlot* slot)
+{
+    pthread_mutex_lock(&capture->mutex);
+    uint32_t tail = (capture->queue_head + capture->queue_count) % VUR_MAX_CAPTURE_SLOTS;
+    capture->queue[tail] = (uint32_t)(slot - capture->slots);
+    capture->queue_count++;
+    slot->state = CAPTURE_SLOT_ENCODING;
+    pthread_cond_signal(&capture->slot_ready);
+    pthread_mutex_unlock(&capture->mutex);
+}
+
+void
+vur_capture_release(FrameCapture* capture, CaptureSlot* slot)
+{
+    pthread_mutex_lock(&capture->mutex);
+    slot->state = CAPTURE_SLOT_FREE;
+    pthread_cond_signal(&capture->slot_free);
+    pthread_mutex_unlock(&capture->mutex);
+}
+
+void
+vur_capture_destroy(FrameCapture* capture)
+{
+    pthread_mutex_lock(&capture->mutex);
+    capture->quit = true;
+    pthread_cond_broadcast(&capture->slot_ready);
+    pthread_mutex_unlock(&capture->mutex);
+
+    for (uint32_t i = 0; i < capture->thread_count; i++) {
+        pthread_join(capture->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&capture->slot_free);
+    pthread_cond_destroy(&capture->slot_ready);
+    pthread_mutex_destroy(&capture->mutex);
+
+    for (uint32_t i = 0; i < VUR_MAX_CAPTURE_SLOTS; i++) {
+        free(capture->slots[i].pixels);
+    }
+
+    memset(capture, 0, sizeof(*capture));
+}
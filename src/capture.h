@@ -0,0 +1,154 @@
+/**
+ * @file capture.h
+ * @brief Write rendered frames to numbered image files on worker threads
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VUR_MAX_CAPTURE_THREADS 8
+#define VUR_MAX_CAPTURE_SLOTS 16
+#define VUR_MAX_CAPTURE_PATH 256
+
+/**
+ * @brief File format of the captured frames. Every format stores 8 bit RGB, except raw
+ * which stores the tightly packed RGBA texels without a header.
+ */
+typedef enum
+{
+    VUR_CAPTURE_PPM,
+    VUR_CAPTURE_PNG,
+    VUR_CAPTURE_RAW,
+} CaptureFormat;
+
+typedef enum
+{
+    // Free to receive the next frame
+    CAPTURE_SLOT_FREE,
+    // The GPU copy of the frame is in flight
+    CAPTURE_SLOT_READING,
+    // Queued for or being written by a worker
+    CAPTURE_SLOT_ENCODING,
+} CaptureSlotState;
+
+/**
+ * @brief CPU memory that one frame is read back into and encoded from
+ */
+typedef struct
+{
+    CaptureSlotState state;
+    uint64_t frame;
+    uint32_t width;
+    uint32_t height;
+    size_t capacity;
+    uint8_t* pixels;
+} CaptureSlot;
+
+/**
+ * @brief A ring of slots that frames move through in three stages: the GPU copies a frame
+ * into a slot, the slot waits for the fence of its frame, then a worker encodes it and
+ * writes the file. Every stage works on a different frame, so throughput is bounded by the
+ * slowest stage. When every slot is busy the renderer waits for a worker, no frame is dropped.
+ */
+typedef struct
+{
+    char prefix[VUR_MAX_CAPTURE_PATH];
+    CaptureFormat format;
+    // The texels are B8G8R8A8 instead of R8G8B8A8
+    bool bgra;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t slot_ready;
+    pthread_cond_t slot_free;
+    bool quit;
+
+    uint32_t slot_count;
+    CaptureSlot slots[VUR_MAX_CAPTURE_SLOTS];
+
+    // Slots in the order their frames finished, workers take the oldest
+    uint32_t queue[VUR_MAX_CAPTURE_SLOTS];
+    uint32_t queue_head;
+    uint32_t queue_count;
+
+    uint32_t thread_count;
+    pthread_t threads[VUR_MAX_CAPTURE_THREADS];
+
+    uint64_t next_frame;
+    uint64_t written;
+    uint64_t failed;
+} FrameCapture;
+
+/**
+ * @brief Start the workers. Frames are written to the prefix followed by the six digit
+ * frame number and the extension of the format, like prefix000042.png.
+ *
+ * @param[in] prefix Path and start of the file names, the directory must exist
+ * @param[in] format File format
+ * @param[in] bgra The frames are B8G8R8A8 instead of R8G8B8A8
+ * @param[in] slot_count Amount of frames that can be in the pipeline, more than the amount
+ * of frames in flight plus the thread count keeps every stage busy
+ * @param[in] thread_count Amount of encoding threads
+ * @param[out] capture The capture
+ * @return true The workers have started
+ */
+bool
+vur_capture_init(const char prefix[],
+                 CaptureFormat format,
+                 bool bgra,
+                 uint32_t slot_count,
+                 uint32_t thread_count,
+                 FrameCapture* capture);
+
+/**
+ * @brief Get a free slot for the next frame, waiting for a worker to finish one when all
+ * are busy. Slots still being read are completed by the calling thread, so when no slot is
+ * being encoded it can not wait. Keep the slot count above the frames in flight. Only call
+ * from the thread that records frames.
+ *
+ * @param[in] capture The capture
+ * @param[in] width Width of the frame
+ * @param[in] height Height of the frame
+ * @return CaptureSlot* The slot, its pixels hold width * height * 4 bytes, NULL when every
+ * slot is being read or the pixels could not be allocated
+ */
+CaptureSlot*
+vur_capture_acquire(FrameCapture* capture, uint32_t width, uint32_t height);
+
+/**
+ * @brief Hand a slot whose pixels have arrived to the workers
+ *
+ * @param[in] capture The capture
+ * @param[in] slot The slot
+ */
+void
+vur_capture_submit(FrameCapture* capture, CaptureSlot* slot);
+
+/**
+ * @brief Return a slot whose frame will never arrive
+ *
+ * @param[in] capture The capture
+ * @param[in] slot The slot
+ */
+void
+vur_capture_release(FrameCapture* capture, CaptureSlot* slot);
+
+/**
+ * @brief Write the queued frames and stop the workers. Slots that are still being read
+ * by the GPU are dropped, so finish the frames in flight first.
+ *
+ * @param[in] capture The capture
+ */
+void
+vur_capture_destroy(FrameCapture* capture);
+
+#endif // CAPTURE_H
@@ -0,0 +1,151 @@
+/**
+ * @file compute.c
+ * @brief Compute shaders with a reflected layout and helpers to bind and dispatch them
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "compute.h"
+#include "pipeline.h"
+#include "vk_util.h"
+
+#include <string.h>
+
+VkResult
+vur_init_compute_program(VkDevice device,
+                         LayoutCache* layout_cache,
+                         VkPipelineCache pipeline_cache,
+                         const ReflectedSet* bindless_set,
+                         const uint32_t code[],
+                         size_t size,
+                         ComputeProgram* program)
+{
+    memset(program, 0, sizeof(*program));
+    program->descriptor_buffer = layout_cache->descriptor_buffer;
+
+    VkResult result = vut_reflect_shader(code, size, &program->reflection);
+    if (result == VK_SUCCESS && program->reflection.stages != VK_SHADER_STAGE_COMPUTE_BIT) {
+        result = VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (result == VK_SUCCESS) {
+        result = vur_reflection_use_bindless(&program->reflection, bindless_set);
+    }
+    for (uint32_t i = 0; result == VK_SUCCESS && i < program->reflection.set_count; i++) {
+        result = vut_layout_cache_get_set_layout(layout_cache, &program->reflection.sets[i],
+                                                 &program->set_layouts[i]);
+    }
+    if (result == VK_SUCCESS) {
+        result = vut_layout_cache_get_pipeline_layout(layout_cache, &program->reflection,
+                                                      &program->layout);
+    }
+    if (result == VK_SUCCESS) {
+        result = vut_init_shader_module(device, code, size, &program->module);
+    }
+    if (result == VK_SUCCESS) {
+        // Specialization constants keep the defaults of the shader
+        const VkPipelineShaderStageCreateInfo stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = program->module,
+            .pName = "main",
+            .pSpecializationInfo = NULL,
+        };
+        VkPipelineCreateFlags flags =
+            program->descriptor_buffer ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+        result = vut_init_compute_pipeline(device, pipeline_cache, flags, &stage,
+                                           program->layout, &program->pipeline);
+    }
+
+    if (result != VK_SUCCESS) {
+        vur_destroy_compute_program(device, program);
+    }
+
+    return result;
+}
+
+VkResult
+vur_compute_alloc_set(const ComputeProgram* program,
+                      DescriptorAllocator* allocator,
+                      uint32_t set,
+                      VkDescriptorSet* descriptor_set)
+{
+    if (program->descriptor_buffer) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    return vur_descriptor_allocator_alloc(allocator, program->set_layouts[set], descriptor_set);
+}
+
+VkResult
+vur_compute_alloc_buffer_set(const ComputeProgram* program,
+                             DescriptorBuffer* descriptors,
+                             uint32_t set,
+                             VkDeviceSize* offset)
+{
+    if (!program->descriptor_buffer) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkDeviceSize set_size =
+        vut_get_descriptor_set_layout_size(descriptors->device, program->set_layouts[set]);
+    return vur_descriptor_buffer_alloc(descriptors, set_size, offset);
+}
+
+void
+vur_compute_bind(VkCommandBuffer command_buffer,
+                 const ComputeProgram* program,
+                 uint32_t first_set,
+                 uint32_t set_count,
+                 const VkDescriptorSet sets[])
+{
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, program->pipeline);
+    // Descriptor buffer layouts can not take sets, see vur_compute_bind_buffers
+    if (set_count && !program->descriptor_buffer) {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, program->layout,
+                                first_set, set_count, sets, 0, NULL);
+    }
+}
+
+void
+vur_compute_bind_buffers(VkCommandBuffer command_buffer,
+                         const ComputeProgram* program,
+                         uint32_t buffer_count,
+                         const VkDescriptorBufferBindingInfoEXT buffers[],
+                         uint32_t first_set,
+                         uint32_t set_count,
+                         const uint32_t buffer_indices[],
+                         const VkDeviceSize offsets[])
+{
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, program->pipeline);
+    if (buffer_count) {
+        vut_bind_descriptor_buffers(command_buffer, buffer_count, buffers);
+    }
+    if (set_count) {
+        vut_set_descriptor_buffer_offsets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                          program->layout, first_set, set_count, buffer_indices,
+                                          offsets);
+    }
+}
+
+void
+vur_compute_push_constants(VkCommandBuffer command_buffer,
+                           const ComputeProgram* program,
+                           uint32_t size,
+                           const void* data)
+{
+    const VkPushConstantRange* range = &program->reflection.push_constant_range;
+    vkCmdPushConstants(command_buffer, program->layout, range->stageFlags, range->offset, size,
+                       data);
+}
+
+void
+vur_destroy_compute_program(VkDevice device, ComputeProgram* program)
+{
+    vkDestroyPipeline(device, program->pipeline, vut_get_allocator());
+    vkDestroyShaderModule(device, program->module, vut_get_allocator());
+    program->pipeline = VK_NULL_HANDLE;
+    program->module = VK_NULL_HANDLE;
+}
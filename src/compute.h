@@ -0,0 +1,162 @@
+/**
+ * @file compute.h
+ * @brief Compute shaders with a reflected layout and helpers to bind and dispatch them
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef COMPUTE_H
+#define COMPUTE_H
+
+#include "descriptor_allocator.h"
+#include "descriptor_buffer.h"
+#include "layout_cache.h"
+#include "spirv_reflect.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief A compute shader, its reflected interface and its pipeline. Storage buffers and
+ * storage images are bound through sets allocated with vur_compute_alloc_set, or with
+ * vur_compute_alloc_buffer_set when the layouts use descriptor buffers, or through the
+ * bindless table at VUR_BINDLESS_SET.
+ */
+typedef struct
+{
+    VkShaderModule module;
+    ShaderReflection reflection;
+    VkPipeline pipeline;
+
+    // Owned by the layout cache
+    VkPipelineLayout layout;
+    VkDescriptorSetLayout set_layouts[VUT_MAX_DESCRIPTOR_SETS];
+
+    // The layouts are made for descriptor buffers, sets can not be allocated from pools
+    bool descriptor_buffer;
+} ComputeProgram;
+
+/**
+ * @brief Load and reflect a compute shader and create its pipeline
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] layout_cache Cache that owns the layouts
+ * @param[in] pipeline_cache The cache to use, may be VK_NULL_HANDLE
+ * @param[in] bindless_set The set of the bindless table, NULL when the device has none
+ * @param[in] code SPIR-V of the compute shader
+ * @param[in] size Size of the shader in bytes
+ * @param[out] program The created program
+ * @return VkResult VK_ERROR_INITIALIZATION_FAILED when the shader is not a compute shader
+ */
+VkResult
+vur_init_compute_program(VkDevice device,
+                         LayoutCache* layout_cache,
+                         VkPipelineCache pipeline_cache,
+                         const ReflectedSet* bindless_set,
+                         const uint32_t code[],
+                         size_t size,
+                         ComputeProgram* program);
+
+/**
+ * @brief Allocate a descriptor set for one of the sets the shader declares. Write its
+ * storage bindings with vut_write_buffer_descriptor and vut_write_image_descriptor.
+ *
+ * @param[in] program The program
+ * @param[in] allocator Allocator the set is freed with, like the one of the frame
+ * @param[in] set Index of the set in the shader
+ * @param[out] descriptor_set The allocated set
+ * @return VkResult VK_ERROR_FEATURE_NOT_PRESENT when the layouts use descriptor buffers
+ */
+VkResult
+vur_compute_alloc_set(const ComputeProgram* program,
+                      DescriptorAllocator* allocator,
+                      uint32_t set,
+                      VkDescriptorSet* descriptor_set);
+
+/**
+ * @brief Allocate one of the sets the shader declares from a descriptor buffer, for
+ * programs whose layouts use descriptor buffers. Write its bindings with
+ * vur_descriptor_buffer_write_buffer at the offset of the set plus the offset of the binding
+ * from vut_get_descriptor_binding_offset.
+ *
+ * @param[in] program The program
+ * @param[in] descriptors Buffer the set is freed with, like one per frame
+ * @param[in] set Index of the set in the shader
+ * @param[out] offset Offset of the set in the buffer
+ * @return VkResult VK_ERROR_FEATURE_NOT_PRESENT when the layouts use descriptor pools,
+ * VK_ERROR_OUT_OF_POOL_MEMORY when the buffer is full
+ */
+VkResult
+vur_compute_alloc_buffer_set(const ComputeProgram* program,
+                             DescriptorBuffer* descriptors,
+                             uint32_t set,
+                             VkDeviceSize* offset);
+
+/**
+ * @brief Bind the pipeline and descriptor sets of the program. Programs whose layouts use
+ * descriptor buffers are bound with vur_compute_bind_buffers instead.
+ *
+ * @param[in] command_buffer The command buffer to record to
+ * @param[in] program The program
+ * @param[in] first_set Index of the first set to bind
+ * @param[in] set_count Amount of sets, may be 0
+ * @param[in] sets The sets
+ */
+void
+vur_compute_bind(VkCommandBuffer command_buffer,
+                 const ComputeProgram* program,
+                 uint32_t first_set,
+                 uint32_t set_count,
+                 const VkDescriptorSet sets[]);
+
+/**
+ * @brief Bind the pipeline and the descriptor buffers of a program whose layouts use
+ * descriptor buffers, and point its sets at offsets in them. Binding replaces every bound
+ * descriptor buffer, so a shader that uses VUR_BINDLESS_SET needs the buffer of the bindless
+ * table among them as well.
+ *
+ * @param[in] command_buffer The command buffer to record to
+ * @param[in] program The program
+ * @param[in] buffer_count Amount of descriptor buffers
+ * @param[in] buffers The buffers, see vur_descriptor_buffer_binding
+ * @param[in] first_set Index of the first set to point
+ * @param[in] set_count Amount of sets, may be 0
+ * @param[in] buffer_indices Index in buffers of every set
+ * @param[in] offsets Offset of every set in its buffer
+ */
+void
+vur_compute_bind_buffers(VkCommandBuffer command_buffer,
+                         const ComputeProgram* program,
+                         uint32_t buffer_count,
+                         const VkDescriptorBufferBindingInfoEXT buffers[],
+                         uint32_t first_set,
+                         uint32_t set_count,
+                         const uint32_t buffer_indices[],
+                         const VkDeviceSize offsets[]);
+
+/**
+ * @brief Update the push constant block of the program
+ *
+ * @param[in] command_buffer The command buffer to record to
+ * @param[in] program The program
+ * @param[in] size Size of the data, at most the size of the block
+ * @param[in] data The data
+ */
+void
+vur_compute_push_constants(VkCommandBuffer command_buffer,
+                           const ComputeProgram* program,
+                           uint32_t size,
+                           const void* data);
+
+/**
+ * @brief Destroy the pipeline and shader module. The layouts are owned by the layout cache.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] program The program to destroy
+ */
+void
+vur_destroy_compute_program(VkDevice device, ComputeProgram* program);
+
+#endif // COMPUTE_H
@@ -0,0 +1,114 @@
+/**
+ * @file deletion_queue.c
+ * @brief Destroy Vulkan objects once no frame in flight can use them anymore
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "deletion_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+deletion_queue_destroy_object(VkDevice device, const RetiredObject* object)
+{
+    switch (object->type) {
+    case VK_OBJECT_TYPE_BUFFER:
+        vkDestroyBuffer(device, (VkBuffer)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_DEVICE_MEMORY:
+        vut_free_memory(device, (VkDeviceMemory)object->handle);
+        break;
+    case VK_OBJECT_TYPE_IMAGE:
+        vkDestroyImage(device, (VkImage)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_IMAGE_VIEW:
+        vkDestroyImageView(device, (VkImageView)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_FRAMEBUFFER:
+        vkDestroyFramebuffer(device, (VkFramebuffer)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_SAMPLER:
+        vkDestroySampler(device, (VkSampler)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+        vkDestroyDescriptorPool(device, (VkDescriptorPool)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_PIPELINE:
+        vkDestroyPipeline(device, (VkPipeline)object->handle, vut_get_allocator());
+        break;
+    case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+        vkDestroySwapchainKHR(device, (VkSwapchainKHR)object->handle, vut_get_allocator());
+        break;
+    default:
+        fprintf(stderr, "Deletion queue cannot destroy objects of type %d\n", object->type);
+        break;
+    }
+}
+
+void
+vur_deletion_queue_init(VkDevice device, uint32_t frame_lag, DeletionQueue* queue)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->device = device;
+    queue->frame_lag = frame_lag;
+}
+
+void
+vur_deletion_queue_push(DeletionQueue* queue, VkObjectType type, uint64_t handle)
+{
+    if (handle == 0) {
+        return;
+    }
+
+    // The object may still be in use by the GPU, so it can neither be destroyed nor dropped
+    if (queue->retired_count == queue->retired_capacity) {
+        uint32_t capacity = queue->retired_capacity ? queue->retired_capacity * 2 : 16;
+        RetiredObject* retired = realloc(queue->retired, capacity * sizeof(RetiredObject));
+        if (retired == NULL) {
+            fprintf(stderr, "Failed to grow the deletion queue to %u objects\n", capacity);
+            abort();
+        }
+        queue->retired = retired;
+        queue->retired_capacity = capacity;
+    }
+
+    queue->retired[queue->retired_count++] = (RetiredObject){
+        .type = type,
+        .handle = handle,
+        .frame = queue->frame,
+    };
+}
+
+void
+vur_deletion_queue_begin_frame(DeletionQueue* queue)
+{
+    queue->frame++;
+
+    // Every frame that could have used a retired object has finished by now
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < queue->retired_count; i++) {
+        if (queue->frame - queue->retired[i].frame >= queue->frame_lag) {
+            deletion_queue_destroy_object(queue->device, &queue->retired[i]);
+        } else {
+            queue->retired[kept++] = queue->retired[i];
+        }
+    }
+    queue->retired_count = kept;
+}
+
+void
+vur_deletion_queue_destroy(DeletionQueue* queue)
+{
+    for (uint32_t i = 0; i < queue->retired_count; i++) {
+        deletion_queue_destroy_object(queue->device, &queue->retired[i]);
+    }
+    free(queue->retired);
+
+    memset(queue, 0, sizeof(*queue));
+}
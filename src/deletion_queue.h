@@ -0,0 +1,83 @@
+/**
+ * @file deletion_queue.h
+ * @brief Destroy Vulkan objects once no frame in flight can use them anymore
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef DELETION_QUEUE_H
+#define DELETION_QUEUE_H
+
+#include "vk_util.h"
+
+#include <stdint.h>
+
+/**
+ * @brief An object handed to the queue and the frame it was retired in
+ */
+typedef struct
+{
+    VkObjectType type;
+    uint64_t handle;
+    uint64_t frame;
+} RetiredObject;
+
+/**
+ * @brief Objects are destroyed frame_lag frames after they were retired, once the fence of
+ * that frame has been waited on. This replaces vkDeviceWaitIdle when objects are replaced
+ * while the renderer is running. Only use the queue from the thread that records frames.
+ */
+typedef struct
+{
+    VkDevice device;
+
+    uint64_t frame;
+    uint32_t frame_lag;
+
+    uint32_t retired_count;
+    uint32_t retired_capacity;
+    RetiredObject* retired;
+} DeletionQueue;
+
+/**
+ * @brief Initialize an empty queue
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] frame_lag Amount of frames in flight
+ * @param[out] queue The deletion queue
+ */
+void
+vur_deletion_queue_init(VkDevice device, uint32_t frame_lag, DeletionQueue* queue);
+
+/**
+ * @brief Destroy an object once the frames that are recorded or in flight have finished
+ *
+ * @param[in] queue The deletion queue
+ * @param[in] type The type of the object. Buffers, memory, images, image views,
+ * framebuffers, samplers, descriptor pools, pipelines and swapchains are supported
+ * @param[in] handle The handle of the object cast to uint64_t, VK_NULL_HANDLE is ignored
+ */
+void
+vur_deletion_queue_push(DeletionQueue* queue, VkObjectType type, uint64_t handle);
+
+/**
+ * @brief Start a new frame and destroy the objects no frame in flight can use.
+ * Call after the fence of the new frame has been waited on.
+ *
+ * @param[in] queue The deletion queue
+ */
+void
+vur_deletion_queue_begin_frame(DeletionQueue* queue);
+
+/**
+ * @brief Destroy every object in the queue. The device must be idle.
+ *
+ * @param[in] queue The deletion queue
+ */
+void
+vur_deletion_queue_destroy(DeletionQueue* queue);
+
+#endif // DELETION_QUEUE_H
@@ -0,0 +1,110 @@
+/**
+ * @file descriptor_allocator.c
+ * @brief Linear descriptor set allocation from a growing chain of pools
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "descriptor_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void
+vur_descriptor_allocator_init(VkDevice device,
+                              uint32_t sets_per_pool,
+                              uint32_t pool_size_count,
+                              const VkDescriptorPoolSize pool_sizes[],
+                              DescriptorAllocator* allocator)
+{
+    memset(allocator, 0, sizeof(*allocator));
+    allocator->device = device;
+    allocator->sets_per_pool = sets_per_pool;
+    allocator->pool_size_count = pool_size_count;
+    memcpy(allocator->pool_sizes, pool_sizes, pool_size_count * sizeof(VkDescriptorPoolSize));
+}
+
+// Make the pool after the current one available, creating it when the chain is too short
+static VkResult
+descriptor_allocator_next_pool(DescriptorAllocator* allocator)
+{
+    if (allocator->pool_count && allocator->current + 1 < allocator->pool_count) {
+        allocator->current++;
+        return VK_SUCCESS;
+    }
+
+    if (allocator->pool_count == allocator->pool_capacity) {
+        uint32_t capacity = allocator->pool_capacity ? allocator->pool_capacity * 2 : 4;
+        VkDescriptorPool* pools = realloc(allocator->pools, capacity * sizeof(VkDescriptorPool));
+        if (pools == NULL) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        allocator->pools = pools;
+        allocator->pool_capacity = capacity;
+    }
+
+    VkResult result = vut_init_descriptor_pool(
+        allocator->device, 0, allocator->sets_per_pool, allocator->pool_size_count,
+        allocator->pool_sizes, &allocator->pools[allocator->pool_count]);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    allocator->current = allocator->pool_count++;
+
+    return VK_SUCCESS;
+}
+
+VkResult
+vur_descriptor_allocator_alloc(DescriptorAllocator* allocator,
+                               VkDescriptorSetLayout layout,
+                               VkDescriptorSet* descriptor_set)
+{
+    if (allocator->pool_count == 0) {
+        VkResult result = descriptor_allocator_next_pool(allocator);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    VkResult result = vut_alloc_descriptor_set(allocator->device,
+                                               allocator->pools[allocator->current], layout,
+                                               descriptor_set);
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+        return result;
+    }
+
+    // The current pool is full until the next reset, a fresh pool always has room
+    result = descriptor_allocator_next_pool(allocator);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    return vut_alloc_descriptor_set(allocator->device, allocator->pools[allocator->current],
+                                    layout, descriptor_set);
+}
+
+void
+vur_descriptor_allocator_reset(DescriptorAllocator* allocator)
+{
+    // Pools after the current one have not been allocated from since the last reset
+    for (uint32_t i = 0; i < allocator->pool_count && i <= allocator->current; i++) {
+        vkResetDescriptorPool(allocator->device, allocator->pools[i], 0);
+    }
+
+    allocator->current = 0;
+}
+
+void
+vur_descriptor_allocator_destroy(DescriptorAllocator* allocator)
+{
+    for (uint32_t i = 0; i < allocator->pool_count; i++) {
+        vkDestroyDescriptorPool(allocator->device, allocator->pools[i], vut_get_allocator());
+    }
+    free(allocator->pools);
+
+    memset(allocator, 0, sizeof(*allocator));
+}
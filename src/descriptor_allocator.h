@@ -0,0 +1,88 @@
+/**
+ * @file descriptor_allocator.h
+ * @brief Linear descriptor set allocation from a growing chain of pools
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef DESCRIPTOR_ALLOCATOR_H
+#define DESCRIPTOR_ALLOCATOR_H
+
+#include "vk_util.h"
+
+#define VUR_MAX_POOL_SIZES 8
+
+/**
+ * @brief Hands out descriptor sets of one frame in flight. Sets are never freed one by
+ * one, the whole chain is reset once the GPU is done with every command buffer using
+ * them. A full pool is not retried until the next reset, so allocation stays O(1) and
+ * pools never fragment. The renderer resets it when the draw set of a frame is replaced
+ * instead of every frame, since recorded passes are reused until then.
+ */
+typedef struct
+{
+    VkDevice device;
+
+    // Every pool in the chain is created with the same sizes
+    uint32_t sets_per_pool;
+    uint32_t pool_size_count;
+    VkDescriptorPoolSize pool_sizes[VUR_MAX_POOL_SIZES];
+
+    uint32_t pool_count;
+    uint32_t pool_capacity;
+    VkDescriptorPool* pools;
+
+    // Pool sets are allocated from, pools before it are full
+    uint32_t current;
+} DescriptorAllocator;
+
+/**
+ * @brief Initialize an empty chain, the first pool is created on the first allocation
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] sets_per_pool Maximum amount of sets in one pool
+ * @param[in] pool_size_count Amount of pool sizes, at most VUR_MAX_POOL_SIZES
+ * @param[in] pool_sizes Amount of descriptors per type in one pool
+ * @param[out] allocator The allocator
+ */
+void
+vur_descriptor_allocator_init(VkDevice device,
+                              uint32_t sets_per_pool,
+                              uint32_t pool_size_count,
+                              const VkDescriptorPoolSize pool_sizes[],
+                              DescriptorAllocator* allocator);
+
+/**
+ * @brief Allocate a set, adding a pool to the chain when the current one is full
+ *
+ * @param[in] allocator The allocator
+ * @param[in] layout The layout of the set, it must fit in an empty pool
+ * @param[out] descriptor_set The allocated set, valid until the next reset
+ * @return VkResult
+ */
+VkResult
+vur_descriptor_allocator_alloc(DescriptorAllocator* allocator,
+                               VkDescriptorSetLayout layout,
+                               VkDescriptorSet* descriptor_set);
+
+/**
+ * @brief Free every set at once. The pools are kept for the next frame.
+ * The GPU may no longer use any of the sets, wait on the fence of the frame first.
+ *
+ * @param[in] allocator The allocator
+ */
+void
+vur_descriptor_allocator_reset(DescriptorAllocator* allocator);
+
+/**
+ * @brief Destroy every pool in the chain
+ *
+ * @param[in] allocator The allocator
+ */
+void
+vur_descriptor_allocator_destroy(DescriptorAllocator* allocator);
+
+#endif // DESCRIPTOR_ALLOCATOR_H
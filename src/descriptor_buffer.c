@@ -0,0 +1,163 @@
+/**
+ * @file descriptor_buffer.c
+ * @brief Descriptor sets written straight into host visible memory with
+ * VK_EXT_descriptor_buffer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "descriptor_buffer.h"
+
+#include <string.h>
+
+#define DESCRIPTOR_BUFFER_USAGE                                                                   \
+    (VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |                                          \
+     VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+
+VkResult
+vur_descriptor_buffer_init(VkDevice device,
+                           VkPhysicalDevice gpu,
+                           VkDeviceSize size,
+                           DescriptorBuffer* descriptors)
+{
+    memset(descriptors, 0, sizeof(*descriptors));
+    descriptors->device = device;
+    descriptors->size = size;
+    vut_get_descriptor_buffer_properties(gpu, &descriptors->properties);
+
+    VkResult result = vut_init_buffer(
+        device, gpu, size, DESCRIPTOR_BUFFER_USAGE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &descriptors->buffer, &descriptors->memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    result = vkMapMemory(device, descriptors->memory, 0, size, 0, (void**)&descriptors->data);
+    if (result != VK_SUCCESS) {
+        vur_descriptor_buffer_destroy(descriptors);
+        return result;
+    }
+
+    descriptors->address = vut_get_buffer_address(device, descriptors->buffer);
+
+    return VK_SUCCESS;
+}
+
+VkResult
+vur_descriptor_buffer_alloc(DescriptorBuffer* descriptors,
+                            VkDeviceSize set_size,
+                            VkDeviceSize* offset)
+{
+    VkDeviceSize alignment = descriptors->properties.descriptorBufferOffsetAlignment;
+    VkDeviceSize start = (descriptors->head + alignment - 1) & ~(alignment - 1);
+    if (start + set_size > descriptors->size) {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
+    descriptors->head = start + set_size;
+    *offset = start;
+
+    return VK_SUCCESS;
+}
+
+void
+vur_descriptor_buffer_reset(DescriptorBuffer* descriptors)
+{
+    descriptors->head = 0;
+}
+
+size_t
+vur_descriptor_buffer_descriptor_size(const DescriptorBuffer* descriptors, VkDescriptorType type)
+{
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+        return descriptors->properties.samplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        return descriptors->properties.sampledImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        return descriptors->properties.uniformBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        return descriptors->properties.storageBufferDescriptorSize;
+    default:
+        // Other types are not used by the renderer
+        return 0;
+    }
+}
+
+void
+vur_descriptor_buffer_write_buffer(DescriptorBuffer* descriptors,
+                                   VkDeviceSize offset,
+                                   VkDescriptorType type,
+                                   VkDeviceAddress address,
+                                   VkDeviceSize range)
+{
+    const VkDescriptorAddressInfoEXT address_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+        .pNext = NULL,
+        .address = address,
+        .range = range,
+        .format = VK_FORMAT_UNDEFINED,
+    };
+
+    VkDescriptorGetInfoEXT get_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .pNext = NULL,
+        .type = type,
+    };
+    if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        get_info.data.pUniformBuffer = &address_info;
+    } else {
+        get_info.data.pStorageBuffer = &address_info;
+    }
+
+    vut_get_descriptor(descriptors->device, &get_info,
+                       vur_descriptor_buffer_descriptor_size(descriptors, type),
+                       descriptors->data + offset);
+}
+
+void
+vur_descriptor_buffer_write_image(DescriptorBuffer* descriptors,
+                                  VkDeviceSize offset,
+                                  VkDescriptorType type,
+                                  const VkDescriptorImageInfo* image_info)
+{
+    VkDescriptorGetInfoEXT get_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .pNext = NULL,
+        .type = type,
+    };
+    if (type == VK_DESCRIPTOR_TYPE_SAMPLER) {
+        get_info.data.pSampler = &image_info->sampler;
+    } else {
+        get_info.data.pSampledImage = image_info;
+    }
+
+    vut_get_descriptor(descriptors->device, &get_info,
+                       vur_descriptor_buffer_descriptor_size(descriptors, type),
+                       descriptors->data + offset);
+}
+
+VkDescriptorBufferBindingInfoEXT
+vur_descriptor_buffer_binding(const DescriptorBuffer* descriptors)
+{
+    return (VkDescriptorBufferBindingInfoEXT){
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+        .pNext = NULL,
+        .address = descriptors->address,
+        .usage = DESCRIPTOR_BUFFER_USAGE,
+    };
+}
+
+void
+vur_descriptor_buffer_destroy(DescriptorBuffer* descriptors)
+{
+    // Unmapped implicitly when the memory is freed
+    vkDestroyBuffer(descriptors->device, descriptors->buffer, vut_get_allocator());
+    vut_free_memory(descriptors->device, descriptors->memory);
+
+    memset(descriptors, 0, sizeof(*descriptors));
+}
@@ -0,0 +1,131 @@
+/**
+ * @file descriptor_buffer.h
+ * @brief Descriptor sets written straight into host visible memory with
+ * VK_EXT_descriptor_buffer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef DESCRIPTOR_BUFFER_H
+#define DESCRIPTOR_BUFFER_H
+
+#include "vk_util.h"
+
+#include <stdint.h>
+
+/**
+ * @brief A persistently mapped buffer that holds descriptor sets. Sets are allocated
+ * linearly and the buffer is reset as a whole, there are no pools or set objects.
+ * Only use with layouts of a layout cache in descriptor buffer mode.
+ */
+typedef struct
+{
+    VkDevice device;
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT properties;
+
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    uint8_t* data;
+    VkDeviceAddress address;
+
+    VkDeviceSize size;
+    VkDeviceSize head;
+} DescriptorBuffer;
+
+/**
+ * @brief Create and map the buffer. It can hold both sampler and resource descriptors.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] gpu The physical device, for the memory types and descriptor sizes
+ * @param[in] size Size of the buffer in bytes
+ * @param[out] descriptors The descriptor buffer
+ * @return VkResult
+ */
+VkResult
+vur_descriptor_buffer_init(VkDevice device,
+                           VkPhysicalDevice gpu,
+                           VkDeviceSize size,
+                           DescriptorBuffer* descriptors);
+
+/**
+ * @brief Allocate room for a set
+ *
+ * @param[in] descriptors The descriptor buffer
+ * @param[in] set_size Size of the set, see vut_get_descriptor_set_layout_size
+ * @param[out] offset Offset of the set, used to write its descriptors and to bind it
+ * @return VkResult VK_ERROR_OUT_OF_POOL_MEMORY when the buffer is full
+ */
+VkResult
+vur_descriptor_buffer_alloc(DescriptorBuffer* descriptors,
+                            VkDeviceSize set_size,
+                            VkDeviceSize* offset);
+
+/**
+ * @brief Free every set at once. The GPU may no longer read any of them.
+ *
+ * @param[in] descriptors The descriptor buffer
+ */
+void
+vur_descriptor_buffer_reset(DescriptorBuffer* descriptors);
+
+/**
+ * @brief Get the size of one descriptor of a type
+ *
+ * @param[in] descriptors The descriptor buffer
+ * @param[in] type The descriptor type
+ * @return size_t
+ */
+size_t
+vur_descriptor_buffer_descriptor_size(const DescriptorBuffer* descriptors, VkDescriptorType type);
+
+/**
+ * @brief Write a buffer descriptor
+ *
+ * @param[in] descriptors The descriptor buffer
+ * @param[in] offset Offset of the set plus the offset of the binding and array element
+ * @param[in] type VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER or VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+ * @param[in] address Device address of the start of the range
+ * @param[in] range Size of the range
+ */
+void
+vur_descriptor_buffer_write_buffer(DescriptorBuffer* descriptors,
+                                   VkDeviceSize offset,
+                                   VkDescriptorType type,
+                                   VkDeviceAddress address,
+                                   VkDeviceSize range);
+
+/**
+ * @brief Write a sampled image or sampler descriptor
+ *
+ * @param[in] descriptors The descriptor buffer
+ * @param[in] offset Offset of the set plus the offset of the binding and array element
+ * @param[in] type VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE or VK_DESCRIPTOR_TYPE_SAMPLER
+ * @param[in] image_info The image view and layout, or the sampler
+ */
+void
+vur_descriptor_buffer_write_image(DescriptorBuffer* descriptors,
+                                  VkDeviceSize offset,
+                                  VkDescriptorType type,
+                                  const VkDescriptorImageInfo* image_info);
+
+/**
+ * @brief Get the binding info to bind the buffer with vut_bind_descriptor_buffers
+ *
+ * @param[in] descriptors The descriptor buffer
+ * @return VkDescriptorBufferBindingInfoEXT
+ */
+VkDescriptorBufferBindingInfoEXT
+vur_descriptor_buffer_binding(const DescriptorBuffer* descriptors);
+
+/**
+ * @brief Destroy the buffer
+ *
+ * @param[in] descriptors The descriptor buffer
+ */
+void
+vur_descriptor_buffer_destroy(DescriptorBuffer* descriptors);
+
+#endif // DESCRIPTOR_BUFFER_H
@@ -0,0 +1,119 @@
+/**
+ * @file draw_sort.c
+ * @brief 64 bit sort keys for draws and a radix sort to order them by render state
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "draw_sort.h"
+
+#include <string.h>
+
+#define VUT_RADIX_BITS 8
+#define VUT_RADIX_BUCKETS (1u << VUT_RADIX_BITS)
+#define VUT_RADIX_PASSES (64 / VUT_RADIX_BITS)
+
+// Shift the key up and put the low bits of a value below it
+static inline uint64_t
+draw_key_append(uint64_t key, uint32_t value, uint32_t bits)
+{
+    return (key << bits) | ((uint64_t)value & ((1ull << bits) - 1));
+}
+
+// The bits of a positive float sort like the float, the top bits keep the order roughly
+static uint32_t
+draw_key_depth(float depth)
+{
+    uint32_t bits = 0;
+    if (depth > 0.0f) {
+        memcpy(&bits, &depth, sizeof(bits));
+    }
+
+    return bits >> (32 - VUR_DRAW_KEY_DEPTH_BITS);
+}
+
+uint64_t
+vur_draw_key(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    uint64_t key = draw_key_append(0, pass, VUR_DRAW_KEY_PASS_BITS);
+    uint32_t depth_bits = draw_key_depth(depth);
+
+    if (pass == VUR_PASS_TRANSPARENT) {
+        // Inverted, so the farthest draw has the smallest key
+        key = draw_key_append(key, ~depth_bits, VUR_DRAW_KEY_DEPTH_BITS);
+    }
+
+    key = draw_key_append(key, pipeline, VUR_DRAW_KEY_PIPELINE_BITS);
+    key = draw_key_append(key, material, VUR_DRAW_KEY_MATERIAL_BITS);
+    key = draw_key_append(key, mesh, VUR_DRAW_KEY_MESH_BITS);
+
+    if (pass != VUR_PASS_TRANSPARENT) {
+        key = draw_key_append(key, depth_bits, VUR_DRAW_KEY_DEPTH_BITS);
+    }
+
+    return key;
+}
+
+void
+vut_radix_sort(uint64_t keys[],
+               uint32_t values[],
+               uint32_t count,
+               uint64_t scratch_keys[],
+               uint32_t scratch_values[])
+{
+    // The histograms of every pass are counted in a single read of the keys
+    uint32_t histograms[VUT_RADIX_PASSES][VUT_RADIX_BUCKETS];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key = keys[i];
+        for (uint32_t pass = 0; pass < VUT_RADIX_PASSES; pass++) {
+            histograms[pass][(key >> (pass * VUT_RADIX_BITS)) & (VUT_RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    uint64_t* source_keys = keys;
+    uint32_t* source_values = values;
+    uint64_t* target_keys = scratch_keys;
+    uint32_t* target_values = scratch_values;
+
+    for (uint32_t pass = 0; pass < VUT_RADIX_PASSES; pass++) {
+        uint32_t* histogram = histograms[pass];
+        uint32_t shift = pass * VUT_RADIX_BITS;
+
+        // Every key has the same byte here, the pass would not move anything
+        if (count == 0 || histogram[(source_keys[0] >> shift) & (VUT_RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+
+        // Turn the counts into the first position of every bucket
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < VUT_RADIX_BUCKETS; bucket++) {
+            uint32_t bucket_count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_count;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t position = histogram[(source_keys[i] >> shift) & (VUT_RADIX_BUCKETS - 1)]++;
+            target_keys[position] = source_keys[i];
+            target_values[position] = source_values[i];
+        }
+
+        uint64_t* swap_keys = source_keys;
+        source_keys = target_keys;
+        target_keys = swap_keys;
+        uint32_t* swap_values = source_values;
+        source_values = target_values;
+        target_values = swap_values;
+    }
+
+    // An odd amount of passes ran, the result is in the scratch arrays
+    if (source_keys != keys) {
+        memcpy(keys, source_keys, count * sizeof(uint64_t));
+        memcpy(values, source_values, count * sizeof(uint32_t));
+    }
+}
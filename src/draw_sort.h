@@ -0,0 +1,72 @@
+/**
+ * @file draw_sort.h
+ * @brief 64 bit sort keys for draws and a radix sort to order them by render state
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef DRAW_SORT_H
+#define DRAW_SORT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Passes of the draw list, drawn in this order
+ */
+typedef enum
+{
+    VUR_PASS_OPAQUE = 0,
+    // Blended, drawn back to front after the opaque draws
+    VUR_PASS_TRANSPARENT = 1,
+} DrawPass;
+
+#define VUR_PASS_COUNT 2
+
+// Bits of every field of a key. Fields that are too wide are truncated, which only makes
+// the order less good: the recorder compares the real state before skipping a bind.
+#define VUR_DRAW_KEY_PASS_BITS 2
+#define VUR_DRAW_KEY_PIPELINE_BITS 12
+#define VUR_DRAW_KEY_MATERIAL_BITS 16
+#define VUR_DRAW_KEY_MESH_BITS 18
+#define VUR_DRAW_KEY_DEPTH_BITS 16
+
+/**
+ * @brief Pack the state of a draw into a key that sorts draws with the same state next to
+ * each other. From the most significant bits:
+ *
+ * opaque:      pass | pipeline | material | mesh | depth, front to back
+ * transparent: pass | depth, back to front | pipeline | material | mesh
+ *
+ * Blending needs the order by depth, so it wins over the state for transparent draws.
+ *
+ * @param[in] pass The DrawPass of the draw, below VUR_PASS_COUNT
+ * @param[in] pipeline Identifies the pipeline variant
+ * @param[in] material Index of the material
+ * @param[in] mesh Identifies the vertices
+ * @param[in] depth View space distance, negative distances count as 0
+ * @return uint64_t The key, smaller keys are drawn first
+ */
+uint64_t
+vur_draw_key(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+/**
+ * @brief Sort keys together with a value each, least significant byte first. Equal keys keep
+ * their order. Bytes that are the same in every key are skipped, so narrow keys cost less.
+ *
+ * @param[in, out] keys The keys to sort
+ * @param[in, out] values Moved along with their keys, typically indices
+ * @param[in] count Amount of keys
+ * @param[in] scratch_keys Room for count keys
+ * @param[in] scratch_values Room for count values
+ */
+void
+vut_radix_sort(uint64_t keys[],
+               uint32_t values[],
+               uint32_t count,
+               uint64_t scratch_keys[],
+               uint32_t scratch_values[]);
+
+#endif // DRAW_SORT_H
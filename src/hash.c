@@ -0,0 +1,115 @@
+/**
+ * @file hash.c
+ * @brief Hashing and a small open addressing index for the renderer caches
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "hash.h"
+
+#include <stdlib.h>
+
+#define EMPTY_SLOT UINT32_MAX
+
+uint64_t
+vut_hash(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = data;
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static void
+hash_index_place(HashIndex* index, uint64_t hash, uint32_t value)
+{
+    uint32_t mask = index->capacity - 1;
+    uint32_t slot = (uint32_t)hash & mask;
+
+    // Linear probing, the table is never full so this terminates
+    while (index->indices[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+
+    index->hashes[slot] = hash;
+    index->indices[slot] = value;
+}
+
+bool
+vut_hash_index_insert(HashIndex* index, uint64_t hash, uint32_t value)
+{
+    // Keep the load factor below 3/4 so probe sequences stay short
+    if ((index->count + 1) * 4 > index->capacity * 3) {
+        HashIndex old = *index;
+
+        index->capacity = old.capacity ? old.capacity * 2 : 16;
+        index->hashes = malloc(index->capacity * sizeof *index->hashes);
+        index->indices = malloc(index->capacity * sizeof *index->indices);
+        if (index->hashes == NULL || index->indices == NULL) {
+            // The old table still holds every entry
+            free(index->hashes);
+            free(index->indices);
+            *index = old;
+            return false;
+        }
+        for (uint32_t i = 0; i < index->capacity; i++) {
+            index->indices[i] = EMPTY_SLOT;
+        }
+
+        for (uint32_t i = 0; i < old.capacity; i++) {
+            if (old.indices[i] != EMPTY_SLOT) {
+                hash_index_place(index, old.hashes[i], old.indices[i]);
+            }
+        }
+
+        free(old.hashes);
+        free(old.indices);
+    }
+
+    hash_index_place(index, hash, value);
+    index->count++;
+    return true;
+}
+
+uint32_t
+vut_hash_index_find(const HashIndex* index, uint64_t hash, uint32_t* cursor)
+{
+    if (index->capacity == 0) {
+        return UINT32_MAX;
+    }
+
+    uint32_t mask = index->capacity - 1;
+
+    // The cursor counts the slots probed so far
+    while (*cursor < index->capacity) {
+        uint32_t slot = ((uint32_t)hash + *cursor) & mask;
+        (*cursor)++;
+
+        if (index->indices[slot] == EMPTY_SLOT) {
+            break;
+        }
+
+        if (index->hashes[slot] == hash) {
+            return index->indices[slot];
+        }
+    }
+
+    *cursor = index->capacity;
+    return UINT32_MAX;
+}
+
+void
+vut_hash_index_free(HashIndex* index)
+{
+    free(index->hashes);
+    free(index->indices);
+    *index = (HashIndex){ 0 };
+}
@@ -0,0 +1,73 @@
+/**
+ * @file hash.h
+ * @brief Hashing and a small open addressing index for the renderer caches
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VUT_HASH_SEED 0xcbf29ce484222325ull
+
+/**
+ * @brief Maps 64 bit hashes to indices of a dense array owned by the caller.
+ * Multiple entries may share a hash, the caller compares the full keys.
+ */
+typedef struct
+{
+    uint64_t* hashes;
+    uint32_t* indices;
+    uint32_t capacity;
+    uint32_t count;
+} HashIndex;
+
+/**
+ * @brief FNV-1a hash of a block of memory
+ *
+ * @param[in] data The bytes to hash
+ * @param[in] size The amount of bytes
+ * @param[in] seed VUT_HASH_SEED or a previous hash to chain multiple blocks
+ * @return uint64_t The hash
+ */
+uint64_t
+vut_hash(const void* data, size_t size, uint64_t seed);
+
+/**
+ * @brief Add an entry to the index. The index grows when it gets too full
+ *
+ * @param[in] index The hash index
+ * @param[in] hash Hash of the entry
+ * @param[in] value Index of the entry in the dense array of the caller
+ * @return true The entry was added, false when the index could not grow
+ */
+bool
+vut_hash_index_insert(HashIndex* index, uint64_t hash, uint32_t value);
+
+/**
+ * @brief Iterate the entries stored with a hash
+ *
+ * @param[in] index The hash index
+ * @param[in] hash The hash to look for
+ * @param[in, out] cursor Set to 0 before the first call
+ * @return uint32_t The next entry with this hash or UINT32_MAX if there are no more
+ */
+uint32_t
+vut_hash_index_find(const HashIndex* index, uint64_t hash, uint32_t* cursor);
+
+/**
+ * @brief Free the memory of the index
+ *
+ * @param[in] index The hash index
+ */
+void
+vut_hash_index_free(HashIndex* index);
+
+#endif // HASH_H
@@ -0,0 +1,292 @@
+/**
+ * @file host_allocator.c
+ * @brief VkAllocationCallbacks backed by size class pools, with statistics per scope
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "host_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Where a block came from, stored in its header
+#define SOURCE_ARENA UINT8_MAX
+#define SOURCE_MALLOC (UINT8_MAX - 1)
+
+// Pooled blocks and the header are aligned to this, larger alignments go to malloc
+#define HEADER_SIZE 16
+
+typedef struct
+{
+    size_t size;
+    // Distance from the start of a malloc block to the allocation
+    uint32_t offset;
+    uint8_t source;
+    uint8_t scope;
+} BlockHeader;
+
+static BlockHeader*
+block_header(void* memory)
+{
+    return (BlockHeader*)((uint8_t*)memory - HEADER_SIZE);
+}
+
+static uint8_t
+size_class(size_t size)
+{
+    uint8_t index = 0;
+    while (((size_t)16 << index) < size) {
+        index++;
+    }
+
+    return index;
+}
+
+static size_t
+align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Carve a new chunk into blocks of a size class
+static void
+host_allocator_grow(HostAllocator* allocator, uint8_t index)
+{
+    // Without room for the chunk the size class stays empty, like when the chunk itself fails
+    if (allocator->chunk_count == allocator->chunk_capacity) {
+        uint32_t capacity = allocator->chunk_capacity ? allocator->chunk_capacity * 2 : 16;
+        void** chunks = realloc(allocator->chunks, capacity * sizeof(void*));
+        if (chunks == NULL) {
+            return;
+        }
+        allocator->chunks = chunks;
+        allocator->chunk_capacity = capacity;
+    }
+
+    uint8_t* chunk = malloc(VUT_HOST_CHUNK_SIZE);
+    if (chunk == NULL) {
+        return;
+    }
+    allocator->chunks[allocator->chunk_count++] = chunk;
+
+    // The free list links through the first bytes after the header
+    size_t block_size = HEADER_SIZE + ((size_t)16 << index);
+    for (size_t offset = 0; offset + block_size <= VUT_HOST_CHUNK_SIZE; offset += block_size) {
+        void* memory = chunk + offset + HEADER_SIZE;
+        *(void**)memory = allocator->free_lists[index];
+        allocator->free_lists[index] = memory;
+    }
+}
+
+static void*
+host_allocator_alloc_locked(HostAllocator* allocator,
+                            size_t size,
+                            size_t alignment,
+                            VkSystemAllocationScope scope)
+{
+    void* memory = NULL;
+    uint8_t source;
+
+    if (alignment < HEADER_SIZE) {
+        alignment = HEADER_SIZE;
+    }
+
+    // The address is aligned, malloc only guarantees the alignment of max_align_t
+    uintptr_t arena_base = (uintptr_t)allocator->arena;
+    size_t arena_start =
+        align_up(arena_base + allocator->arena_head + HEADER_SIZE, alignment) - arena_base;
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && allocator->arena != NULL &&
+        arena_start + size <= VUT_HOST_ARENA_SIZE) {
+        memory = allocator->arena + arena_start;
+        allocator->arena_head = arena_start + size;
+        allocator->arena_live++;
+        source = SOURCE_ARENA;
+    } else if (size <= VUT_HOST_MAX_CLASS_SIZE && alignment == HEADER_SIZE) {
+        source = size_class(size);
+        if (allocator->free_lists[source] == NULL) {
+            host_allocator_grow(allocator, source);
+        }
+        memory = allocator->free_lists[source];
+        if (memory) {
+            allocator->free_lists[source] = *(void**)memory;
+        }
+    } else {
+        uint8_t* block = malloc(size + alignment + HEADER_SIZE);
+        if (block) {
+            memory = (void*)align_up((uintptr_t)block + HEADER_SIZE, alignment);
+            block_header(memory)->offset = (uint32_t)((uint8_t*)memory - block);
+        }
+        source = SOURCE_MALLOC;
+    }
+
+    if (memory == NULL) {
+        return NULL;
+    }
+
+    BlockHeader* header = block_header(memory);
+    header->size = size;
+    header->source = source;
+    header->scope = (uint8_t)scope;
+
+    HostAllocationStats* stats = &allocator->scopes[scope];
+    stats->bytes += size;
+    stats->allocation_count++;
+    if (stats->bytes > stats->peak_bytes) {
+        stats->peak_bytes = stats->bytes;
+    }
+
+    return memory;
+}
+
+static void
+host_allocator_free_locked(HostAllocator* allocator, void* memory)
+{
+    BlockHeader* header = block_header(memory);
+    allocator->scopes[header->scope].bytes -= header->size;
+
+    if (header->source == SOURCE_ARENA) {
+        allocator->arena_live--;
+    } else if (header->source == SOURCE_MALLOC) {
+        free((uint8_t*)memory - header->offset);
+    } else {
+        *(void**)memory = allocator->free_lists[header->source];
+        allocator->free_lists[header->source] = memory;
+    }
+}
+
+// VkAllocationCallbacks \\\
+
+static void* VKAPI_PTR
+host_allocation(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    HostAllocator* allocator = user_data;
+
+    pthread_mutex_lock(&allocator->mutex);
+    void* memory = host_allocator_alloc_locked(allocator, size, alignment, scope);
+    pthread_mutex_unlock(&allocator->mutex);
+
+    return memory;
+}
+
+static void* VKAPI_PTR
+host_reallocation(void* user_data,
+                  void* original,
+                  size_t size,
+                  size_t alignment,
+                  VkSystemAllocationScope scope)
+{
+    HostAllocator* allocator = user_data;
+    void* memory = NULL;
+
+    pthread_mutex_lock(&allocator->mutex);
+    if (size) {
+        memory = host_allocator_alloc_locked(allocator, size, alignment, scope);
+    }
+    // The original stays valid when the new allocation fails
+    if (original && (memory || size == 0)) {
+        if (memory) {
+            size_t old_size = block_header(original)->size;
+            memcpy(memory, original, old_size < size ? old_size : size);
+        }
+        host_allocator_free_locked(allocator, original);
+    }
+    pthread_mutex_unlock(&allocator->mutex);
+
+    return memory;
+}
+
+static void VKAPI_PTR
+host_free(void* user_data, void* memory)
+{
+    HostAllocator* allocator = user_data;
+    if (memory == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&allocator->mutex);
+    host_allocator_free_locked(allocator, memory);
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+static void VKAPI_PTR
+host_internal_allocation(void* user_data,
+                         size_t size,
+                         VkInternalAllocationType type,
+                         VkSystemAllocationScope scope)
+{
+    HostAllocator* allocator = user_data;
+
+    pthread_mutex_lock(&allocator->mutex);
+    allocator->scopes[scope].internal_bytes += size;
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+static void VKAPI_PTR
+host_internal_free(void* user_data,
+                   size_t size,
+                   VkInternalAllocationType type,
+                   VkSystemAllocationScope scope)
+{
+    HostAllocator* allocator = user_data;
+
+    pthread_mutex_lock(&allocator->mutex);
+    allocator->scopes[scope].internal_bytes -= size;
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+// Public \\\
+
+void
+vut_host_allocator_init(HostAllocator* allocator)
+{
+    memset(allocator, 0, sizeof(*allocator));
+    pthread_mutex_init(&allocator->mutex, NULL);
+    allocator->arena = malloc(VUT_HOST_ARENA_SIZE);
+
+    allocator->callbacks = (VkAllocationCallbacks){
+        .pUserData = allocator,
+        .pfnAllocation = host_allocation,
+        .pfnReallocation = host_reallocation,
+        .pfnFree = host_free,
+        .pfnInternalAllocation = host_internal_allocation,
+        .pfnInternalFree = host_internal_free,
+    };
+}
+
+void
+vut_host_allocator_begin_frame(HostAllocator* allocator)
+{
+    // A pipeline compiling on a worker thread may still hold command scope memory
+    pthread_mutex_lock(&allocator->mutex);
+    if (allocator->arena_live == 0) {
+        allocator->arena_head = 0;
+    }
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+HostAllocationStats
+vut_host_allocator_get_stats(HostAllocator* allocator, VkSystemAllocationScope scope)
+{
+    pthread_mutex_lock(&allocator->mutex);
+    HostAllocationStats stats = allocator->scopes[scope];
+    pthread_mutex_unlock(&allocator->mutex);
+
+    return stats;
+}
+
+void
+vut_host_allocator_destroy(HostAllocator* allocator)
+{
+    for (uint32_t i = 0; i < allocator->chunk_count; i++) {
+        free(allocator->chunks[i]);
+    }
+    free(allocator->chunks);
+    free(allocator->arena);
+    pthread_mutex_destroy(&allocator->mutex);
+
+    memset(allocator, 0, sizeof(*allocator));
+}
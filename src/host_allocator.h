@@ -0,0 +1,103 @@
+/**
+ * @file host_allocator.h
+ * @brief VkAllocationCallbacks backed by size class pools, with statistics per scope
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef HOST_ALLOCATOR_H
+#define HOST_ALLOCATOR_H
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+// Size classes are powers of two from 16 up to 4096 bytes, larger blocks use malloc
+#define VUT_HOST_SIZE_CLASS_COUNT 9
+#define VUT_HOST_MAX_CLASS_SIZE 4096
+#define VUT_HOST_CHUNK_SIZE (64 * 1024)
+#define VUT_HOST_ARENA_SIZE (256 * 1024)
+
+// Amount of VkSystemAllocationScope values
+#define VUT_ALLOCATION_SCOPE_COUNT 5
+
+/**
+ * @brief Host memory of one allocation scope
+ */
+typedef struct
+{
+    // Bytes the driver asked for that have not been freed, and the most there ever were
+    size_t bytes;
+    size_t peak_bytes;
+    uint64_t allocation_count;
+
+    // Reported through the internal allocation notifications, not allocated by us
+    size_t internal_bytes;
+} HostAllocationStats;
+
+/**
+ * @brief Host allocator for the driver. Small blocks come from free lists per size class,
+ * so frequent object creation does not go through malloc. Allocations that only live for
+ * the duration of a Vulkan command are bumped from an arena that is reset every frame.
+ * The driver may call it from any thread, so every call takes a lock.
+ */
+typedef struct
+{
+    VkAllocationCallbacks callbacks;
+    pthread_mutex_t mutex;
+
+    void* free_lists[VUT_HOST_SIZE_CLASS_COUNT];
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+    void** chunks;
+
+    // VK_SYSTEM_ALLOCATION_SCOPE_COMMAND, only reset when no allocation is alive
+    uint8_t* arena;
+    size_t arena_head;
+    uint32_t arena_live;
+
+    HostAllocationStats scopes[VUT_ALLOCATION_SCOPE_COUNT];
+} HostAllocator;
+
+/**
+ * @brief Initialize the allocator, pass its callbacks to vut_set_allocator. The allocator
+ * must not move while the callbacks are in use.
+ *
+ * @param[out] allocator The host allocator
+ */
+void
+vut_host_allocator_init(HostAllocator* allocator);
+
+/**
+ * @brief Reuse the arena of the command scope. Call once per frame.
+ *
+ * @param[in] allocator The host allocator
+ */
+void
+vut_host_allocator_begin_frame(HostAllocator* allocator);
+
+/**
+ * @brief Get a snapshot of the statistics of a scope
+ *
+ * @param[in] allocator The host allocator
+ * @param[in] scope The allocation scope
+ * @return HostAllocationStats
+ */
+HostAllocationStats
+vut_host_allocator_get_stats(HostAllocator* allocator, VkSystemAllocationScope scope);
+
+/**
+ * @brief Free all memory of the allocator. Every object created with its callbacks,
+ * including the instance, must be destroyed first.
+ *
+ * @param[in] allocator The host allocator
+ */
+void
+vut_host_allocator_destroy(HostAllocator* allocator);
+
+#endif // HOST_ALLOCATOR_H
@@ -80,12 +80,13 @@ void
 vur_prepare_image_views(VulkanContext* ctx);
 
 /**
- * @brief Create command buffers
+ * @brief Create the command pool and buffer of every frame in flight
  *
  * @param[in] ctx VulkanContext handle
+ * @return VkResult VK_SUCCESS, or the error of the first allocation that failed
  */
-void
-vur_prepare_buffers(VulkanContext* ctx);
+VkResult
+vur_prepare_frames(VulkanContext* ctx);
 
 /**
  * @brief Create grpahics pipeline
@@ -98,12 +99,14 @@ vur_prepare_pipeline(VulkanContext* ctx);
 // Draw
 
 /**
- * @brief Record the drawing process in the buffers
+ * @brief Record the drawing process in the command buffer of the current frame.
+ * Recording every frame lets draws pick up pipelines as soon as they are compiled.
  *
  * @param[in] ctx VulkanContext handle
+ * @param[in] image_index The acquired swapchain image
  */
 void
-vur_record_buffers(VulkanContext* ctx);
+vur_record_frame(VulkanContext* ctx, uint32_t image_index);
 
 // Destroy
 
@@ -116,7 +119,8 @@ void
 vur_resize(VulkanContext* ctx);
 
 /**
- * @brief Destroy the pipeline for resizing
+ * @brief Retire the swapchain dependent resources for resizing, they are destroyed by the
+ * deletion queue once frames in flight are done with them
  *
  * @param[in] ctx VulkanContext handle
  */
@@ -0,0 +1,448 @@
+/**
+ * @file jobs.c
+ * @brief Work stealing job system shared by the subsystems of the renderer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "jobs.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// The worker running on this thread, NULL outside the pool
+static _Thread_local JobWorker* current_worker;
+
+// State of the random victim selection of this thread
+static _Thread_local uint32_t steal_random = 0x9E3779B9u;
+
+// Deque \\\
+
+static bool
+job_deque_push(JobDeque* deque, JobDecl* job)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= VUT_JOB_DEQUE_SIZE) {
+        return false;
+    }
+
+    atomic_store_explicit(&deque->jobs[bottom % VUT_JOB_DEQUE_SIZE], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+    return true;
+}
+
+static JobDecl*
+job_deque_take(JobDeque* deque)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        // Empty
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    JobDecl* job =
+        atomic_load_explicit(&deque->jobs[bottom % VUT_JOB_DEQUE_SIZE], memory_order_relaxed);
+    if (top == bottom) {
+        // The last job, thieves may be racing for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            job = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return job;
+}
+
+static JobDecl*
+job_deque_steal(JobDeque* deque)
+{
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    JobDecl* job =
+        atomic_load_explicit(&deque->jobs[top % VUT_JOB_DEQUE_SIZE], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        // Lost to the owner or another thief
+        return NULL;
+    }
+
+    return job;
+}
+
+// Counter \\\
+
+static void
+job_counter_lock(JobCounter* counter)
+{
+    while (atomic_exchange_explicit(&counter->locked, true, memory_order_acquire)) {
+        while (atomic_load_explicit(&counter->locked, memory_order_relaxed)) {
+            sched_yield();
+        }
+    }
+}
+
+static void
+job_counter_unlock(JobCounter* counter)
+{
+    atomic_store_explicit(&counter->locked, false, memory_order_release);
+}
+
+// System \\\
+
+static void
+jobs_push(JobSystem* jobs, JobDecl* first)
+{
+    uint32_t count = 0;
+    for (JobDecl* job = first; job; job = job->next) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // Counted before they are visible, so no worker sleeps while they are queued
+    atomic_fetch_add(&jobs->queued, (int)count);
+
+    JobWorker* worker = current_worker;
+    JobDecl* spill = first;
+    if (worker && worker->system == jobs) {
+        while (spill && job_deque_push(worker->deque, spill)) {
+            spill = spill->next;
+        }
+    }
+
+    if (spill) {
+        pthread_mutex_lock(&jobs->queue_mutex);
+        JobDecl* last = spill;
+        while (last->next) {
+            last = last->next;
+        }
+        if (jobs->queue_tail) {
+            jobs->queue_tail->next = spill;
+        } else {
+            jobs->queue_head = spill;
+        }
+        jobs->queue_tail = last;
+        pthread_mutex_unlock(&jobs->queue_mutex);
+    }
+
+    if (atomic_load(&jobs->sleeping) > 0) {
+        pthread_mutex_lock(&jobs->sleep_mutex);
+        if (count > 1) {
+            pthread_cond_broadcast(&jobs->wake);
+        } else {
+            pthread_cond_signal(&jobs->wake);
+        }
+        pthread_mutex_unlock(&jobs->sleep_mutex);
+    }
+}
+
+static JobDecl*
+jobs_get(JobSystem* jobs, JobWorker* worker)
+{
+    if (atomic_load(&jobs->queued) == 0) {
+        return NULL;
+    }
+
+    // Own jobs first, the newest are the most likely to be in cache
+    JobDecl* job = worker ? job_deque_take(worker->deque) : NULL;
+
+    if (job == NULL) {
+        pthread_mutex_lock(&jobs->queue_mutex);
+        job = jobs->queue_head;
+        if (job) {
+            jobs->queue_head = job->next;
+            if (jobs->queue_head == NULL) {
+                jobs->queue_tail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&jobs->queue_mutex);
+    }
+
+    if (job == NULL && jobs->thread_count > 0) {
+        // Steal the oldest job of a random victim, the oldest tend to be the largest
+        uint32_t random = steal_random;
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        steal_random = random;
+
+        for (uint32_t i = 0; i < jobs->thread_count && job == NULL; i++) {
+            JobWorker* victim = &jobs->workers[(random + i) % jobs->thread_count];
+            if (victim != worker) {
+                job = job_deque_steal(victim->deque);
+            }
+        }
+    }
+
+    if (job) {
+        atomic_fetch_sub(&jobs->queued, 1);
+    }
+
+    return job;
+}
+
+static void
+jobs_execute(JobSystem* jobs, JobDecl* job, uint32_t thread_index)
+{
+    JobCounter* counter = job->counter;
+    job->function(job->data, thread_index);
+
+    // Not the last job, the counter can not be released by a waiter yet
+    int value = atomic_load(&counter->value);
+    while (value > 1) {
+        if (atomic_compare_exchange_weak(&counter->value, &value, value - 1)) {
+            return;
+        }
+    }
+
+    // The last job takes the jobs that wait on the counter. The lock keeps the counter
+    // alive until the list is taken, see vut_jobs_wait.
+    job_counter_lock(counter);
+    JobDecl* waiting = NULL;
+    if (atomic_fetch_sub(&counter->value, 1) == 1) {
+        waiting = counter->waiting;
+        counter->waiting = NULL;
+    }
+    job_counter_unlock(counter);
+
+    jobs_push(jobs, waiting);
+}
+
+static void
+jobs_pin(uint32_t index)
+{
+#ifdef __linux__
+    // Worker n gets core n, core 0 is left to the thread that created the system
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % (uint32_t)cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)index;
+#endif
+}
+
+static void*
+jobs_worker(void* data)
+{
+    JobWorker* worker = data;
+    JobSystem* jobs = worker->system;
+    current_worker = worker;
+    steal_random *= worker->index;
+
+    while (!atomic_load(&jobs->quit)) {
+        JobDecl* job = jobs_get(jobs, worker);
+        if (job) {
+            jobs_execute(jobs, job, worker->index);
+            continue;
+        }
+
+        pthread_mutex_lock(&jobs->sleep_mutex);
+        atomic_fetch_add(&jobs->sleeping, 1);
+        if (atomic_load(&jobs->queued) == 0 && !atomic_load(&jobs->quit)) {
+            pthread_cond_wait(&jobs->wake, &jobs->sleep_mutex);
+        }
+        atomic_fetch_sub(&jobs->sleeping, 1);
+        pthread_mutex_unlock(&jobs->sleep_mutex);
+    }
+
+    return NULL;
+}
+
+// Pinning happens on the worker itself, so it is done before the first job
+typedef struct
+{
+    JobWorker* worker;
+    bool pin;
+} JobWorkerStart;
+
+static void*
+jobs_worker_start(void* data)
+{
+    JobWorkerStart start = *(JobWorkerStart*)data;
+    free(data);
+    if (start.pin) {
+        jobs_pin(start.worker->index);
+    }
+    return jobs_worker(start.worker);
+}
+
+bool
+vut_jobs_init(uint32_t thread_count, bool pin, JobSystem* jobs)
+{
+    memset(jobs, 0, sizeof(*jobs));
+
+    if (thread_count == 0) {
+        // Leave one core for the calling thread, but always have at least one worker
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cores > 1 ? (uint32_t)cores - 1 : 1;
+    }
+    if (thread_count > VUT_MAX_JOB_THREADS) {
+        thread_count = VUT_MAX_JOB_THREADS;
+    }
+
+    pthread_mutex_init(&jobs->queue_mutex, NULL);
+    pthread_mutex_init(&jobs->sleep_mutex, NULL);
+    pthread_cond_init(&jobs->wake, NULL);
+
+    // Every deque exists before a worker can steal from it
+    for (uint32_t i = 0; i < thread_count; i++) {
+        JobWorker* worker = &jobs->workers[i];
+        worker->system = jobs;
+        worker->index = i + 1;
+        worker->deque = aligned_alloc(64, sizeof(JobDeque));
+        if (worker->deque == NULL) {
+            thread_count = i;
+            break;
+        }
+        memset(worker->deque, 0, sizeof(JobDeque));
+    }
+    jobs->thread_count = thread_count;
+
+    uint32_t started = 0;
+    for (; started < thread_count; started++) {
+        JobWorkerStart* start = malloc(sizeof(JobWorkerStart));
+        if (start == NULL) {
+            break;
+        }
+        start->worker = &jobs->workers[started];
+        start->pin = pin;
+        if (pthread_create(&jobs->workers[started].thread, NULL, jobs_worker_start, start) !=
+            0) {
+            free(start);
+            break;
+        }
+    }
+
+    if (started < thread_count || thread_count == 0) {
+        // Workers that did not start must not be stolen from either, join the started ones
+        // and free every deque
+        jobs->thread_count = started;
+        vut_jobs_destroy(jobs);
+        return false;
+    }
+
+    return true;
+}
+
+void
+vut_jobs_run(JobSystem* jobs, JobDecl decls[], uint32_t count, JobCounter* counter)
+{
+    if (count == 0) {
+        return;
+    }
+
+    atomic_fetch_add(&counter->value, (int)count);
+    for (uint32_t i = 0; i < count; i++) {
+        decls[i].counter = counter;
+        decls[i].next = i + 1 < count ? &decls[i + 1] : NULL;
+    }
+
+    jobs_push(jobs, decls);
+}
+
+void
+vut_jobs_run_after(JobSystem* jobs,
+                   JobCounter* dependency,
+                   JobDecl decls[],
+                   uint32_t count,
+                   JobCounter* counter)
+{
+    if (count == 0) {
+        return;
+    }
+
+    atomic_fetch_add(&counter->value, (int)count);
+    for (uint32_t i = 0; i < count; i++) {
+        decls[i].counter = counter;
+        decls[i].next = i + 1 < count ? &decls[i + 1] : NULL;
+    }
+
+    // The last job of the dependency takes the list under the same lock
+    job_counter_lock(dependency);
+    bool ready = atomic_load(&dependency->value) == 0;
+    if (!ready) {
+        decls[count - 1].next = dependency->waiting;
+        dependency->waiting = decls;
+    }
+    job_counter_unlock(dependency);
+
+    if (ready) {
+        jobs_push(jobs, decls);
+    }
+}
+
+void
+vut_jobs_wait(JobSystem* jobs, JobCounter* counter)
+{
+    JobWorker* worker = current_worker && current_worker->system == jobs ? current_worker
+                                                                         : NULL;
+    uint32_t thread_index = worker ? worker->index : 0;
+
+    while (atomic_load(&counter->value) > 0) {
+        JobDecl* job = jobs_get(jobs, worker);
+        if (job) {
+            jobs_execute(jobs, job, thread_index);
+        } else {
+            // The remaining jobs run on other threads
+            sched_yield();
+        }
+    }
+
+    // The last job may still hold the lock, the counter can go once it lets go
+    job_counter_lock(counter);
+    job_counter_unlock(counter);
+}
+
+bool
+vut_jobs_done(const JobCounter* counter)
+{
+    return atomic_load(&counter->value) == 0 && !atomic_load(&counter->locked);
+}
+
+void
+vut_jobs_destroy(JobSystem* jobs)
+{
+    pthread_mutex_lock(&jobs->sleep_mutex);
+    atomic_store(&jobs->quit, true);
+    pthread_cond_broadcast(&jobs->wake);
+    pthread_mutex_unlock(&jobs->sleep_mutex);
+
+    for (uint32_t i = 0; i < jobs->thread_count; i++) {
+        pthread_join(jobs->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&jobs->wake);
+    pthread_mutex_destroy(&jobs->sleep_mutex);
+    pthread_mutex_destroy(&jobs->queue_mutex);
+
+    for (uint32_t i = 0; i < VUT_MAX_JOB_THREADS; i++) {
+        free(jobs->workers[i].deque);
+    }
+
+    memset(jobs, 0, sizeof(*jobs));
+}
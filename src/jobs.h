@@ -0,0 +1,165 @@
+/**
+ * @file jobs.h
+ * @brief Work stealing job system shared by the subsystems of the renderer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VUT_MAX_JOB_THREADS 32
+
+// Jobs a worker can hold in its own deque, more spill to the shared queue
+#define VUT_JOB_DEQUE_SIZE 4096
+
+/**
+ * @brief Work of a job
+ *
+ * @param[in] data The data of the job declaration
+ * @param[in] thread_index 1 to the thread count on the workers, 0 on any other thread that
+ * helps while it waits. Index per thread data with it, like command pools.
+ */
+typedef void (*JobFunction)(void* data, uint32_t thread_index);
+
+/**
+ * @brief Counts the unfinished jobs it was given to. Zero initialize, it can be reused
+ * once it is back at zero. Jobs run after a counter wait in its list until it reaches zero.
+ */
+typedef struct
+{
+    atomic_int value;
+    atomic_bool locked;
+    struct JobDecl* waiting;
+} JobCounter;
+
+/**
+ * @brief A job to run. Owned by the caller, it must stay valid until its counter reaches
+ * zero, which the system only touches through the pointers.
+ */
+typedef struct JobDecl
+{
+    JobFunction function;
+    void* data;
+
+    // Set by the system
+    JobCounter* counter;
+    struct JobDecl* next;
+} JobDecl;
+
+/**
+ * @brief Chase-Lev deque. The owning worker pushes and takes at the bottom, other threads
+ * steal from the top.
+ */
+typedef struct
+{
+    _Alignas(64) atomic_llong top;
+    _Alignas(64) atomic_llong bottom;
+    _Atomic(JobDecl*) jobs[VUT_JOB_DEQUE_SIZE];
+} JobDeque;
+
+typedef struct JobWorker
+{
+    struct JobSystem* system;
+    uint32_t index;
+    pthread_t thread;
+    JobDeque* deque;
+} JobWorker;
+
+/**
+ * @brief Worker threads that run jobs from their own deques and steal from each other when
+ * they run dry. Threads outside the pool submit to a shared queue and run jobs while they
+ * wait on a counter, so waiting never wastes a core.
+ */
+typedef struct JobSystem
+{
+    uint32_t thread_count;
+    JobWorker workers[VUT_MAX_JOB_THREADS];
+
+    // Jobs submitted by threads outside the pool, and those that overflow a deque
+    pthread_mutex_t queue_mutex;
+    JobDecl* queue_head;
+    JobDecl* queue_tail;
+
+    // Jobs in any queue, checked before a worker goes to sleep
+    atomic_int queued;
+
+    pthread_mutex_t sleep_mutex;
+    pthread_cond_t wake;
+    atomic_int sleeping;
+    atomic_bool quit;
+} JobSystem;
+
+/**
+ * @brief Start the workers
+ *
+ * @param[in] thread_count Amount of workers, 0 uses one per core minus the calling thread
+ * @param[in] pin Pin every worker to its own core, so the scheduler does not move them
+ * @param[out] jobs The job system
+ * @return true The workers have started
+ */
+bool
+vut_jobs_init(uint32_t thread_count, bool pin, JobSystem* jobs);
+
+/**
+ * @brief Queue jobs. The counter is raised by the count now and lowered as each job ends.
+ *
+ * @param[in] jobs The job system
+ * @param[in] decls The jobs, must stay valid until the counter reaches zero
+ * @param[in] count Amount of jobs
+ * @param[in] counter Counter to wait on the jobs with, may be shared with other batches
+ */
+void
+vut_jobs_run(JobSystem* jobs, JobDecl decls[], uint32_t count, JobCounter* counter);
+
+/**
+ * @brief Queue jobs that start once a dependency has reached zero, without blocking
+ *
+ * @param[in] jobs The job system
+ * @param[in] dependency Counter of the jobs to run after
+ * @param[in] decls The jobs, must stay valid until the counter reaches zero
+ * @param[in] count Amount of jobs
+ * @param[in] counter Counter to wait on the jobs with, not the dependency
+ */
+void
+vut_jobs_run_after(JobSystem* jobs,
+                   JobCounter* dependency,
+                   JobDecl decls[],
+                   uint32_t count,
+                   JobCounter* counter);
+
+/**
+ * @brief Run jobs until the counter reaches zero. Jobs may wait on the jobs they run.
+ *
+ * @param[in] jobs The job system
+ * @param[in] counter The counter
+ */
+void
+vut_jobs_wait(JobSystem* jobs, JobCounter* counter);
+
+/**
+ * @brief Check if every job of a counter has finished
+ *
+ * @param[in] counter The counter
+ * @return true The jobs are done
+ */
+bool
+vut_jobs_done(const JobCounter* counter);
+
+/**
+ * @brief Stop the workers. Every counter must have been waited on first.
+ *
+ * @param[in] jobs The job system
+ */
+void
+vut_jobs_destroy(JobSystem* jobs);
+
+#endif // JOBS_H
@@ -0,0 +1,216 @@
+/**
+ * @file layout_cache.c
+ * @brief Deduplicating cache for descriptor set layouts and pipeline layouts
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "layout_cache.h"
+#include "vk_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t
+hash_bindings(uint32_t count, const VkDescriptorSetLayoutBinding bindings[])
+{
+    // Hash field by field, the structs contain padding and a pointer
+    uint64_t hash = vut_hash(&count, sizeof(count), VUT_HASH_SEED);
+    for (uint32_t i = 0; i < count; i++) {
+        hash = vut_hash(&bindings[i].binding, sizeof(bindings[i].binding), hash);
+        hash = vut_hash(&bindings[i].descriptorType, sizeof(bindings[i].descriptorType), hash);
+        hash = vut_hash(&bindings[i].descriptorCount, sizeof(bindings[i].descriptorCount), hash);
+        hash = vut_hash(&bindings[i].stageFlags, sizeof(bindings[i].stageFlags), hash);
+    }
+
+    return hash;
+}
+
+static bool
+bindings_equal(uint32_t count,
+               const VkDescriptorSetLayoutBinding a[],
+               const VkDescriptorSetLayoutBinding b[])
+{
+    for (uint32_t i = 0; i < count; i++) {
+        if (a[i].binding != b[i].binding || a[i].descriptorType != b[i].descriptorType ||
+            a[i].descriptorCount != b[i].descriptorCount || a[i].stageFlags != b[i].stageFlags) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+vut_layout_cache_init(VkDevice device, bool descriptor_buffer, LayoutCache* cache)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->device = device;
+    cache->descriptor_buffer = descriptor_buffer;
+}
+
+VkResult
+vut_layout_cache_get_set_layout(LayoutCache* cache,
+                                const ReflectedSet* set,
+                                VkDescriptorSetLayout* layout)
+{
+    // A runtime array outside the bindless set has no count to create the layout with
+    for (uint32_t i = 0; i < set->binding_count; i++) {
+        if (set->unsized && set->bindings[i].descriptorCount == 0) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    uint64_t hash = hash_bindings(set->binding_count, set->bindings);
+    hash = vut_hash(&set->unsized, sizeof(set->unsized), hash);
+
+    uint32_t cursor = 0;
+    uint32_t index;
+    while ((index = vut_hash_index_find(&cache->set_layout_index, hash, &cursor)) != UINT32_MAX) {
+        const CachedSetLayout* cached = &cache->set_layouts[index];
+        if (cached->binding_count == set->binding_count &&
+            cached->update_after_bind == set->unsized &&
+            bindings_equal(set->binding_count, cached->bindings, set->bindings)) {
+            *layout = cached->layout;
+            return VK_SUCCESS;
+        }
+    }
+
+    // Descriptors in a buffer can always be written while bound
+    VkDescriptorSetLayoutCreateFlags flags = 0;
+    if (cache->descriptor_buffer) {
+        flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+    } else if (set->unsized) {
+        flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    }
+
+    VkResult result = vut_init_descriptor_set_layout(cache->device, set->binding_count,
+                                                     set->bindings, flags, layout);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    if (cache->set_layout_count == cache->set_layout_capacity) {
+        uint32_t capacity = cache->set_layout_capacity ? cache->set_layout_capacity * 2 : 8;
+        CachedSetLayout* set_layouts =
+            realloc(cache->set_layouts, capacity * sizeof(CachedSetLayout));
+        if (set_layouts == NULL) {
+            vkDestroyDescriptorSetLayout(cache->device, *layout, vut_get_allocator());
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        cache->set_layouts = set_layouts;
+        cache->set_layout_capacity = capacity;
+    }
+
+    // Only layouts in the index are destroyed with the cache
+    if (!vut_hash_index_insert(&cache->set_layout_index, hash, cache->set_layout_count)) {
+        vkDestroyDescriptorSetLayout(cache->device, *layout, vut_get_allocator());
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    CachedSetLayout* cached = &cache->set_layouts[cache->set_layout_count++];
+    cached->binding_count = set->binding_count;
+    cached->update_after_bind = set->unsized;
+    memcpy(cached->bindings, set->bindings, sizeof(cached->bindings));
+    cached->layout = *layout;
+
+    return VK_SUCCESS;
+}
+
+VkResult
+vut_layout_cache_get_pipeline_layout(LayoutCache* cache,
+                                     const ShaderReflection* reflection,
+                                     VkPipelineLayout* layout)
+{
+    CachedPipelineLayout key = { 0 };
+
+    key.set_layout_count = reflection->set_count;
+    for (uint32_t i = 0; i < reflection->set_count; i++) {
+        // Empty sets in between used sets still need a (empty) layout
+        VkResult result =
+            vut_layout_cache_get_set_layout(cache, &reflection->sets[i], &key.set_layouts[i]);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    key.push_constant_range_count = reflection->push_constant_range_count;
+    if (reflection->push_constant_range_count) {
+        key.push_constant_range = reflection->push_constant_range;
+    }
+
+    // Set layouts are deduplicated, so comparing handles is enough
+    uint64_t hash = vut_hash(&key.set_layout_count, sizeof(key.set_layout_count), VUT_HASH_SEED);
+    hash = vut_hash(key.set_layouts, key.set_layout_count * sizeof(VkDescriptorSetLayout), hash);
+    hash = vut_hash(&key.push_constant_range, sizeof(key.push_constant_range), hash);
+
+    uint32_t cursor = 0;
+    uint32_t index;
+    while ((index = vut_hash_index_find(&cache->pipeline_layout_index, hash, &cursor)) !=
+           UINT32_MAX) {
+        const CachedPipelineLayout* cached = &cache->pipeline_layouts[index];
+        if (cached->set_layout_count == key.set_layout_count &&
+            cached->push_constant_range_count == key.push_constant_range_count &&
+            memcmp(cached->set_layouts, key.set_layouts,
+                   key.set_layout_count * sizeof(VkDescriptorSetLayout)) == 0 &&
+            memcmp(&cached->push_constant_range, &key.push_constant_range,
+                   sizeof(key.push_constant_range)) == 0) {
+            *layout = cached->layout;
+            return VK_SUCCESS;
+        }
+    }
+
+    VkResult result = vut_init_pipeline_layout(
+        cache->device, key.set_layout_count, key.set_layouts, key.push_constant_range_count,
+        &key.push_constant_range, &key.layout);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    if (cache->pipeline_layout_count == cache->pipeline_layout_capacity) {
+        uint32_t capacity =
+            cache->pipeline_layout_capacity ? cache->pipeline_layout_capacity * 2 : 8;
+        CachedPipelineLayout* pipeline_layouts =
+            realloc(cache->pipeline_layouts, capacity * sizeof(CachedPipelineLayout));
+        if (pipeline_layouts == NULL) {
+            vkDestroyPipelineLayout(cache->device, key.layout, vut_get_allocator());
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        cache->pipeline_layouts = pipeline_layouts;
+        cache->pipeline_layout_capacity = capacity;
+    }
+
+    if (!vut_hash_index_insert(&cache->pipeline_layout_index, hash,
+                               cache->pipeline_layout_count)) {
+        vkDestroyPipelineLayout(cache->device, key.layout, vut_get_allocator());
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    cache->pipeline_layouts[cache->pipeline_layout_count++] = key;
+
+    *layout = key.layout;
+    return VK_SUCCESS;
+}
+
+void
+vut_layout_cache_destroy(LayoutCache* cache)
+{
+    for (uint32_t i = 0; i < cache->pipeline_layout_count; i++) {
+        vkDestroyPipelineLayout(cache->device, cache->pipeline_layouts[i].layout,
+                                vut_get_allocator());
+    }
+
+    for (uint32_t i = 0; i < cache->set_layout_count; i++) {
+        vkDestroyDescriptorSetLayout(cache->device, cache->set_layouts[i].layout,
+                                     vut_get_allocator());
+    }
+
+    free(cache->pipeline_layouts);
+    free(cache->set_layouts);
+    vut_hash_index_free(&cache->pipeline_layout_index);
+    vut_hash_index_free(&cache->set_layout_index);
+
+    memset(cache, 0, sizeof(*cache));
+}
@@ -0,0 +1,104 @@
+/**
+ * @file layout_cache.h
+ * @brief Deduplicating cache for descriptor set layouts and pipeline layouts
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+#include "hash.h"
+#include "spirv_reflect.h"
+
+typedef struct
+{
+    uint32_t binding_count;
+    VkDescriptorSetLayoutBinding bindings[VUT_MAX_SET_BINDINGS];
+    bool update_after_bind;
+    VkDescriptorSetLayout layout;
+} CachedSetLayout;
+
+typedef struct
+{
+    uint32_t set_layout_count;
+    VkDescriptorSetLayout set_layouts[VUT_MAX_DESCRIPTOR_SETS];
+    uint32_t push_constant_range_count;
+    VkPushConstantRange push_constant_range;
+    VkPipelineLayout layout;
+} CachedPipelineLayout;
+
+/**
+ * @brief Layouts are owned by the cache and live until the cache is destroyed.
+ * Pipelines with compatible interfaces get the same VkPipelineLayout so descriptor
+ * sets stay bound when switching between them.
+ */
+typedef struct
+{
+    VkDevice device;
+
+    // Every set layout is created for VK_EXT_descriptor_buffer instead of descriptor pools
+    bool descriptor_buffer;
+
+    uint32_t set_layout_count;
+    uint32_t set_layout_capacity;
+    CachedSetLayout* set_layouts;
+    HashIndex set_layout_index;
+
+    uint32_t pipeline_layout_count;
+    uint32_t pipeline_layout_capacity;
+    CachedPipelineLayout* pipeline_layouts;
+    HashIndex pipeline_layout_index;
+} LayoutCache;
+
+/**
+ * @brief Initialize an empty cache
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] descriptor_buffer Create set layouts for descriptor buffers, pipelines using
+ * them need VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+ * @param[out] cache The cache
+ */
+void
+vut_layout_cache_init(VkDevice device, bool descriptor_buffer, LayoutCache* cache);
+
+/**
+ * @brief Get or create a descriptor set layout for a set of bindings. Sets with a runtime
+ * array become update after bind sets, see BindlessTable.
+ *
+ * @param[in] cache The layout cache
+ * @param[in] set The reflected bindings of the set
+ * @param[out] layout The cached layout
+ * @return VkResult
+ */
+VkResult
+vut_layout_cache_get_set_layout(LayoutCache* cache,
+                                const ReflectedSet* set,
+                                VkDescriptorSetLayout* layout);
+
+/**
+ * @brief Get or create a pipeline layout with the set layouts and push constant range
+ * of a shader interface
+ *
+ * @param[in] cache The layout cache
+ * @param[in] reflection The merged reflection of all stages of the pipeline
+ * @param[out] layout The cached layout
+ * @return VkResult
+ */
+VkResult
+vut_layout_cache_get_pipeline_layout(LayoutCache* cache,
+                                     const ShaderReflection* reflection,
+                                     VkPipelineLayout* layout);
+
+/**
+ * @brief Destroy all layouts in the cache
+ *
+ * @param[in] cache The layout cache
+ */
+void
+vut_layout_cache_destroy(LayoutCache* cache);
+
+#endif // LAYOUT_CACHE_H
@@ -0,0 +1,128 @@
+/**
+ * @file memory_budget.c
+ * @brief Per heap device memory usage and budget, with a hook for over budget heaps
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "memory_budget.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void
+vut_memory_budget_init(VkPhysicalDevice gpu, bool use_extension, MemoryBudget* budget)
+{
+    memset(budget, 0, sizeof(*budget));
+    budget->gpu = gpu;
+    budget->use_extension = use_extension;
+
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(gpu, &properties);
+
+    budget->heap_count = properties.memoryHeapCount;
+    for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+        budget->heap_sizes[i] = properties.memoryHeaps[i].size;
+    }
+    for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+        budget->type_heaps[i] = properties.memoryTypes[i].heapIndex;
+    }
+
+    vut_memory_budget_update(budget);
+}
+
+void
+vut_memory_budget_set_policy(MemoryBudget* budget,
+                             float threshold,
+                             MemoryPressureCallback callback,
+                             void* user_data)
+{
+    budget->threshold = threshold;
+    budget->callback = callback;
+    budget->user_data = user_data;
+}
+
+bool
+vut_memory_budget_track(MemoryBudget* budget,
+                        VkDeviceMemory memory,
+                        uint32_t type_index,
+                        VkDeviceSize size)
+{
+    if (budget->allocation_count == budget->allocation_capacity) {
+        uint32_t capacity = budget->allocation_capacity ? budget->allocation_capacity * 2 : 16;
+        TrackedAllocation* allocations =
+            realloc(budget->allocations, capacity * sizeof(TrackedAllocation));
+        if (allocations == NULL) {
+            return false;
+        }
+        budget->allocations = allocations;
+        budget->allocation_capacity = capacity;
+    }
+
+    uint32_t heap_index = budget->type_heaps[type_index];
+    budget->allocations[budget->allocation_count++] = (TrackedAllocation){
+        .memory = memory,
+        .heap_index = heap_index,
+        .size = size,
+    };
+    budget->tracked[heap_index] += size;
+    return true;
+}
+
+void
+vut_memory_budget_untrack(MemoryBudget* budget, VkDeviceMemory memory)
+{
+    for (uint32_t i = 0; i < budget->allocation_count; i++) {
+        if (budget->allocations[i].memory == memory) {
+            budget->tracked[budget->allocations[i].heap_index] -= budget->allocations[i].size;
+            budget->allocations[i] = budget->allocations[--budget->allocation_count];
+            return;
+        }
+    }
+}
+
+void
+vut_memory_budget_update(MemoryBudget* budget)
+{
+    if (budget->use_extension) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+            .pNext = NULL,
+        };
+        VkPhysicalDeviceMemoryProperties2 properties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+            .pNext = &budget_properties,
+        };
+        vkGetPhysicalDeviceMemoryProperties2(budget->gpu, &properties);
+
+        memcpy(budget->usage, budget_properties.heapUsage, sizeof(budget->usage));
+        memcpy(budget->budget, budget_properties.heapBudget, sizeof(budget->budget));
+    } else {
+        // Other processes and the driver also use the heaps, leave them some room
+        for (uint32_t i = 0; i < budget->heap_count; i++) {
+            budget->usage[i] = budget->tracked[i];
+            budget->budget[i] = budget->heap_sizes[i] / 5 * 4;
+        }
+    }
+
+    if (budget->callback == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < budget->heap_count; i++) {
+        if (budget->usage[i] > (VkDeviceSize)(budget->budget[i] * budget->threshold)) {
+            budget->callback(i, budget->usage[i], budget->budget[i], budget->user_data);
+        }
+    }
+}
+
+void
+vut_memory_budget_destroy(MemoryBudget* budget)
+{
+    free(budget->allocations);
+
+    memset(budget, 0, sizeof(*budget));
+}
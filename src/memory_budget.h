@@ -0,0 +1,134 @@
+/**
+ * @file memory_budget.h
+ * @brief Per heap device memory usage and budget, with a hook for over budget heaps
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief Called by vut_memory_budget_update for every heap whose usage is above the
+ * threshold. Free or downsize streamable resources here, the next update sees the result.
+ *
+ * @param[in] heap_index The heap that is over the threshold
+ * @param[in] usage Bytes in use on the heap
+ * @param[in] budget Bytes the process can use on the heap before the driver starts paging
+ * @param[in] user_data The pointer given with the policy
+ */
+typedef void (*MemoryPressureCallback)(uint32_t heap_index,
+                                       VkDeviceSize usage,
+                                       VkDeviceSize budget,
+                                       void* user_data);
+
+typedef struct
+{
+    VkDeviceMemory memory;
+    uint32_t heap_index;
+    VkDeviceSize size;
+} TrackedAllocation;
+
+/**
+ * @brief Usage and budget of every memory heap. With VK_EXT_memory_budget they come from
+ * the driver, otherwise from the allocations made through vut_allocate_memory with a
+ * budget of 80% of the heap size.
+ */
+typedef struct
+{
+    VkPhysicalDevice gpu;
+    bool use_extension;
+
+    uint32_t heap_count;
+    VkDeviceSize heap_sizes[VK_MAX_MEMORY_HEAPS];
+    uint32_t type_heaps[VK_MAX_MEMORY_TYPES];
+
+    // Updated by vut_memory_budget_update
+    VkDeviceSize usage[VK_MAX_MEMORY_HEAPS];
+    VkDeviceSize budget[VK_MAX_MEMORY_HEAPS];
+
+    // Own accounting, allocations are few so they are kept in a plain array
+    VkDeviceSize tracked[VK_MAX_MEMORY_HEAPS];
+    uint32_t allocation_count;
+    uint32_t allocation_capacity;
+    TrackedAllocation* allocations;
+
+    // Policy, the callback runs when usage goes above threshold * budget
+    float threshold;
+    MemoryPressureCallback callback;
+    void* user_data;
+} MemoryBudget;
+
+/**
+ * @brief Initialize the budget of a device without any allocations
+ *
+ * @param[in] gpu The physical device
+ * @param[in] use_extension VK_EXT_memory_budget is enabled on the device
+ * @param[out] budget The memory budget
+ */
+void
+vut_memory_budget_init(VkPhysicalDevice gpu, bool use_extension, MemoryBudget* budget);
+
+/**
+ * @brief Set the policy that is run by vut_memory_budget_update
+ *
+ * @param[in] budget The memory budget
+ * @param[in] threshold Fraction of the budget above which the callback runs
+ * @param[in] callback The callback, NULL to disable the policy
+ * @param[in] user_data Passed to the callback
+ */
+void
+vut_memory_budget_set_policy(MemoryBudget* budget,
+                             float threshold,
+                             MemoryPressureCallback callback,
+                             void* user_data);
+
+/**
+ * @brief Count an allocation against the heap of its memory type
+ *
+ * @param[in] budget The memory budget
+ * @param[in] memory The allocated memory
+ * @param[in] type_index The memory type it was allocated from
+ * @param[in] size Size of the allocation
+ * @return true on success, false when the allocation can not be stored
+ */
+bool
+vut_memory_budget_track(MemoryBudget* budget,
+                        VkDeviceMemory memory,
+                        uint32_t type_index,
+                        VkDeviceSize size);
+
+/**
+ * @brief Stop counting an allocation, unknown memory is ignored
+ *
+ * @param[in] budget The memory budget
+ * @param[in] memory The memory that is freed
+ */
+void
+vut_memory_budget_untrack(MemoryBudget* budget, VkDeviceMemory memory);
+
+/**
+ * @brief Refresh usage and budget of every heap and run the policy. Call once per frame.
+ *
+ * @param[in] budget The memory budget
+ */
+void
+vut_memory_budget_update(MemoryBudget* budget);
+
+/**
+ * @brief Free the accounting, the allocations themselves are not freed
+ *
+ * @param[in] budget The memory budget
+ */
+void
+vut_memory_budget_destroy(MemoryBudget* budget);
+
+#endif // MEMORY_BUDGET_H
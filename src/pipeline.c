@@ -0,0 +1,903 @@
+/**
+ * @file pipeline.c
+ * @brief Graphics pipeline descriptions and jobs to compile them
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "pipeline.h"
+#include "vk_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+shader_program_setup_draw_data(ShaderProgram* program,
+                               uint32_t max_push_constants_size,
+                               bool descriptor_buffer)
+{
+    ShaderReflection* reflection = &program->reflection;
+
+    const VkPushConstantRange* range = &reflection->push_constant_range;
+    if (reflection->push_constant_range_count &&
+        range->offset + range->size > max_push_constants_size) {
+        program->draw_data_in_buffer = true;
+        reflection->push_constant_range_count = 0;
+        memset(&reflection->push_constant_range, 0, sizeof(reflection->push_constant_range));
+    }
+
+    // Every draw binds the same buffer at a different offset. Descriptor buffers have no
+    // dynamic descriptors, every draw writes its own descriptor instead.
+    if (reflection->set_count > VUR_DRAW_DATA_SET && !descriptor_buffer) {
+        ReflectedSet* set = &reflection->sets[VUR_DRAW_DATA_SET];
+        for (uint32_t i = 0; i < set->binding_count; i++) {
+            if (set->bindings[i].binding == VUR_DRAW_DATA_BINDING &&
+                set->bindings[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+                set->bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+        }
+    }
+}
+
+VkResult
+vur_reflection_use_bindless(ShaderReflection* reflection, const ReflectedSet* bindless_set)
+{
+    if (reflection->set_count <= VUR_BINDLESS_SET ||
+        reflection->sets[VUR_BINDLESS_SET].binding_count == 0) {
+        return VK_SUCCESS;
+    }
+
+    if (bindless_set == NULL) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    // The shaders may declare only some of the arrays, but they must match the table
+    const ReflectedSet* set = &reflection->sets[VUR_BINDLESS_SET];
+    for (uint32_t i = 0; i < set->binding_count; i++) {
+        const VkDescriptorSetLayoutBinding* binding = &set->bindings[i];
+        if (binding->binding >= bindless_set->binding_count ||
+            bindless_set->bindings[binding->binding].descriptorType != binding->descriptorType) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    // Every program gets the same set layout, so the set stays bound across pipelines
+    reflection->sets[VUR_BINDLESS_SET] = *bindless_set;
+
+    return VK_SUCCESS;
+}
+
+VkResult
+vur_init_shader_program(VkDevice device,
+                        LayoutCache* layout_cache,
+                        uint32_t max_push_constants_size,
+                        const ReflectedSet* bindless_set,
+                        const uint32_t vert_code[],
+                        size_t vert_size,
+                        const uint32_t frag_code[],
+                        size_t frag_size,
+                        ShaderProgram* program)
+{
+    memset(program, 0, sizeof(*program));
+    if (layout_cache->descriptor_buffer) {
+        program->create_flags = VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+    }
+
+    // Derive the pipeline interface from the shaders themselves
+    ShaderReflection frag_reflection;
+    VkResult result = vut_reflect_shader(vert_code, vert_size, &program->reflection);
+    if (result == VK_SUCCESS) {
+        result = vut_reflect_shader(frag_code, frag_size, &frag_reflection);
+    }
+    if (result == VK_SUCCESS) {
+        result = vut_reflect_merge(&program->reflection, &frag_reflection);
+    }
+    if (result == VK_SUCCESS) {
+        shader_program_setup_draw_data(program, max_push_constants_size,
+                                       layout_cache->descriptor_buffer);
+        result = vur_reflection_use_bindless(&program->reflection, bindless_set);
+    }
+    if (result == VK_SUCCESS) {
+        result = vut_layout_cache_get_pipeline_layout(layout_cache, &program->reflection,
+                                                      &program->layout);
+    }
+    if (result == VK_SUCCESS) {
+        result = vut_init_shader_module(device, vert_code, vert_size, &program->vert_module);
+    }
+    if (result == VK_SUCCESS) {
+        result = vut_init_shader_module(device, frag_code, frag_size, &program->frag_module);
+    }
+
+    if (result != VK_SUCCESS) {
+        vur_destroy_shader_program(device, program);
+    }
+
+    return result;
+}
+
+void
+vur_destroy_shader_program(VkDevice device, ShaderProgram* program)
+{
+    vkDestroyShaderModule(device, program->vert_module, vut_get_allocator());
+    vkDestroyShaderModule(device, program->frag_module, vut_get_allocator());
+    program->vert_module = VK_NULL_HANDLE;
+    program->frag_module = VK_NULL_HANDLE;
+}
+
+void
+vur_pipeline_desc_init(const ShaderProgram* program,
+                       VkRenderPass render_pass,
+                       VkFormat color_format,
+                       PipelineDesc* desc)
+{
+    memset(desc, 0, sizeof(*desc));
+
+    desc->program = program;
+    desc->render_pass = render_pass;
+    desc->color_format = color_format;
+    desc->topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    desc->polygon_mode = VK_POLYGON_MODE_FILL;
+    desc->cull_mode = VK_CULL_MODE_BACK_BIT;
+    desc->front_face = VK_FRONT_FACE_CLOCKWISE;
+    desc->blend_enable = VK_FALSE;
+    desc->features = 0;
+}
+
+// Field by field, descriptions are copied and assigned so their padding is not defined
+static uint64_t
+pipeline_desc_hash(const PipelineDesc* desc, uint64_t seed)
+{
+    uint64_t hash = vut_hash(&desc->program, sizeof(desc->program), seed);
+    hash = vut_hash(&desc->render_pass, sizeof(desc->render_pass), hash);
+    hash = vut_hash(&desc->color_format, sizeof(desc->color_format), hash);
+    hash = vut_hash(&desc->topology, sizeof(desc->topology), hash);
+    hash = vut_hash(&desc->polygon_mode, sizeof(desc->polygon_mode), hash);
+    hash = vut_hash(&desc->cull_mode, sizeof(desc->cull_mode), hash);
+    hash = vut_hash(&desc->front_face, sizeof(desc->front_face), hash);
+    hash = vut_hash(&desc->blend_enable, sizeof(desc->blend_enable), hash);
+    return vut_hash(&desc->features, sizeof(desc->features), hash);
+}
+
+static bool
+pipeline_desc_equal(const PipelineDesc* a, const PipelineDesc* b)
+{
+    return a->program == b->program && a->render_pass == b->render_pass &&
+           a->color_format == b->color_format && a->topology == b->topology &&
+           a->polygon_mode == b->polygon_mode && a->cull_mode == b->cull_mode &&
+           a->front_face == b->front_face && a->blend_enable == b->blend_enable &&
+           a->features == b->features;
+}
+
+// Every create info of a pipeline. Lives on the stack of the caller since the
+// create infos point into the struct itself.
+typedef struct
+{
+    VkPipelineShaderStageCreateInfo stages[2];
+    VkVertexInputBindingDescription vertex_binding;
+    VkPipelineVertexInputStateCreateInfo vertex_input;
+    VkPipelineInputAssemblyStateCreateInfo input_assembly;
+    VkPipelineViewportStateCreateInfo viewport_state;
+    VkPipelineRasterizationStateCreateInfo rasterizer;
+    VkPipelineMultisampleStateCreateInfo multisampling;
+    VkPipelineColorBlendAttachmentState color_blend_attachment;
+    VkPipelineColorBlendStateCreateInfo color_blending;
+    VkDynamicState dynamic_states[2];
+    VkPipelineDynamicStateCreateInfo dynamic_state;
+    VkSpecializationMapEntry spec_entries[VUT_MAX_SPEC_CONSTANTS];
+    uint32_t spec_data[VUT_MAX_SPEC_CONSTANTS];
+    VkSpecializationInfo specialization;
+    VkFormat color_format;
+    VkPipelineRenderingCreateInfoKHR rendering;
+
+    // Chained on the create info, NULL when the pipeline uses a render pass
+    const VkPipelineRenderingCreateInfoKHR* next;
+} PipelineState;
+
+void
+vur_get_specialization(const ShaderProgram* program,
+                       ShaderFeatureFlags features,
+                       VkSpecializationMapEntry entries[],
+                       uint32_t data[],
+                       VkSpecializationInfo* info)
+{
+    const ShaderReflection* reflection = &program->reflection;
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < reflection->spec_constant_count; i++) {
+        const VkSpecializationMapEntry* constant = &reflection->spec_constants[i];
+
+        // Bools are 32 bit in Vulkan, so every feature constant is one word
+        uint32_t value;
+        switch (constant->constantID) {
+        case VUR_SPEC_FOG:
+            value = (features & VUR_FEATURE_FOG) ? VK_TRUE : VK_FALSE;
+            break;
+        case VUR_SPEC_ALPHA_TEST:
+            value = (features & VUR_FEATURE_ALPHA_TEST) ? VK_TRUE : VK_FALSE;
+            break;
+        case VUR_SPEC_LIGHT_COUNT:
+            value = (features & VUR_FEATURE_LIGHT_COUNT_MASK) >> VUR_FEATURE_LIGHT_COUNT_SHIFT;
+            break;
+        case VUR_SPEC_DRAW_DATA_IN_BUFFER:
+            value = program->draw_data_in_buffer ? VK_TRUE : VK_FALSE;
+            break;
+        case VUR_SPEC_TEXTURED:
+            value = (features & VUR_FEATURE_TEXTURED) ? VK_TRUE : VK_FALSE;
+            break;
+        default:
+            continue;
+        }
+
+        if (constant->size != sizeof(uint32_t)) {
+            continue;
+        }
+
+        entries[count] = (VkSpecializationMapEntry){
+            .constantID = constant->constantID,
+            .offset = count * sizeof(uint32_t),
+            .size = sizeof(uint32_t),
+        };
+        data[count++] = value;
+    }
+
+    *info = (VkSpecializationInfo){
+        .mapEntryCount = count,
+        .pMapEntries = entries,
+        .dataSize = count * sizeof(uint32_t),
+        .pData = data,
+    };
+}
+
+static void
+pipeline_state_init(const PipelineDesc* desc, PipelineState* state)
+{
+    const ShaderProgram* program = desc->program;
+
+    // Both stages share the constants, ids a stage does not declare are ignored
+    vur_get_specialization(program, desc->features, state->spec_entries, state->spec_data,
+                           &state->specialization);
+
+    state->stages[0] = (VkPipelineShaderStageCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = VK_SHADER_STAGE_VERTEX_BIT,
+        .module = program->vert_module,
+        .pName = "main",
+        .pSpecializationInfo = &state->specialization,
+    };
+
+    state->stages[1] = (VkPipelineShaderStageCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+        .module = program->frag_module,
+        .pName = "main",
+        .pSpecializationInfo = &state->specialization,
+    };
+
+    state->vertex_binding = (VkVertexInputBindingDescription){
+        .binding = 0,
+        .stride = program->reflection.vertex_stride,
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+    };
+
+    state->vertex_input = (VkPipelineVertexInputStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = program->reflection.vertex_attribute_count ? 1 : 0,
+        .pVertexBindingDescriptions = &state->vertex_binding,
+        .vertexAttributeDescriptionCount = program->reflection.vertex_attribute_count,
+        .pVertexAttributeDescriptions = program->reflection.vertex_attributes,
+    };
+
+    state->input_assembly = (VkPipelineInputAssemblyStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = desc->topology,
+        .primitiveRestartEnable = VK_FALSE,
+    };
+
+    // The actual viewport and scissor are set while recording
+    state->viewport_state = (VkPipelineViewportStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .pViewports = NULL,
+        .scissorCount = 1,
+        .pScissors = NULL,
+    };
+
+    state->rasterizer = (VkPipelineRasterizationStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = desc->polygon_mode,
+        .lineWidth = 1.0f,
+        .cullMode = desc->cull_mode,
+        .frontFace = desc->front_face,
+        .depthBiasEnable = VK_FALSE,
+    };
+
+    state->multisampling = (VkPipelineMultisampleStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .sampleShadingEnable = VK_FALSE,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+
+    state->color_blend_attachment = (VkPipelineColorBlendAttachmentState){
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                          VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+        .blendEnable = desc->blend_enable,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+    };
+
+    state->color_blending = (VkPipelineColorBlendStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = 1,
+        .pAttachments = &state->color_blend_attachment,
+        .blendConstants[0] = 0.0f,
+        .blendConstants[1] = 0.0f,
+        .blendConstants[2] = 0.0f,
+        .blendConstants[3] = 0.0f,
+    };
+
+    state->dynamic_states[0] = VK_DYNAMIC_STATE_VIEWPORT;
+    state->dynamic_states[1] = VK_DYNAMIC_STATE_SCISSOR;
+
+    state->dynamic_state = (VkPipelineDynamicStateCreateInfo){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = 2,
+        .pDynamicStates = state->dynamic_states,
+    };
+
+    state->color_format = desc->color_format;
+    state->rendering = (VkPipelineRenderingCreateInfoKHR){
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+        .viewMask = 0,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &state->color_format,
+        .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+    };
+    state->next = desc->render_pass == VK_NULL_HANDLE ? &state->rendering : NULL;
+}
+
+VkResult
+vur_create_pipeline(VkDevice device,
+                    VkPipelineCache cache,
+                    const PipelineDesc* desc,
+                    VkPipeline* pipeline)
+{
+    PipelineState state;
+    pipeline_state_init(desc, &state);
+
+    return vut_init_pipeline(device, cache, desc->program->create_flags, state.stages,
+                             &state.vertex_input, &state.input_assembly, &state.viewport_state,
+                             &state.rasterizer, &state.multisampling, &state.color_blending,
+                             &state.dynamic_state, desc->program->layout, desc->render_pass,
+                             state.next, pipeline);
+}
+
+// Libraries \\\
+
+// Clear the fields of a description that do not affect one part of the pipeline, so
+// descriptions that only differ in other parts share the library
+static void
+pipeline_library_key(const PipelineDesc* desc,
+                     VkGraphicsPipelineLibraryFlagsEXT part,
+                     PipelineDesc* key)
+{
+    memset(key, 0, sizeof(*key));
+
+    switch (part) {
+    case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+        key->program = desc->program;
+        key->topology = desc->topology;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+        key->program = desc->program;
+        key->render_pass = desc->render_pass;
+        key->color_format = desc->color_format;
+        key->polygon_mode = desc->polygon_mode;
+        key->cull_mode = desc->cull_mode;
+        key->front_face = desc->front_face;
+        key->features = desc->features;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+        key->program = desc->program;
+        key->render_pass = desc->render_pass;
+        key->color_format = desc->color_format;
+        key->features = desc->features;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+        key->render_pass = desc->render_pass;
+        key->color_format = desc->color_format;
+        key->blend_enable = desc->blend_enable;
+        break;
+    }
+}
+
+static VkResult
+pipeline_library_create(PipelineBuilder* builder,
+                        const PipelineDesc* desc,
+                        VkGraphicsPipelineLibraryFlagsEXT part,
+                        VkPipeline* library)
+{
+    PipelineState state;
+    pipeline_state_init(desc, &state);
+
+    VkGraphicsPipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = state.next,
+        .flags = desc->program->create_flags,
+        .layout = desc->program->layout,
+        .renderPass = desc->render_pass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    switch (part) {
+    case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+        create_info.pVertexInputState = &state.vertex_input;
+        create_info.pInputAssemblyState = &state.input_assembly;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+        create_info.stageCount = 1;
+        create_info.pStages = &state.stages[0];
+        create_info.pViewportState = &state.viewport_state;
+        create_info.pRasterizationState = &state.rasterizer;
+        create_info.pDynamicState = &state.dynamic_state;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+        create_info.stageCount = 1;
+        create_info.pStages = &state.stages[1];
+        create_info.pMultisampleState = &state.multisampling;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+        create_info.pMultisampleState = &state.multisampling;
+        create_info.pColorBlendState = &state.color_blending;
+        break;
+    }
+
+    return vut_init_pipeline_library(builder->device, builder->cache, part, &create_info,
+                                     library);
+}
+
+static PipelineLibrary*
+pipeline_library_find(PipelineBuilder* builder,
+                      VkGraphicsPipelineLibraryFlagsEXT part,
+                      const PipelineDesc* key,
+                      uint64_t hash)
+{
+    uint32_t cursor = 0;
+    uint32_t index;
+    while ((index = vut_hash_index_find(&builder->library_index, hash, &cursor)) != UINT32_MAX) {
+        PipelineLibrary* library = &builder->libraries[index];
+        if (library->part == part && pipeline_desc_equal(&library->key, key)) {
+            return library;
+        }
+    }
+
+    return NULL;
+}
+
+static VkResult
+pipeline_library_get(PipelineBuilder* builder,
+                     const PipelineDesc* desc,
+                     VkGraphicsPipelineLibraryFlagsEXT part,
+                     VkPipeline* library)
+{
+    PipelineDesc key;
+    pipeline_library_key(desc, part, &key);
+    uint64_t hash = pipeline_desc_hash(&key, VUT_HASH_SEED + part);
+
+    pthread_mutex_lock(&builder->library_mutex);
+    PipelineLibrary* cached = pipeline_library_find(builder, part, &key, hash);
+    if (cached) {
+        *library = cached->library;
+        pthread_mutex_unlock(&builder->library_mutex);
+        return VK_SUCCESS;
+    }
+    pthread_mutex_unlock(&builder->library_mutex);
+
+    // Compile unlocked, other workers may need different libraries in the meantime
+    VkResult result = pipeline_library_create(builder, desc, part, library);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    pthread_mutex_lock(&builder->library_mutex);
+    cached = pipeline_library_find(builder, part, &key, hash);
+    if (cached) {
+        // Another worker was faster, keep its library
+        vkDestroyPipeline(builder->device, *library, vut_get_allocator());
+        *library = cached->library;
+    } else {
+        if (builder->library_count == builder->library_capacity) {
+            uint32_t capacity = builder->library_capacity ? builder->library_capacity * 2 : 16;
+            PipelineLibrary* libraries =
+                realloc(builder->libraries, capacity * sizeof(PipelineLibrary));
+            if (libraries == NULL) {
+                // Only cached libraries are destroyed with the builder
+                pthread_mutex_unlock(&builder->library_mutex);
+                vkDestroyPipeline(builder->device, *library, vut_get_allocator());
+                *library = VK_NULL_HANDLE;
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
+            builder->libraries = libraries;
+            builder->library_capacity = capacity;
+        }
+
+        if (!vut_hash_index_insert(&builder->library_index, hash, builder->library_count)) {
+            pthread_mutex_unlock(&builder->library_mutex);
+            vkDestroyPipeline(builder->device, *library, vut_get_allocator());
+            *library = VK_NULL_HANDLE;
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        builder->libraries[builder->library_count++] = (PipelineLibrary){
+            .part = part,
+            .key = key,
+            .library = *library,
+        };
+    }
+    pthread_mutex_unlock(&builder->library_mutex);
+
+    return VK_SUCCESS;
+}
+
+static VkResult
+pipeline_builder_link(PipelineBuilder* builder,
+                      const PipelineDesc* desc,
+                      bool optimize,
+                      VkPipeline* pipeline)
+{
+    const VkGraphicsPipelineLibraryFlagsEXT parts[] = {
+        VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+        VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+    };
+
+    VkPipeline libraries[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        VkResult result = pipeline_library_get(builder, desc, parts[i], &libraries[i]);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    return vut_link_pipeline(builder->device, builder->cache, 4, libraries,
+                             desc->program->layout, desc->program->create_flags, optimize,
+                             pipeline);
+}
+
+// Builder \\\
+
+static void
+pipeline_builder_job(void* data, uint32_t thread_index)
+{
+    (void)thread_index;
+    PipelineJob* job = data;
+    PipelineBuilder* builder = job->builder;
+
+    // The pipeline cache is internally synchronized
+    job->pipeline = VK_NULL_HANDLE;
+    if (builder->use_libraries) {
+        job->result = pipeline_builder_link(builder, &job->desc, job->optimize, &job->pipeline);
+    } else {
+        job->result =
+            vur_create_pipeline(builder->device, builder->cache, &job->desc, &job->pipeline);
+    }
+}
+
+VkResult
+vur_pipeline_builder_init(VkDevice device,
+                          JobSystem* jobs,
+                          bool use_libraries,
+                          PipelineBuilder* builder)
+{
+    memset(builder, 0, sizeof(*builder));
+    builder->device = device;
+    builder->use_libraries = use_libraries;
+    builder->jobs = jobs;
+
+    VkResult result = vut_init_pipeline_cache(device, &builder->cache);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    pthread_mutex_init(&builder->library_mutex, NULL);
+
+    return VK_SUCCESS;
+}
+
+PipelineJob*
+vur_pipeline_builder_submit(PipelineBuilder* builder, const PipelineDesc* desc, bool optimize)
+{
+    PipelineJob* job = calloc(1, sizeof(PipelineJob));
+    if (job == NULL) {
+        return NULL;
+    }
+    job->desc = *desc;
+    job->optimize = optimize;
+    job->builder = builder;
+    job->decl.function = pipeline_builder_job;
+    job->decl.data = job;
+
+    vut_jobs_run(builder->jobs, &job->decl, 1, &job->counter);
+
+    return job;
+}
+
+bool
+vur_pipeline_builder_poll(PipelineBuilder* builder, PipelineJob* job)
+{
+    (void)builder;
+    return vut_jobs_done(&job->counter);
+}
+
+VkResult
+vur_pipeline_builder_finish(PipelineBuilder* builder, PipelineJob* job, VkPipeline* pipeline)
+{
+    // Runs other jobs meanwhile, possibly this one
+    vut_jobs_wait(builder->jobs, &job->counter);
+
+    VkResult result = job->result;
+    *pipeline = job->pipeline;
+    free(job);
+
+    return result;
+}
+
+void
+vur_pipeline_builder_destroy(PipelineBuilder* builder)
+{
+    pthread_mutex_destroy(&builder->library_mutex);
+
+    for (uint32_t i = 0; i < builder->library_count; i++) {
+        vkDestroyPipeline(builder->device, builder->libraries[i].library, vut_get_allocator());
+    }
+    free(builder->libraries);
+    vut_hash_index_free(&builder->library_index);
+
+    vkDestroyPipelineCache(builder->device, builder->cache, vut_get_allocator());
+    memset(builder, 0, sizeof(*builder));
+}
+
+// Manager \\\
+
+static ManagedPipeline*
+pipeline_manager_find(PipelineManager* manager, const PipelineDesc* desc, uint64_t hash)
+{
+    uint32_t cursor = 0;
+    uint32_t index;
+    while ((index = vut_hash_index_find(&manager->index, hash, &cursor)) != UINT32_MAX) {
+        if (pipeline_desc_equal(&manager->pipelines[index].desc, desc)) {
+            return &manager->pipelines[index];
+        }
+    }
+
+    return NULL;
+}
+
+static ManagedPipeline*
+pipeline_manager_add(PipelineManager* manager, const PipelineDesc* desc, uint64_t hash)
+{
+    if (manager->pipeline_count == manager->pipeline_capacity) {
+        uint32_t capacity = manager->pipeline_capacity ? manager->pipeline_capacity * 2 : 16;
+        ManagedPipeline* pipelines =
+            realloc(manager->pipelines, capacity * sizeof(ManagedPipeline));
+        if (pipelines == NULL) {
+            return NULL;
+        }
+        manager->pipelines = pipelines;
+        manager->pipeline_capacity = capacity;
+    }
+
+    if (!vut_hash_index_insert(&manager->index, hash, manager->pipeline_count)) {
+        return NULL;
+    }
+
+    ManagedPipeline* managed = &manager->pipelines[manager->pipeline_count++];
+    memset(managed, 0, sizeof(*managed));
+    managed->desc = *desc;
+    managed->result = VK_NOT_READY;
+
+    return managed;
+}
+
+static bool
+pipeline_manager_retire(PipelineManager* manager, VkPipeline pipeline)
+{
+    if (manager->retired_count == manager->retired_capacity) {
+        uint32_t capacity = manager->retired_capacity ? manager->retired_capacity * 2 : 8;
+        RetiredPipeline* retired = realloc(manager->retired, capacity * sizeof(RetiredPipeline));
+        if (retired == NULL) {
+            return false;
+        }
+        manager->retired = retired;
+        manager->retired_capacity = capacity;
+    }
+
+    manager->retired[manager->retired_count++] = (RetiredPipeline){
+        .pipeline = pipeline,
+        .frame = manager->frame,
+    };
+    return true;
+}
+
+static void
+pipeline_manager_collect(PipelineManager* manager, ManagedPipeline* managed)
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vur_pipeline_builder_finish(manager->builder, managed->job, &pipeline);
+    managed->job = NULL;
+
+    if (result != VK_SUCCESS) {
+        if (managed->pipeline == VK_NULL_HANDLE) {
+            // Keep drawing with the fallback, the description will not be retried
+            fprintf(stderr, "Failed to compile a pipeline (%d), using the fallback\n", result);
+            managed->result = result;
+        }
+        // A failed optimized relink keeps the fast linked pipeline
+        return;
+    }
+
+    // The replaced fast linked pipeline may still be used by frames in flight. When it can
+    // not be retired it stays, and the optimized one is dropped.
+    if (managed->pipeline && !pipeline_manager_retire(manager, managed->pipeline)) {
+        vkDestroyPipeline(manager->device, pipeline, vut_get_allocator());
+        return;
+    }
+    managed->pipeline = pipeline;
+    managed->result = VK_SUCCESS;
+
+    // Fast linked pipelines are swapped for an optimized link once it is ready
+    if (manager->builder->use_libraries && !managed->optimized) {
+        managed->optimized = true;
+        managed->job = vur_pipeline_builder_submit(manager->builder, &managed->desc, true);
+    }
+}
+
+static ManagedPipeline*
+pipeline_manager_request(PipelineManager* manager, const PipelineDesc* desc)
+{
+    uint64_t hash = pipeline_desc_hash(desc, VUT_HASH_SEED);
+
+    ManagedPipeline* managed = pipeline_manager_find(manager, desc, hash);
+    if (managed == NULL) {
+        managed = pipeline_manager_add(manager, desc, hash);
+        if (managed == NULL) {
+            return NULL;
+        }
+        managed->job = vur_pipeline_builder_submit(manager->builder, desc, false);
+        if (managed->job == NULL) {
+            // Like a failed compilation, drawn with the fallback and not retried
+            managed->result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    return managed;
+}
+
+VkResult
+vur_pipeline_manager_init(VkDevice device,
+                          PipelineBuilder* builder,
+                          uint32_t frame_lag,
+                          const PipelineDesc* fallback_desc,
+                          PipelineManager* manager)
+{
+    memset(manager, 0, sizeof(*manager));
+    manager->device = device;
+    manager->builder = builder;
+    manager->frame_lag = frame_lag;
+
+    // The fallback is looked up by index, its handle changes when the optimized link is done
+    VkPipeline fallback;
+    manager->fallback_index = manager->pipeline_count;
+    return vur_pipeline_manager_wait(manager, fallback_desc, &fallback);
+}
+
+void
+vur_pipeline_manager_begin_frame(PipelineManager* manager)
+{
+    manager->frame++;
+
+    // Every frame that could have used a retired pipeline has finished by now
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < manager->retired_count; i++) {
+        if (manager->frame - manager->retired[i].frame >= manager->frame_lag) {
+            vkDestroyPipeline(manager->device, manager->retired[i].pipeline, vut_get_allocator());
+        } else {
+            manager->retired[kept++] = manager->retired[i];
+        }
+    }
+    manager->retired_count = kept;
+
+    // Jobs of pipelines that are no longer drawn with finish as well, busy waits for them
+    for (uint32_t i = 0; i < manager->pipeline_count; i++) {
+        ManagedPipeline* managed = &manager->pipelines[i];
+        if (managed->job && vur_pipeline_builder_poll(manager->builder, managed->job)) {
+            pipeline_manager_collect(manager, managed);
+        }
+    }
+}
+
+VkPipeline
+vur_pipeline_manager_get(PipelineManager* manager, const PipelineDesc* desc)
+{
+    ManagedPipeline* managed = pipeline_manager_request(manager, desc);
+    if (managed == NULL) {
+        return manager->pipelines[manager->fallback_index].pipeline;
+    }
+
+    if (managed->job && vur_pipeline_builder_poll(manager->builder, managed->job)) {
+        pipeline_manager_collect(manager, managed);
+    }
+
+    if (managed->pipeline == VK_NULL_HANDLE) {
+        return manager->pipelines[manager->fallback_index].pipeline;
+    }
+
+    return managed->pipeline;
+}
+
+bool
+vur_pipeline_manager_busy(const PipelineManager* manager)
+{
+    for (uint32_t i = 0; i < manager->pipeline_count; i++) {
+        if (manager->pipelines[i].job) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+VkResult
+vur_pipeline_manager_wait(PipelineManager* manager, const PipelineDesc* desc, VkPipeline* pipeline)
+{
+    ManagedPipeline* managed = pipeline_manager_request(manager, desc);
+    if (managed == NULL) {
+        *pipeline = VK_NULL_HANDLE;
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    // A fast linked pipeline is good enough, the optimized one follows later
+    if (managed->job && managed->pipeline == VK_NULL_HANDLE) {
+        pipeline_manager_collect(manager, managed);
+    }
+
+    *pipeline = managed->pipeline;
+    return managed->result;
+}
+
+void
+vur_pipeline_manager_destroy(PipelineManager* manager)
+{
+    for (uint32_t i = 0; i < manager->pipeline_count; i++) {
+        ManagedPipeline* managed = &manager->pipelines[i];
+        if (managed->job) {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            vur_pipeline_builder_finish(manager->builder, managed->job, &pipeline);
+            vkDestroyPipeline(manager->device, pipeline, vut_get_allocator());
+        }
+        vkDestroyPipeline(manager->device, managed->pipeline, vut_get_allocator());
+    }
+
+    for (uint32_t i = 0; i < manager->retired_count; i++) {
+        vkDestroyPipeline(manager->device, manager->retired[i].pipeline, vut_get_allocator());
+    }
+
+    free(manager->retired);
+    free(manager->pipelines);
+    vut_hash_index_free(&manager->index);
+    memset(manager, 0, sizeof(*manager));
+}
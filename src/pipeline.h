@@ -0,0 +1,409 @@
+/**
+ * @file pipeline.h
+ * @brief Graphics pipeline descriptions and jobs to compile them
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "bindless.h"
+#include "hash.h"
+#include "jobs.h"
+#include "layout_cache.h"
+#include "spirv_reflect.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+// Specialization constant ids of the shader features, see the constant_id layouts
+#define VUR_SPEC_FOG 0
+#define VUR_SPEC_ALPHA_TEST 1
+#define VUR_SPEC_LIGHT_COUNT 2
+#define VUR_SPEC_DRAW_DATA_IN_BUFFER 3
+#define VUR_SPEC_TEXTURED 4
+
+// Uniform buffer binding that holds the per draw data when it does not fit in push constants
+#define VUR_DRAW_DATA_SET 0
+#define VUR_DRAW_DATA_BINDING 0
+
+/**
+ * @brief Feature bitmask of a shader variant. Every variant is a separate pipeline in
+ * which the compiler removes the code paths of disabled features.
+ */
+typedef enum
+{
+    VUR_FEATURE_FOG = 1 << 0,
+    VUR_FEATURE_ALPHA_TEST = 1 << 1,
+    // Sample the bindless texture of the material of the draw
+    VUR_FEATURE_TEXTURED = 1 << 2,
+} ShaderFeatureFlagBits;
+typedef uint32_t ShaderFeatureFlags;
+
+// The light count is stored in the feature mask above the feature bits
+#define VUR_FEATURE_LIGHT_COUNT_SHIFT 8
+#define VUR_FEATURE_LIGHT_COUNT_MASK (0xffu << VUR_FEATURE_LIGHT_COUNT_SHIFT)
+#define VUR_FEATURE_LIGHTS(count) ((uint32_t)(count) << VUR_FEATURE_LIGHT_COUNT_SHIFT)
+
+/**
+ * @brief A vertex and fragment shader pair with its reflected interface and layout.
+ * Programs are created once and must outlive every pipeline built from them.
+ */
+typedef struct
+{
+    VkShaderModule vert_module;
+    VkShaderModule frag_module;
+    ShaderReflection reflection;
+    VkPipelineLayout layout;
+
+    // The push constant block is too large for the device, draws use the dynamic buffer
+    bool draw_data_in_buffer;
+
+    // Flags every pipeline of the program is created with
+    VkPipelineCreateFlags create_flags;
+} ShaderProgram;
+
+/**
+ * @brief Everything that makes one graphics pipeline different from another. Hashed and
+ * compared field by field, so a copy with other fields assigned can be looked up.
+ */
+typedef struct
+{
+    const ShaderProgram* program;
+
+    // Without a render pass the pipeline is created for dynamic rendering to color_format
+    VkRenderPass render_pass;
+    VkFormat color_format;
+
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkBool32 blend_enable;
+
+    ShaderFeatureFlags features;
+} PipelineDesc;
+
+
+/**
+ * @brief One part of a pipeline, shared by every description with the same state for it
+ */
+typedef struct
+{
+    VkGraphicsPipelineLibraryFlagsEXT part;
+    PipelineDesc key;
+    VkPipeline library;
+} PipelineLibrary;
+
+/**
+ * @brief Compiles pipelines concurrently into a shared VkPipelineCache as jobs of the job
+ * system. With VK_EXT_graphics_pipeline_library the four parts of a pipeline are compiled
+ * once as libraries and variants are linked from them.
+ */
+typedef struct
+{
+    VkDevice device;
+    VkPipelineCache cache;
+    bool use_libraries;
+    JobSystem* jobs;
+
+    pthread_mutex_t library_mutex;
+    uint32_t library_count;
+    uint32_t library_capacity;
+    PipelineLibrary* libraries;
+    HashIndex library_index;
+} PipelineBuilder;
+
+/**
+ * @brief A pipeline queued on the builder
+ */
+typedef struct
+{
+    PipelineDesc desc;
+    VkPipeline pipeline;
+    VkResult result;
+    bool optimize;
+
+    PipelineBuilder* builder;
+    JobDecl decl;
+    JobCounter counter;
+} PipelineJob;
+
+/**
+ * @brief A pipeline known to the manager. The pipeline is VK_NULL_HANDLE while the
+ * job is still compiling or when the compilation failed.
+ */
+typedef struct
+{
+    PipelineDesc desc;
+    VkPipeline pipeline;
+    PipelineJob* job;
+    VkResult result;
+    bool optimized;
+} ManagedPipeline;
+
+/**
+ * @brief A replaced pipeline that may still be used by a frame in flight
+ */
+typedef struct
+{
+    VkPipeline pipeline;
+    uint64_t frame;
+} RetiredPipeline;
+
+/**
+ * @brief Pipelines keyed by the hash of their description. Missing pipelines are
+ * compiled on the builder and the fallback pipeline is handed out until they are ready.
+ * Fast linked pipelines are replaced by an optimized link when that finishes.
+ * Only use the manager from the thread that records the command buffers.
+ */
+typedef struct
+{
+    VkDevice device;
+    PipelineBuilder* builder;
+    uint32_t fallback_index;
+
+    uint64_t frame;
+    uint32_t frame_lag;
+    uint32_t retired_count;
+    uint32_t retired_capacity;
+    RetiredPipeline* retired;
+
+    uint32_t pipeline_count;
+    uint32_t pipeline_capacity;
+    ManagedPipeline* pipelines;
+    HashIndex index;
+} PipelineManager;
+
+/**
+ * @brief Replace the arrays a shader declares at VUR_BINDLESS_SET with the full set of the
+ * bindless table, so every program shares its set layout
+ *
+ * @param[in] reflection The reflected shader interface
+ * @param[in] bindless_set The set of the bindless table, NULL when the device has none
+ * @return VkResult VK_ERROR_FEATURE_NOT_PRESENT when the shader uses the set without a
+ * table, VK_ERROR_INITIALIZATION_FAILED when its declarations do not match the table
+ */
+VkResult
+vur_reflection_use_bindless(ShaderReflection* reflection, const ReflectedSet* bindless_set);
+
+/**
+ * @brief Load both shader stages, reflect them and get the pipeline layout from the cache.
+ * The uniform buffer at VUR_DRAW_DATA_SET and VUR_DRAW_DATA_BINDING becomes a dynamic
+ * uniform buffer, unless the layout cache uses descriptor buffers. When the push constants
+ * exceed the device limit they are left out of the layout and the shaders are specialized
+ * to read the draw data from that buffer.
+ * The arrays at VUR_BINDLESS_SET are replaced by the full set of the bindless table.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] layout_cache Cache that owns the pipeline layout
+ * @param[in] max_push_constants_size maxPushConstantsSize of the device
+ * @param[in] bindless_set The set of the bindless table, NULL when the device has none
+ * @param[in] vert_code SPIR-V of the vertex shader
+ * @param[in] vert_size Size of the vertex shader in bytes
+ * @param[in] frag_code SPIR-V of the fragment shader
+ * @param[in] frag_size Size of the fragment shader in bytes
+ * @param[out] program The created program
+ * @return VkResult
+ */
+VkResult
+vur_init_shader_program(VkDevice device,
+                        LayoutCache* layout_cache,
+                        uint32_t max_push_constants_size,
+                        const ReflectedSet* bindless_set,
+                        const uint32_t vert_code[],
+                        size_t vert_size,
+                        const uint32_t frag_code[],
+                        size_t frag_size,
+                        ShaderProgram* program);
+
+/**
+ * @brief Destroy the shader modules of a program. The layout is owned by the layout cache
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] program The program to destroy
+ */
+void
+vur_destroy_shader_program(VkDevice device, ShaderProgram* program);
+
+/**
+ * @brief Fill in a description with the default fixed function state
+ *
+ * @param[in] program The shaders of the pipeline
+ * @param[in] render_pass The render pass the pipeline is used in, VK_NULL_HANDLE for
+ * dynamic rendering
+ * @param[in] color_format Format of the color attachment
+ * @param[out] desc The description
+ */
+void
+vur_pipeline_desc_init(const ShaderProgram* program,
+                       VkRenderPass render_pass,
+                       VkFormat color_format,
+                       PipelineDesc* desc);
+
+/**
+ * @brief Get the specialization constants of a feature mask. Only constants the program
+ * declares are specialized, the others keep the default value from the shader.
+ *
+ * @param[in] program The shaders of the pipeline
+ * @param[in] features The feature mask of the variant
+ * @param[out] entries Map entries, room for VUT_MAX_SPEC_CONSTANTS
+ * @param[out] data Constant values, room for VUT_MAX_SPEC_CONSTANTS
+ * @param[out] info Specialization info pointing into entries and data
+ */
+void
+vur_get_specialization(const ShaderProgram* program,
+                       ShaderFeatureFlags features,
+                       VkSpecializationMapEntry entries[],
+                       uint32_t data[],
+                       VkSpecializationInfo* info);
+
+/**
+ * @brief Create a pipeline from a description on the calling thread. Viewport and scissor
+ * are dynamic state so pipelines survive window resizes.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] cache Pipeline cache, may be VK_NULL_HANDLE
+ * @param[in] desc The pipeline description
+ * @param[out] pipeline The created pipeline
+ * @return VkResult The result of vkCreateGraphicsPipelines
+ */
+VkResult
+vur_create_pipeline(VkDevice device,
+                    VkPipelineCache cache,
+                    const PipelineDesc* desc,
+                    VkPipeline* pipeline);
+
+/**
+ * @brief Create the pipeline cache
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] jobs The job system the pipelines are compiled on
+ * @param[in] use_libraries Link pipelines from libraries, the device must have
+ * VK_EXT_graphics_pipeline_library enabled
+ * @param[out] builder The builder
+ * @return VkResult
+ */
+VkResult
+vur_pipeline_builder_init(VkDevice device,
+                          JobSystem* jobs,
+                          bool use_libraries,
+                          PipelineBuilder* builder);
+
+/**
+ * @brief Queue a pipeline for compilation on the job system
+ *
+ * @param[in] builder The builder
+ * @param[in] desc The description, copied into the job
+ * @param[in] optimize Link with link time optimization, only used with libraries
+ * @return PipelineJob* Handle to poll or wait on, released by vur_pipeline_builder_finish.
+ * NULL when the job can not be allocated.
+ */
+PipelineJob*
+vur_pipeline_builder_submit(PipelineBuilder* builder, const PipelineDesc* desc, bool optimize);
+
+/**
+ * @brief Check whether a job has finished without blocking
+ *
+ * @param[in] builder The builder
+ * @param[in] job The job to check
+ * @return true The pipeline is ready to be collected with vur_pipeline_builder_finish
+ */
+bool
+vur_pipeline_builder_poll(PipelineBuilder* builder, PipelineJob* job);
+
+/**
+ * @brief Wait for a job to finish, collect the pipeline and release the job. The calling
+ * thread runs jobs while it waits.
+ *
+ * @param[in] builder The builder
+ * @param[in] job The job to wait on
+ * @param[out] pipeline The compiled pipeline
+ * @return VkResult The result of the compilation
+ */
+VkResult
+vur_pipeline_builder_finish(PipelineBuilder* builder, PipelineJob* job, VkPipeline* pipeline);
+
+/**
+ * @brief Destroy the pipeline libraries and the pipeline cache. Every submitted job must be
+ * collected with vur_pipeline_builder_finish first.
+ *
+ * @param[in] builder The builder
+ */
+void
+vur_pipeline_builder_destroy(PipelineBuilder* builder);
+
+/**
+ * @brief Create the manager and compile the fallback pipeline. This blocks until the
+ * fallback is ready since every other pipeline can be replaced by it.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] builder The builder missing pipelines are queued on
+ * @param[in] frame_lag Amount of frames in flight, replaced pipelines live this long
+ * @param[in] fallback_desc Description of the generic fallback pipeline
+ * @param[out] manager The manager
+ * @return VkResult The result of compiling the fallback
+ */
+VkResult
+vur_pipeline_manager_init(VkDevice device,
+                          PipelineBuilder* builder,
+                          uint32_t frame_lag,
+                          const PipelineDesc* fallback_desc,
+                          PipelineManager* manager);
+
+/**
+ * @brief Start recording a new frame. Call after waiting on the fence of the frame,
+ * so pipelines that were replaced long enough ago can be destroyed. Collects every job that
+ * has finished, requested this frame or not.
+ *
+ * @param[in] manager The manager
+ */
+void
+vur_pipeline_manager_begin_frame(PipelineManager* manager);
+
+/**
+ * @brief Get the pipeline for a description without blocking. The first request queues
+ * the compilation and every request returns the fallback until the pipeline is ready.
+ *
+ * @param[in] manager The manager
+ * @param[in] desc The pipeline description
+ * @return VkPipeline The requested pipeline or the fallback
+ */
+VkPipeline
+vur_pipeline_manager_get(PipelineManager* manager, const PipelineDesc* desc);
+
+/**
+ * @brief Check for pipelines that are still compiling or waiting for their optimized link.
+ * Frames drawn meanwhile use the fallback or the fast link.
+ *
+ * @param[in] manager The manager
+ * @return true A pipeline will be replaced once its job is done
+ */
+bool
+vur_pipeline_manager_busy(const PipelineManager* manager);
+
+/**
+ * @brief Get the pipeline for a description and wait for it when it is still compiling.
+ * Use this for pipelines that may never be replaced by the fallback.
+ *
+ * @param[in] manager The manager
+ * @param[in] desc The pipeline description
+ * @param[out] pipeline The requested pipeline
+ * @return VkResult The result of the compilation
+ */
+VkResult
+vur_pipeline_manager_wait(PipelineManager* manager, const PipelineDesc* desc, VkPipeline* pipeline);
+
+/**
+ * @brief Wait for the jobs that are still compiling and destroy all pipelines
+ *
+ * @param[in] manager The manager
+ */
+void
+vur_pipeline_manager_destroy(PipelineManager* manager);
+
+#endif // PIPELINE_H
@@ -0,0 +1,310 @@
+/**
+ * @file readback.c
+ * @brief Copy buffers and images to the CPU without stalling, results arrive frames later
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "readback.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static VkDeviceSize
+readback_align(VkDeviceSize offset, VkDeviceSize alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+static ReadbackTicket
+readback_push(Readback* readback, const ReadbackRequest* request)
+{
+    if (request->size > readback->frame_size) {
+        return VUR_READBACK_INVALID_TICKET;
+    }
+
+    if (readback->pending_count == readback->pending_capacity) {
+        uint32_t capacity = readback->pending_capacity ? readback->pending_capacity * 2 : 16;
+        ReadbackRequest* pending = realloc(readback->pending, capacity * sizeof(ReadbackRequest));
+        if (pending == NULL) {
+            return VUR_READBACK_INVALID_TICKET;
+        }
+        readback->pending = pending;
+        readback->pending_capacity = capacity;
+    }
+
+    ReadbackRequest* pending = &readback->pending[readback->pending_count++];
+    *pending = *request;
+    pending->ticket = ++readback->next_ticket;
+
+    return pending->ticket;
+}
+
+VkResult
+vur_readback_init(VkDevice device,
+                  VkPhysicalDevice gpu,
+                  uint32_t frame_lag,
+                  VkDeviceSize frame_size,
+                  Readback* readback)
+{
+    memset(readback, 0, sizeof(*readback));
+    readback->device = device;
+    readback->frame_lag = frame_lag;
+    readback->frame_size = frame_size;
+
+    VkResult result = VK_SUCCESS;
+    for (uint32_t i = 0; i < frame_lag && result == VK_SUCCESS; i++) {
+        ReadbackFrame* frame = &readback->frames[i];
+
+        // Cached memory may not be coherent, vur_readback_complete invalidates it
+        result = vut_init_buffer(
+            device, gpu, frame_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+            &frame->buffer, &frame->memory);
+        if (result == VK_ERROR_FEATURE_NOT_PRESENT) {
+            result = vut_init_buffer(
+                device, gpu, frame_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                &frame->buffer, &frame->memory);
+        }
+        if (result == VK_SUCCESS) {
+            result = vkMapMemory(device, frame->memory, 0, VK_WHOLE_SIZE, 0,
+                                 (void**)&frame->data);
+        }
+    }
+
+    if (result != VK_SUCCESS) {
+        vur_readback_destroy(readback);
+    }
+
+    return result;
+}
+
+ReadbackTicket
+vur_readback_request_buffer(Readback* readback,
+                            VkBuffer buffer,
+                            VkDeviceSize offset,
+                            VkDeviceSize size,
+                            void* dst,
+                            ReadbackCallback callback,
+                            void* user_data)
+{
+    const ReadbackRequest request = {
+        .buffer = buffer,
+        .buffer_offset = offset,
+        .size = size,
+        .dst = dst,
+        .callback = callback,
+        .user_data = user_data,
+    };
+
+    return readback_push(readback, &request);
+}
+
+ReadbackTicket
+vur_readback_request_image(Readback* readback,
+                           VkImage image,
+                           VkImageLayout layout,
+                           VkFormat format,
+                           VkExtent2D extent,
+                           uint32_t texel_size,
+                           void* dst,
+                           ReadbackCallback callback,
+                           void* user_data)
+{
+    const ReadbackRequest request = {
+        .image = image,
+        .image_layout = layout,
+        .image_aspect = vut_get_format_aspect(format),
+        .image_extent = extent,
+        .texel_size = texel_size,
+        .size = (VkDeviceSize)extent.width * extent.height * texel_size,
+        .dst = dst,
+        .callback = callback,
+        .user_data = user_data,
+    };
+
+    return readback_push(readback, &request);
+}
+
+void
+vur_readback_record(Readback* readback, VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+    ReadbackFrame* frame = &readback->frames[frame_index];
+    if (readback->pending_count == 0) {
+        return;
+    }
+
+    // Everything the frame wrote before is read by the copies
+    vut_memory_barrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_ACCESS_TRANSFER_READ_BIT);
+
+    uint32_t recorded = 0;
+    for (; recorded < readback->pending_count; recorded++) {
+        ReadbackRequest* request = &readback->pending[recorded];
+
+        // Image copies need an offset that is a multiple of the texel size and of 4
+        VkDeviceSize alignment = 16;
+        if (request->image) {
+            uint32_t texel_size = request->texel_size;
+            alignment = texel_size % 4 == 0   ? texel_size
+                        : texel_size % 2 == 0 ? texel_size * 2
+                                              : texel_size * 4;
+        }
+        VkDeviceSize offset = readback_align(frame->head, alignment);
+
+        // Keep the ticket order, later requests wait until this one fits
+        if (offset + request->size > readback->frame_size) {
+            break;
+        }
+
+        // Requests the frame can not hold stay pending for a later frame
+        if (frame->request_count == frame->request_capacity) {
+            uint32_t capacity = frame->request_capacity ? frame->request_capacity * 2 : 16;
+            ReadbackRequest* requests =
+                realloc(frame->requests, capacity * sizeof(ReadbackRequest));
+            if (requests == NULL) {
+                break;
+            }
+            frame->requests = requests;
+            frame->request_capacity = capacity;
+        }
+        frame->head = offset + request->size;
+        request->staging_offset = offset;
+
+        if (request->image) {
+            vut_transition_image(command_buffer, request->image, request->image_aspect,
+                                 request->image_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+            // A copy reads a single aspect, the depth of depth and stencil formats
+            VkImageAspectFlags copy_aspect = request->image_aspect;
+            if (copy_aspect & VK_IMAGE_ASPECT_DEPTH_BIT) {
+                copy_aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+            }
+            const VkBufferImageCopy region = {
+                .bufferOffset = offset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource.aspectMask = copy_aspect,
+                .imageSubresource.mipLevel = 0,
+                .imageSubresource.baseArrayLayer = 0,
+                .imageSubresource.layerCount = 1,
+                .imageOffset = { 0, 0, 0 },
+                .imageExtent = { request->image_extent.width, request->image_extent.height, 1 },
+            };
+            vkCmdCopyImageToBuffer(command_buffer, request->image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame->buffer, 1,
+                                   &region);
+
+            vut_transition_image(command_buffer, request->image, request->image_aspect,
+                                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, request->image_layout,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+        } else {
+            const VkBufferCopy region = {
+                .srcOffset = request->buffer_offset,
+                .dstOffset = offset,
+                .size = request->size,
+            };
+            vkCmdCopyBuffer(command_buffer, request->buffer, frame->buffer, 1, &region);
+        }
+
+        frame->requests[frame->request_count++] = *request;
+    }
+
+    // The host reads the staging memory after the fence of the frame
+    vut_memory_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                       VK_ACCESS_HOST_READ_BIT);
+
+    readback->pending_count -= recorded;
+    memmove(readback->pending, readback->pending + recorded,
+            readback->pending_count * sizeof(ReadbackRequest));
+}
+
+void
+vur_readback_complete(Readback* readback, uint32_t frame_index)
+{
+    ReadbackFrame* frame = &readback->frames[frame_index];
+    if (frame->request_count == 0) {
+        return;
+    }
+
+    const VkMappedMemoryRange range = {
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .pNext = NULL,
+        .memory = frame->memory,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    vkInvalidateMappedMemoryRanges(readback->device, 1, &range);
+
+    for (uint32_t i = 0; i < frame->request_count; i++) {
+        const ReadbackRequest* request = &frame->requests[i];
+        memcpy(request->dst, frame->data + request->staging_offset, request->size);
+
+        // Frames finish in order, so every older ticket is done as well
+        readback->completed_ticket = request->ticket;
+        if (request->callback) {
+            request->callback(request->dst, request->size, request->user_data);
+        }
+    }
+
+    frame->request_count = 0;
+    frame->head = 0;
+}
+
+void
+vur_readback_cancel(Readback* readback, ReadbackCallback callback, const void* user_data)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < readback->pending_count; i++) {
+        const ReadbackRequest* request = &readback->pending[i];
+        if (request->callback != callback || request->user_data != user_data) {
+            readback->pending[kept++] = *request;
+        }
+    }
+    readback->pending_count = kept;
+}
+
+bool
+vur_readback_is_done(const Readback* readback, ReadbackTicket ticket)
+{
+    return ticket != VUR_READBACK_INVALID_TICKET && ticket <= readback->completed_ticket;
+}
+
+bool
+vur_readback_busy(const Readback* readback)
+{
+    if (readback->pending_count) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < readback->frame_lag; i++) {
+        if (readback->frames[i].request_count) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+vur_readback_destroy(Readback* readback)
+{
+    for (uint32_t i = 0; i < readback->frame_lag; i++) {
+        ReadbackFrame* frame = &readback->frames[i];
+        vkDestroyBuffer(readback->device, frame->buffer, vut_get_allocator());
+        vut_free_memory(readback->device, frame->memory);
+        free(frame->requests);
+    }
+    free(readback->pending);
+
+    memset(readback, 0, sizeof(*readback));
+}
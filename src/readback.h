@@ -0,0 +1,226 @@
+/**
+ * @file readback.h
+ * @brief Copy buffers and images to the CPU without stalling, results arrive frames later
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef READBACK_H
+#define READBACK_H
+
+#include "vk_util.h"
+
+#include <stdint.h>
+
+#define VUR_MAX_READBACK_FRAMES 4
+
+// Never returned for a queued request
+#define VUR_READBACK_INVALID_TICKET 0
+
+/**
+ * @brief Identifies a request, tickets increase in the order requests are made
+ */
+typedef uint64_t ReadbackTicket;
+
+/**
+ * @brief Called once the data of a request has been copied to its destination
+ *
+ * @param[in] data The destination given with the request
+ * @param[in] size Size of the data in bytes
+ * @param[in] user_data The pointer given with the request
+ */
+typedef void (*ReadbackCallback)(void* data, VkDeviceSize size, void* user_data);
+
+/**
+ * @brief A copy waiting to be recorded or for its frame to finish
+ */
+typedef struct
+{
+    ReadbackTicket ticket;
+
+    // Either a buffer range or the first mip and layer of a color or depth image
+    VkBuffer buffer;
+    VkDeviceSize buffer_offset;
+    VkImage image;
+    VkImageLayout image_layout;
+    VkImageAspectFlags image_aspect;
+    VkExtent2D image_extent;
+    uint32_t texel_size;
+
+    VkDeviceSize size;
+    VkDeviceSize staging_offset;
+
+    void* dst;
+    ReadbackCallback callback;
+    void* user_data;
+} ReadbackRequest;
+
+/**
+ * @brief Staging memory of one frame in flight and the requests recorded into it
+ */
+typedef struct
+{
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    uint8_t* data;
+    VkDeviceSize head;
+
+    uint32_t request_count;
+    uint32_t request_capacity;
+    ReadbackRequest* requests;
+} ReadbackFrame;
+
+/**
+ * @brief Requests are queued at any time and recorded at the end of the command buffer of
+ * the next frame, copying into host cached staging memory of that frame. When the fence of
+ * the frame has been waited on, FRAME_LAG frames later, the data is copied to the
+ * destination of each request and its callback runs. Only use it from the thread that
+ * records frames.
+ */
+typedef struct
+{
+    VkDevice device;
+    uint32_t frame_lag;
+    VkDeviceSize frame_size;
+    ReadbackFrame frames[VUR_MAX_READBACK_FRAMES];
+
+    // Requests that have not been recorded yet, in ticket order
+    uint32_t pending_count;
+    uint32_t pending_capacity;
+    ReadbackRequest* pending;
+
+    ReadbackTicket next_ticket;
+    ReadbackTicket completed_ticket;
+} Readback;
+
+/**
+ * @brief Create the staging buffers. Host cached memory is used when the device has it,
+ * reading uncached memory from the CPU is very slow.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] gpu The physical device the memory is allocated from
+ * @param[in] frame_lag Amount of frames in flight, at most VUR_MAX_READBACK_FRAMES
+ * @param[in] frame_size Bytes of staging memory per frame, the largest possible request
+ * @param[out] readback The readback queue
+ * @return VkResult
+ */
+VkResult
+vur_readback_init(VkDevice device,
+                  VkPhysicalDevice gpu,
+                  uint32_t frame_lag,
+                  VkDeviceSize frame_size,
+                  Readback* readback);
+
+/**
+ * @brief Queue a copy of a buffer range. Writes to the range by earlier commands of the
+ * frame are waited on.
+ *
+ * @param[in] readback The readback queue
+ * @param[in] buffer Buffer created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+ * @param[in] offset Start of the range
+ * @param[in] size Size of the range
+ * @param[out] dst Memory of at least size bytes, must stay valid until the request is done
+ * @param[in] callback Called when the data is in dst, NULL to poll with vur_readback_is_done
+ * @param[in] user_data Passed to the callback
+ * @return ReadbackTicket VUR_READBACK_INVALID_TICKET when size exceeds the staging memory
+ */
+ReadbackTicket
+vur_readback_request_buffer(Readback* readback,
+                            VkBuffer buffer,
+                            VkDeviceSize offset,
+                            VkDeviceSize size,
+                            void* dst,
+                            ReadbackCallback callback,
+                            void* user_data);
+
+/**
+ * @brief Queue a copy of the first mip level and layer of a color or depth image. The texels are
+ * tightly packed rows in the format of the image.
+ *
+ * @param[in] readback The readback queue
+ * @param[in] image Image created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+ * @param[in] layout The layout the image is in at the end of the frame, it is returned to it
+ * @param[in] format Format of the image, the depth of depth formats is read
+ * @param[in] extent Size of the image
+ * @param[in] texel_size Bytes per texel of the format
+ * @param[out] dst Memory for all texels, must stay valid until the request is done
+ * @param[in] callback Called when the data is in dst, NULL to poll with vur_readback_is_done
+ * @param[in] user_data Passed to the callback
+ * @return ReadbackTicket VUR_READBACK_INVALID_TICKET when the image exceeds the staging
+ * memory
+ */
+ReadbackTicket
+vur_readback_request_image(Readback* readback,
+                           VkImage image,
+                           VkImageLayout layout,
+                           VkFormat format,
+                           VkExtent2D extent,
+                           uint32_t texel_size,
+                           void* dst,
+                           ReadbackCallback callback,
+                           void* user_data);
+
+/**
+ * @brief Record the pending requests that fit in the staging memory of the frame. The rest
+ * stays queued for the next frame.
+ *
+ * @param[in] readback The readback queue
+ * @param[in] command_buffer Command buffer of the frame, after all other work
+ * @param[in] frame_index The frame in flight
+ */
+void
+vur_readback_record(Readback* readback, VkCommandBuffer command_buffer, uint32_t frame_index);
+
+/**
+ * @brief Deliver the requests of a frame. Call after the fence of the frame has been waited
+ * on and before it records new requests.
+ *
+ * @param[in] readback The readback queue
+ * @param[in] frame_index The frame in flight
+ */
+void
+vur_readback_complete(Readback* readback, uint32_t frame_index);
+
+/**
+ * @brief Drop the requests with the given callback and user data that have not been
+ * recorded yet, so their destinations can be freed
+ *
+ * @param[in] readback The readback queue
+ * @param[in] callback Callback of the requests
+ * @param[in] user_data User data of the requests
+ */
+void
+vur_readback_cancel(Readback* readback, ReadbackCallback callback, const void* user_data);
+
+/**
+ * @brief Check if the data of a request is in its destination
+ *
+ * @param[in] readback The readback queue
+ * @param[in] ticket The ticket of the request
+ * @return true The request is done
+ */
+bool
+vur_readback_is_done(const Readback* readback, ReadbackTicket ticket);
+
+/**
+ * @brief Check for requests that have not arrived yet, they need more frames to be drawn
+ *
+ * @param[in] readback The readback queue
+ * @return true Requests are queued or in flight
+ */
+bool
+vur_readback_busy(const Readback* readback);
+
+/**
+ * @brief Destroy the staging buffers. The device must be idle, requests that were not
+ * delivered are dropped.
+ *
+ * @param[in] readback The readback queue
+ */
+void
+vur_readback_destroy(Readback* readback);
+
+#endif // READBACK_H
@@ -12,9 +12,13 @@
 #include "renderer.h"
 #include "internal.h"
 
+#include "shaders.h"
 #include "vk_util.h"
+#include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 void
 vur_init(VulkanContext* ctx, const char* app_name)
@@ -25,25 +29,95 @@ vur_init(VulkanContext* ctx, const char* app_name)
     ctx->present_mode = VK_PRESENT_MODE_FIFO_KHR;
     ctx->name = app_name;
 
+    // The first frame always draws
+    atomic_init(&ctx->redraw, true);
+    pthread_mutex_init(&ctx->idle_mutex, NULL);
+    pthread_cond_init(&ctx->idle_condition, NULL);
+
     // Initialisation
     vur_setup_window(ctx);
     vur_init_vulkan(ctx);
 
+    // Draw the triangle until the application sets its own draws
+    DrawCommand draw = { .vertex_count = 3 };
+    glm_mat4_identity(draw.data.transform);
+    vur_set_draws(ctx, 1, &draw);
+
     // Preparation
     vur_prepare(ctx);
-    vur_record_buffers(ctx);
 }
 
+static void
+vur_wake_render_thread(VulkanContext* ctx)
+{
+    pthread_mutex_lock(&ctx->idle_mutex);
+    ctx->render_thread_woken = true;
+    pthread_cond_signal(&ctx->idle_condition);
+    pthread_mutex_unlock(&ctx->idle_mutex);
+}
+
+// Sleep until a snapshot is published, a redraw is requested or the thread has to quit
+static void
+vur_wait_render_thread(VulkanContext* ctx)
+{
+    pthread_mutex_lock(&ctx->idle_mutex);
+    while (!ctx->render_thread_woken && !atomic_load(&ctx->redraw) &&
+           !atomic_load(&ctx->render_thread_quit)) {
+        pthread_cond_wait(&ctx->idle_condition, &ctx->idle_mutex);
+    }
+    ctx->render_thread_woken = false;
+    pthread_mutex_unlock(&ctx->idle_mutex);
+}
+
+// The image changes, so the next vur_draw draws even on demand
+static void
+vur_mark_dirty(VulkanContext* ctx)
+{
+    atomic_store(&ctx->redraw, true);
+    if (atomic_load(&ctx->render_thread_running)) {
+        vur_wake_render_thread(ctx);
+    }
+}
+
+// Readbacks, captures, compute callbacks and the shader features are state of the thread
+// that draws. They are not locked, so the render thread owns them while it runs.
+static bool
+vur_on_render_thread(const VulkanContext* ctx)
+{
+    return !atomic_load(&ctx->render_thread_running) ||
+           pthread_equal(pthread_self(), ctx->render_thread);
+}
+
+// The extent is stored before the flag, so whoever sees the flag also sees the new extent
 static void
 vur_framebuffer_resize_callback(GLFWwindow* window, int width, int height)
 {
     VulkanContext* ctx = (VulkanContext*)glfwGetWindowUserPointer(window);
-    ctx->framebuffer_resized = true;
+    atomic_store_explicit(&ctx->framebuffer_extent,
+                          ((unsigned long long)width << 32) | (uint32_t)height,
+                          memory_order_release);
+    atomic_store_explicit(&ctx->framebuffer_resized, true, memory_order_release);
+    vur_mark_dirty(ctx);
+}
+
+// The window was uncovered or needs its contents again for another reason
+static void
+vur_window_refresh_callback(GLFWwindow* window)
+{
+    vur_mark_dirty((VulkanContext*)glfwGetWindowUserPointer(window));
 }
 
 void
 vur_update_window_size(VulkanContext* ctx)
 {
+    // GLFW may only be called from the window thread
+    if (atomic_load(&ctx->render_thread_running)) {
+        unsigned long long extent =
+            atomic_load_explicit(&ctx->framebuffer_extent, memory_order_acquire);
+        ctx->window_extent = (VkExtent2D){ (uint32_t)(extent >> 32), (uint32_t)extent };
+        return;
+    }
+
     int width, height;
     glfwGetFramebufferSize(ctx->window, &width, &height);
     ctx->window_extent = (VkExtent2D){ width, height };
@@ -56,25 +130,120 @@ vur_setup_window(VulkanContext* ctx)
     vur_update_window_size(ctx);
     glfwSetWindowUserPointer(ctx->window, ctx);
     glfwSetFramebufferSizeCallback(ctx->window, vur_framebuffer_resize_callback);
+    glfwSetWindowRefreshCallback(ctx->window, vur_window_refresh_callback);
 }
 
 void
 vur_update_window(VulkanContext* ctx)
 {
-    glfwPollEvents();
+    // Sleeps until an event arrives, a redraw is requested or the timeout passes. A render
+    // thread sleeps on its own, this thread has to keep publishing snapshots.
+    if (ctx->on_demand && !atomic_load(&ctx->render_thread_running) &&
+        !atomic_load(&ctx->redraw)) {
+        if (ctx->idle_timeout > 0.0) {
+            glfwWaitEventsTimeout(ctx->idle_timeout);
+        } else {
+            glfwWaitEvents();
+        }
+    } else {
+        glfwPollEvents();
+    }
     if (glfwWindowShouldClose(ctx->window)) {
         ctx->should_quit = true;
     }
+
+    if (atomic_load(&ctx->render_thread_running)) {
+        int width, height;
+        glfwGetFramebufferSize(ctx->window, &width, &height);
+        atomic_store_explicit(&ctx->framebuffer_extent,
+                              ((unsigned long long)width << 32) | (uint32_t)height,
+                              memory_order_release);
+    }
+}
+
+void
+vur_set_on_demand(VulkanContext* ctx, bool enabled, double idle_timeout)
+{
+    ctx->on_demand = enabled;
+    ctx->idle_timeout = idle_timeout;
+    vur_mark_dirty(ctx);
+}
+
+void
+vur_request_redraw(VulkanContext* ctx)
+{
+    vur_mark_dirty(ctx);
+    glfwPostEmptyEvent();
 }
 
 void
 vur_init_vulkan(VulkanContext* ctx)
 {
+    vut_arena_init(VUR_INIT_ARENA_SIZE, &ctx->init_arena);
+    vut_set_scratch_arena(&ctx->init_arena);
+#ifdef VUR_USE_HOST_ALLOCATOR
+    // Every object, the instance included, is created with the same callbacks
+    vut_host_allocator_init(&ctx->host_allocator);
+    vut_set_allocator(&ctx->host_allocator.callbacks);
+#endif
+    // One worker per remaining core, pinned so the scheduler does not move them
+    if (!vut_jobs_init(0, true, &ctx->jobs)) {
+        fprintf(stderr, "Failed to start the job system\n");
+        abort();
+    }
+
     vut_init_instance(ctx->name, &ctx->instance);
     vut_init_surface(ctx->instance, ctx->window, &ctx->surface);
     vur_pick_physical_device(ctx);
     vur_create_device(ctx);
-    vut_init_command_pool(ctx->device, ctx->graphics_queue_family_index, &ctx->command_pool);
+
+    // Counts the allocations of the vut_ functions when VK_EXT_memory_budget is missing
+    vut_memory_budget_init(ctx->gpu, ctx->features.memory_budget, &ctx->memory_budget);
+    vut_set_memory_budget(&ctx->memory_budget);
+
+    vur_deletion_queue_init(ctx->device, FRAME_LAG, &ctx->deletion_queue);
+    if (vur_readback_init(ctx->device, ctx->gpu, FRAME_LAG, VUR_READBACK_FRAME_SIZE,
+                          &ctx->readback) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the readback staging buffers\n");
+        abort();
+    }
+    vut_layout_cache_init(ctx->device, ctx->features.descriptor_buffer, &ctx->layout_cache);
+
+    // Textures, samplers and buffers are indexed by material in the shaders. Without
+    // descriptor indexing the fragment shader variant without the arrays is used.
+    const ReflectedSet* bindless_set = NULL;
+    const uint32_t* frag_code = shader_frag_spv;
+    size_t frag_size = shader_frag_spv_size;
+    if (ctx->features.descriptor_indexing) {
+        const uint32_t capacities[VUR_BINDLESS_BINDING_COUNT] = {
+            [VUR_BINDLESS_TEXTURE_BINDING] = 16384,
+            [VUR_BINDLESS_SAMPLER_BINDING] = 64,
+            [VUR_BINDLESS_BUFFER_BINDING] = 16384,
+        };
+        if (vur_bindless_init(ctx->device, ctx->gpu, &ctx->layout_cache, capacities,
+                              &ctx->bindless) != VK_SUCCESS) {
+            fprintf(stderr, "Failed to create the bindless descriptor set\n");
+            abort();
+        }
+        bindless_set = &ctx->bindless.set;
+        frag_code = shader_frag_bindless_spv;
+        frag_size = shader_frag_bindless_spv_size;
+    }
+
+    if (vur_pipeline_builder_init(ctx->device, &ctx->jobs, ctx->features.graphics_pipeline_library,
+                                  &ctx->pipeline_builder) != VK_SUCCESS ||
+        vur_init_shader_program(ctx->device, &ctx->layout_cache,
+                                ctx->gpu_properties.limits.maxPushConstantsSize, bindless_set,
+                                shader_vert_spv, shader_vert_spv_size, frag_code, frag_size,
+                                &ctx->program) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to load the shaders\n");
+        abort();
+    }
+    vut_init_command_pool(ctx->device, ctx->graphics_queue_family_index, 0, &ctx->command_pool);
+    if (vur_prepare_frames(ctx) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to prepare the frames in flight\n");
+        abort();
+    }
     vur_setup_synchronization(ctx);
 }
 
@@ -84,11 +253,14 @@ vur_pick_physical_device(VulkanContext* ctx)
     // Get a list of all physical devices
     uint32_t gpu_count;
     vut_get_physical_devices(ctx->instance, &gpu_count, NULL);
-    VkPhysicalDevice gpus[gpu_count];
+    ArenaScope scope = vut_arena_begin_scope(&ctx->init_arena);
+    VkPhysicalDevice* gpus = VUT_ARENA_ALLOC(&ctx->init_arena, VkPhysicalDevice, gpu_count);
     vut_get_physical_devices(ctx->instance, &gpu_count, gpus);
 
     // Select the most suitable gpu
     vut_pick_physical_device(gpus, gpu_count, &ctx->gpu);
+    vkGetPhysicalDeviceProperties(ctx->gpu, &ctx->gpu_properties);
+    vut_arena_end_scope(scope);
 }
 
 void
@@ -98,10 +270,25 @@ vur_create_device(VulkanContext* ctx)
     vut_get_queue_family_indices(ctx->gpu, ctx->surface, &ctx->graphics_queue_family_index,
                                  &ctx->present_queue_family_index, &ctx->separate_present_queue);
 
-    vut_init_device(ctx->gpu, ctx->graphics_queue_family_index, &ctx->device);
+    // Enable every optional feature the GPU has, the renderer falls back when missing
+    vut_query_device_features(ctx->gpu, &ctx->features);
+#ifndef VUR_USE_DESCRIPTOR_BUFFER
+    // Opt in, descriptor sets are not always slower
+    ctx->features.descriptor_buffer = false;
+#endif
+
+    // A compute family without graphics or a second graphics queue overlaps rasterization
+    uint32_t compute_queue_index;
+    vut_get_compute_queue(ctx->gpu, ctx->graphics_queue_family_index,
+                          &ctx->compute_queue_family_index, &compute_queue_index);
+    vut_init_device(ctx->gpu, ctx->graphics_queue_family_index, ctx->compute_queue_family_index,
+                    compute_queue_index, &ctx->features, &ctx->device);
 
     // Store the correct queues from indices
     vkGetDeviceQueue(ctx->device, ctx->graphics_queue_family_index, 0, &ctx->graphics_queue);
+    vkGetDeviceQueue(ctx->device, ctx->compute_queue_family_index, compute_queue_index,
+                     &ctx->compute_queue);
+    ctx->async_compute = ctx->compute_queue != ctx->graphics_queue;
 
     if (!ctx->separate_present_queue) {
         ctx->present_queue = ctx->graphics_queue;
@@ -116,11 +303,13 @@ vur_setup_synchronization(VulkanContext* ctx)
     // Create semaphores to synchronize acquiring presentable buffers before
     // rendering and waiting for drawing to be complete before presenting.
     // Create fences that we can use to throttle if we get too far
-    // ahead of the image presents.
+    // ahead of the image presents. They start signaled since the first
+    // frames have nothing to wait for.
     for (uint32_t i = 0; i < FRAME_LAG; i++) {
-        vut_init_fence(ctx->device, &ctx->fences[i]);
+        vut_init_fence(ctx->device, VK_FENCE_CREATE_SIGNALED_BIT, &ctx->fences[i]);
         vut_init_semaphore(ctx->device, &ctx->image_acquired_semaphores[i]);
         vut_init_semaphore(ctx->device, &ctx->draw_complete_semaphores[i]);
+        vut_init_semaphore(ctx->device, &ctx->compute_complete_semaphores[i]);
     }
 }
 
@@ -129,17 +318,37 @@ vur_prepare(VulkanContext* ctx)
 {
     vur_prepare_swapchain(ctx);
     vur_prepare_image_views(ctx);
-    vut_prepare_render_pass(ctx->device, ctx->surface_format, &ctx->render_pass);
-    vur_prepare_pipeline(ctx);
+
+    // The render pass and pipelines only depend on the surface format and use a dynamic
+    // viewport, so they survive resizes. A recreated swapchain can pick another format,
+    // after the window moved to another monitor for example, and then both are made again.
+    if (ctx->pipeline_layout != VK_NULL_HANDLE &&
+        ctx->pipeline_desc.color_format != ctx->surface_format) {
+        // Rare enough to wait for the frames in flight that use them
+        vkDeviceWaitIdle(ctx->device);
+        vur_pipeline_manager_destroy(&ctx->pipelines);
+        vkDestroyRenderPass(ctx->device, ctx->render_pass, vut_get_allocator());
+        ctx->render_pass = VK_NULL_HANDLE;
+        ctx->pipeline_layout = VK_NULL_HANDLE;
+    }
+
+    if (ctx->pipeline_layout == VK_NULL_HANDLE) {
+        if (!ctx->features.dynamic_rendering) {
+            vut_prepare_render_pass(ctx->device, ctx->surface_format, &ctx->render_pass);
+        }
+        vur_prepare_pipeline(ctx);
+    }
+
+    // Dynamic rendering draws to the image views directly
+    if (ctx->features.dynamic_rendering) {
+        return;
+    }
 
     for (uint32_t i = 0; i < ctx->swapchain_image_count; i++) {
         vut_prepare_framebuffer(ctx->device, ctx->render_pass,
                                 ctx->swapchain_image_resources[i].view, ctx->window_extent,
                                 &ctx->swapchain_image_resources[i].framebuffer);
     }
-
-    // Prepare the buffers that contain GPU data
-    vur_prepare_buffers(ctx);
 }
 
 void
@@ -157,8 +366,14 @@ vur_prepare_swapchain(VulkanContext* ctx)
     VkExtent2D extent = vut_get_swapchain_extent(capabilities, ctx->window_extent);
     vut_get_surface_format(ctx->gpu, ctx->surface, &ctx->surface_format, &ctx->color_space);
 
+    VkSwapchainKHR old_swapchain = ctx->swapchain;
     vut_init_swapchain(ctx->gpu, ctx->device, ctx->surface, capabilities, extent,
                        ctx->surface_format, present_mode, ctx->color_space, &ctx->swapchain);
+    ctx->swapchain_extent = extent;
+    ctx->swapchain_readable =
+        (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+    vur_deletion_queue_push(&ctx->deletion_queue, VK_OBJECT_TYPE_SWAPCHAIN_KHR,
+                            (uint64_t)old_swapchain);
 }
 
 void
@@ -169,16 +384,19 @@ vur_prepare_image_views(VulkanContext* ctx)
         VK_SUCCESS) {
         // Error
     }
-    VkImage swapchain_images[ctx->swapchain_image_count];
+
+    // Lives until the swapchain is recreated, so it is allocated before the scope
+    ctx->swapchain_image_resources = VUT_ARENA_ALLOC(&ctx->init_arena, SwapchainImageResources,
+                                                     ctx->swapchain_image_count);
+
+    ArenaScope scope = vut_arena_begin_scope(&ctx->init_arena);
+    VkImage* swapchain_images =
+        VUT_ARENA_ALLOC(&ctx->init_arena, VkImage, ctx->swapchain_image_count);
     if (vkGetSwapchainImagesKHR(ctx->device, ctx->swapchain, &ctx->swapchain_image_count,
                                 swapchain_images) != VK_SUCCESS) {
         // Error
     }
 
-    // This needs to be freed in Destroy
-    ctx->swapchain_image_resources =
-        malloc(sizeof(SwapchainImageResources) * ctx->swapchain_image_count);
-
     // Init all the resources
     for (uint32_t i = 0; i < ctx->swapchain_image_count; i++) {
         ctx->swapchain_image_resources[i].image = swapchain_images[i];
@@ -186,49 +404,208 @@ vur_prepare_image_views(VulkanContext* ctx)
                             ctx->swapchain_image_resources[i].image,
                             &ctx->swapchain_image_resources[i].view);
     }
+    vut_arena_end_scope(scope);
 }
 
 void
 vur_prepare_pipeline(VulkanContext* ctx)
 {
-    VkShaderModule vert_shader_module;
-    VkShaderModule frag_shader_module;
+    // The default state of the program is the fallback for every other pipeline,
+    // so it is the only one startup has to wait for
+    PipelineDesc fallback_desc;
+    vur_pipeline_desc_init(&ctx->program, ctx->render_pass, ctx->surface_format, &fallback_desc);
+    if (vur_pipeline_manager_init(ctx->device, &ctx->pipeline_builder, FRAME_LAG, &fallback_desc,
+                                  &ctx->pipelines) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the graphics pipeline\n");
+        abort();
+    }
 
-    vut_init_shader_module(ctx->device, "../shaders/shader.vert.spv", &vert_shader_module);
-    vut_init_shader_module(ctx->device, "../shaders/shader.frag.spv", &frag_shader_module);
+    // Other descriptions are compiled in the background the first time they are drawn. The
+    // features survive a new render pass.
+    ShaderFeatureFlags features = ctx->pipeline_desc.features;
+    ctx->pipeline_desc = fallback_desc;
+    ctx->pipeline_desc.features = features;
+    ctx->pipeline_layout = ctx->program.layout;
+}
 
-    const VkPipelineShaderStageCreateInfo vert_shader_stage = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        .stage = VK_SHADER_STAGE_VERTEX_BIT,
-        .module = vert_shader_module,
-        .pName = "main",
-    };
+// Grow the draw buffer of a frame to fit all draws, the frame must not be in flight. A set
+// that failed to allocate is retried every frame, passes skip their draws meanwhile.
+static VkResult
+vur_reserve_draw_buffer(VulkanContext* ctx, FrameResources* frame, uint32_t draw_count)
+{
+    bool descriptor_buffer = ctx->layout_cache.descriptor_buffer;
+    VkDeviceSize size = draw_count * ctx->draw_stride;
+    if (size <= frame->draw_buffer_size && (descriptor_buffer || frame->draw_set)) {
+        return VK_SUCCESS;
+    }
 
-    const VkPipelineShaderStageCreateInfo frag_shader_stage = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-        .module = frag_shader_module,
-        .pName = "main",
-    };
+    // The recorded passes of the frame use the old buffer or set
+    for (uint32_t i = 0; i < VUR_PASS_COUNT; i++) {
+        frame->passes[i].hash = 0;
+    }
 
-    const VkPipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage,
-                                                              frag_shader_stage };
+    if (size > frame->draw_buffer_size) {
+        if (frame->draw_buffer_size * 2 > size) {
+            size = frame->draw_buffer_size * 2;
+        }
+        vkDestroyBuffer(ctx->device, frame->draw_buffer, vut_get_allocator());
+        vut_free_memory(ctx->device, frame->draw_memory);
 
-    const VkPipelineVertexInputStateCreateInfo vertex_input = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 0,
-        .pVertexBindingDescriptions = NULL, // Optional
-        .vertexAttributeDescriptionCount = 0,
-        .pVertexAttributeDescriptions = NULL, // Optional
-    };
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        if (descriptor_buffer) {
+            usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+        }
+
+        if (vut_init_buffer(ctx->device, ctx->gpu, size, usage,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            &frame->draw_buffer, &frame->draw_memory) != VK_SUCCESS ||
+            vkMapMemory(ctx->device, frame->draw_memory, 0, size, 0,
+                        (void**)&frame->draw_data) != VK_SUCCESS) {
+            fprintf(stderr, "Failed to create the draw buffer\n");
+            abort();
+        }
+        frame->draw_buffer_size = size;
+        frame->draw_set = VK_NULL_HANDLE;
+
+        // Every draw gets its own set, so the descriptor buffer grows with the draw buffer
+        if (descriptor_buffer) {
+            frame->draw_address = vut_get_buffer_address(ctx->device, frame->draw_buffer);
+            if (frame->descriptors.buffer) {
+                vur_descriptor_buffer_destroy(&frame->descriptors);
+            }
+            if (vur_descriptor_buffer_init(ctx->device, ctx->gpu,
+                                           size / ctx->draw_stride * ctx->draw_set_size,
+                                           &frame->descriptors) != VK_SUCCESS) {
+                fprintf(stderr, "Failed to create the descriptor buffer\n");
+                abort();
+            }
+            return VK_SUCCESS;
+        }
+    }
+
+    // Called after the fence of the frame and every pass of it is recorded again, so no
+    // command buffer still uses the old set
+    vur_descriptor_allocator_reset(&frame->set_allocator);
+    VkResult result =
+        vur_descriptor_allocator_alloc(&frame->set_allocator, ctx->descriptor_layout,
+                                       &frame->draw_set);
+    if (result != VK_SUCCESS) {
+        frame->draw_set = VK_NULL_HANDLE;
+        return result;
+    }
+    vut_write_buffer_descriptor(ctx->device, frame->draw_set, VUR_DRAW_DATA_BINDING,
+                                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frame->draw_buffer,
+                                sizeof(DrawData));
+
+    return VK_SUCCESS;
+}
 
-    const VkPipelineInputAssemblyStateCreateInfo input_assembly = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        .primitiveRestartEnable = VK_FALSE,
+// Write the draw data set of a draw into the descriptor buffer of a frame and get its offset.
+// Every draw has its own place, so passes can be recorded again without touching the others.
+static VkDeviceSize
+vur_write_draw_set(VulkanContext* ctx, FrameResources* frame, uint32_t draw_index)
+{
+    VkDeviceSize set_offset = draw_index * ctx->draw_set_size;
+    vur_descriptor_buffer_write_buffer(&frame->descriptors, set_offset + ctx->draw_binding_offset,
+                                       VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                       frame->draw_address + draw_index * ctx->draw_stride,
+                                       sizeof(DrawData));
+
+    return set_offset;
+}
+
+VkResult
+vur_prepare_frames(VulkanContext* ctx)
+{
+    VkResult result;
+
+    // Per frame descriptor sets only hold the draw data buffer for now
+    const VkDescriptorPoolSize pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 16,
     };
 
-    VkViewport viewport = {
+    // Every frame resets its own pools instead of freeing individual buffers and sets
+    for (uint32_t i = 0; i < FRAME_LAG; i++) {
+        vut_init_command_pool(ctx->device, ctx->graphics_queue_family_index,
+                              VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &ctx->frames[i].command_pool);
+        vut_alloc_command_buffer(ctx->device, ctx->frames[i].command_pool, 1,
+                                 &ctx->frames[i].command_buffer);
+        vut_init_command_pool(ctx->device, ctx->compute_queue_family_index,
+                              VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                              &ctx->frames[i].compute_command_pool);
+        vut_alloc_command_buffer(ctx->device, ctx->frames[i].compute_command_pool, 1,
+                                 &ctx->frames[i].compute_command_buffer);
+        vur_descriptor_allocator_init(ctx->device, 16, 1, &pool_size,
+                                      &ctx->frames[i].set_allocator);
+        vut_arena_init(VUR_FRAME_ARENA_SIZE, &ctx->frames[i].arena);
+
+        // Passes are recorded one at a time, whenever their draws change
+        vut_init_command_pool(ctx->device, ctx->graphics_queue_family_index,
+                              VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                              &ctx->frames[i].pass_command_pool);
+        VkCommandBuffer pass_command_buffers[VUR_PASS_COUNT];
+        result = vut_alloc_secondary_command_buffers(
+            ctx->device, ctx->frames[i].pass_command_pool, VUR_PASS_COUNT, pass_command_buffers);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        for (uint32_t j = 0; j < VUR_PASS_COUNT; j++) {
+            ctx->frames[i].passes[j].command_buffer = pass_command_buffers[j];
+        }
+    }
+
+    if (ctx->program.reflection.set_count <= VUR_DRAW_DATA_SET) {
+        return VK_SUCCESS;
+    }
+
+    // Dynamic offsets into the draw buffer must be aligned
+    VkDeviceSize alignment = ctx->gpu_properties.limits.minUniformBufferOffsetAlignment;
+    ctx->draw_stride = (sizeof(DrawData) + alignment - 1) & ~(alignment - 1);
+
+    vut_layout_cache_get_set_layout(&ctx->layout_cache,
+                                    &ctx->program.reflection.sets[VUR_DRAW_DATA_SET],
+                                    &ctx->descriptor_layout);
+
+    if (ctx->layout_cache.descriptor_buffer) {
+        // Dynamic uniform buffers do not exist with descriptor buffers, draws write a set.
+        // Sets are packed at the offset alignment.
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT properties;
+        vut_get_descriptor_buffer_properties(ctx->gpu, &properties);
+        VkDeviceSize set_alignment = properties.descriptorBufferOffsetAlignment;
+        VkDeviceSize set_size =
+            vut_get_descriptor_set_layout_size(ctx->device, ctx->descriptor_layout);
+        ctx->draw_set_size = (set_size + set_alignment - 1) & ~(set_alignment - 1);
+        ctx->draw_binding_offset = vut_get_descriptor_binding_offset(
+            ctx->device, ctx->descriptor_layout, VUR_DRAW_DATA_BINDING);
+    }
+
+    for (uint32_t i = 0; i < FRAME_LAG; i++) {
+        result = vur_reserve_draw_buffer(ctx, &ctx->frames[i], 1);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+// Recording \\\
+
+// Record the draws of a pass into its secondary command buffer. Secondary command buffers
+// inherit no state, so everything is bound again.
+static void
+vur_record_pass(VulkanContext* ctx, FrameResources* frame, uint32_t pass_index)
+{
+    const PassDraws* pass = &ctx->pass_draws[pass_index];
+    PassCache* cache = &frame->passes[pass_index];
+    VkCommandBuffer command_buffer = cache->command_buffer;
+
+    vut_begin_secondary_command_buffer(command_buffer, ctx->render_pass, ctx->surface_format);
+
+    // Viewport and scissor are dynamic so the pipeline does not depend on the window size
+    const VkViewport viewport = {
         .x = 0.0f,
         .y = 0.0f,
         .width = (float)ctx->window_extent.width,
@@ -236,98 +613,341 @@ vur_prepare_pipeline(VulkanContext* ctx)
         .minDepth = 0.0f,
         .maxDepth = 1.0f,
     };
-
-    VkRect2D scissor = {
+    const VkRect2D scissor = {
         .offset = { 0, 0 },
-        .extent.width = ctx->window_extent.width,
-        .extent.height = ctx->window_extent.height,
+        .extent = ctx->window_extent,
     };
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    DrawStats stats = { 0 };
+    const ShaderProgram* program = &ctx->program;
+    bool descriptor_buffer = ctx->layout_cache.descriptor_buffer;
+    bool has_bindless = program->reflection.set_count > VUR_BINDLESS_SET;
+    bool has_draw_set =
+        frame->draw_buffer != VK_NULL_HANDLE && (descriptor_buffer || frame->draw_set);
+    // The layout has the set of the draw buffer, without it nothing can be drawn
+    uint32_t batch_count =
+        frame->draw_buffer == VK_NULL_HANDLE || has_draw_set ? pass->batch_count : 0;
+
+    // The bindless set comes first, the sets of the frame second
+    uint32_t frame_buffer_index = 0;
+    if (descriptor_buffer) {
+        VkDescriptorBufferBindingInfoEXT bindings[2];
+        uint32_t binding_count = 0;
+        if (has_bindless) {
+            bindings[binding_count++] = vur_descriptor_buffer_binding(&ctx->bindless.descriptors);
+        }
+        if (has_draw_set) {
+            frame_buffer_index = binding_count;
+            bindings[binding_count++] = vur_descriptor_buffer_binding(&frame->descriptors);
+        }
+        if (binding_count) {
+            vut_bind_descriptor_buffers(command_buffer, binding_count, bindings);
+        }
+    }
 
-    const VkPipelineViewportStateCreateInfo viewport_state = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .pViewports = &viewport,
-        .scissorCount = 1,
-        .pScissors = &scissor,
-    };
+    // Bound once, draws select their descriptors with the material index
+    if (has_bindless && descriptor_buffer) {
+        const uint32_t buffer_index = 0;
+        vut_set_descriptor_buffer_offsets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                          ctx->pipeline_layout, VUR_BINDLESS_SET, 1, &buffer_index,
+                                          &ctx->bindless.set_offset);
+        stats.descriptor_binds++;
+    } else if (has_bindless) {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                ctx->pipeline_layout, VUR_BINDLESS_SET, 1,
+                                &ctx->bindless.descriptor_set, 0, NULL);
+        stats.descriptor_binds++;
+    }
 
-    const VkPipelineRasterizationStateCreateInfo rasterizer = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .depthClampEnable = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .lineWidth = 1.0f,
-        .cullMode = VK_CULL_MODE_BACK_BIT,
-        .frontFace = VK_FRONT_FACE_CLOCKWISE,
-        .depthBiasEnable = VK_FALSE,
-    };
+    const VkPushConstantRange* push_range = &program->reflection.push_constant_range;
+    bool use_push_constants = program->reflection.push_constant_range_count &&
+                              push_range->offset + push_range->size <= sizeof(DrawData);
+
+    // The buffer is not read, but the set still has to be bound
+    if (has_draw_set && !program->draw_data_in_buffer && descriptor_buffer) {
+        VkDeviceSize set_offset = vur_write_draw_set(ctx, frame, 0);
+        vut_set_descriptor_buffer_offsets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                          ctx->pipeline_layout, VUR_DRAW_DATA_SET, 1,
+                                          &frame_buffer_index, &set_offset);
+        stats.descriptor_binds++;
+    } else if (has_draw_set && !program->draw_data_in_buffer) {
+        const uint32_t offset = 0;
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                ctx->pipeline_layout, VUR_DRAW_DATA_SET, 1, &frame->draw_set, 1,
+                                &offset);
+        stats.descriptor_binds++;
+    }
 
-    const VkPipelineMultisampleStateCreateInfo multisampling = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .sampleShadingEnable = VK_FALSE,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-    };
+    // The draws are sorted by state, binds are only recorded where it changes
+    VkPipeline bound_pipeline = VK_NULL_HANDLE;
+    const DrawCommand* previous = NULL;
+
+    for (uint32_t b = pass->first_batch; b < pass->first_batch + batch_count; b++) {
+        const DrawBatch* batch = &ctx->draw_batches[b];
+
+        // Different states can still end up with the same pipeline, like the fallback
+        if (ctx->batch_pipelines[b] != bound_pipeline) {
+            bound_pipeline = ctx->batch_pipelines[b];
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bound_pipeline);
+            stats.pipeline_binds++;
+            stats.skipped_binds += batch->draw_count - 1;
+        } else {
+            stats.skipped_binds += batch->draw_count;
+        }
 
-    const VkPipelineColorBlendAttachmentState color_blend_attachment = {
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-                          VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-        .blendEnable = VK_FALSE,
-    };
+        for (uint32_t i = batch->first_draw; i < batch->first_draw + batch->draw_count; i++) {
+            const DrawCommand* draw = &ctx->draws[i];
+
+            if (program->draw_data_in_buffer && has_draw_set) {
+                uint32_t offset = (uint32_t)(i * ctx->draw_stride);
+                memcpy(frame->draw_data + offset, &draw->data, sizeof(DrawData));
+
+                if (descriptor_buffer) {
+                    VkDeviceSize set_offset = vur_write_draw_set(ctx, frame, i);
+                    vut_set_descriptor_buffer_offsets(
+                        command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx->pipeline_layout,
+                        VUR_DRAW_DATA_SET, 1, &frame_buffer_index, &set_offset);
+                } else {
+                    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                            ctx->pipeline_layout, VUR_DRAW_DATA_SET, 1,
+                                            &frame->draw_set, 1, &offset);
+                }
+                stats.descriptor_binds++;
+            } else if (use_push_constants && previous &&
+                       memcmp(&draw->data, &previous->data, sizeof(DrawData)) == 0) {
+                // Push constants survive pipeline binds, every variant shares the layout
+                stats.skipped_binds++;
+            } else if (use_push_constants) {
+                vkCmdPushConstants(command_buffer, ctx->pipeline_layout, push_range->stageFlags,
+                                   push_range->offset, push_range->size,
+                                   (const uint8_t*)&draw->data + push_range->offset);
+                stats.push_constant_updates++;
+            }
+
+            vkCmdDraw(command_buffer, draw->vertex_count, 1, draw->first_vertex, 0);
+            stats.draw_calls++;
+            previous = draw;
+        }
+    }
 
-    const VkPipelineColorBlendStateCreateInfo color_blending = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .logicOp = VK_LOGIC_OP_COPY,
-        .attachmentCount = 1,
-        .pAttachments = &color_blend_attachment,
-        .blendConstants[0] = 0.0f,
-        .blendConstants[1] = 0.0f,
-        .blendConstants[2] = 0.0f,
-        .blendConstants[3] = 0.0f,
-    };
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        // Error
+    }
+    cache->stats = stats;
+}
 
-    vut_init_pipeline_layout(ctx->device, NULL, &ctx->pipeline_layout);
-    vut_init_pipeline(ctx->device, shader_stages, &vertex_input, &input_assembly, &viewport_state,
-                      &rasterizer, &multisampling, &color_blending, ctx->pipeline_layout,
-                      ctx->render_pass, &ctx->pipeline);
+// Hash of everything the commands of a pass depend on besides the frame resources
+static uint64_t
+vur_hash_pass(const VulkanContext* ctx, uint32_t pass_index)
+{
+    const PassDraws* pass = &ctx->pass_draws[pass_index];
+
+    uint64_t hash = vut_hash(&pass->version, sizeof(pass->version), VUT_HASH_SEED);
+    hash = vut_hash(&ctx->window_extent, sizeof(ctx->window_extent), hash);
+    // Inherited with the render pass, a recreated swapchain can change it
+    hash = vut_hash(&ctx->surface_format, sizeof(ctx->surface_format), hash);
+    hash = vut_hash(&ctx->batch_pipelines[pass->first_batch],
+                    pass->batch_count * sizeof(VkPipeline), hash);
 
-    vkDestroyShaderModule(ctx->device, vert_shader_module, NULL);
-    vkDestroyShaderModule(ctx->device, frag_shader_module, NULL);
+    // Reserved for passes with nothing recorded
+    return hash ? hash : 1;
 }
 
 void
-vur_prepare_buffers(VulkanContext* ctx)
+vur_record_frame(VulkanContext* ctx, uint32_t image_index)
 {
-    for (uint32_t i = 0; i < ctx->swapchain_image_count; i++) {
-        vut_alloc_command_buffer(ctx->device, ctx->command_pool, 1,
-                                 &ctx->swapchain_image_resources[i].command_buffer);
+    FrameResources* frame = &ctx->frames[ctx->frame_index];
+    VkCommandBuffer command_buffer = frame->command_buffer;
+
+    // The fence of this frame has been waited on, so its commands are done executing
+    vkResetCommandPool(ctx->device, frame->command_pool, 0);
+    vut_arena_reset(&frame->arena);
+    vur_deletion_queue_begin_frame(&ctx->deletion_queue);
+    vur_pipeline_manager_begin_frame(&ctx->pipelines);
+
+    // Passes skip their draws when the set can not be allocated, the next frame tries again
+    if (frame->draw_buffer != VK_NULL_HANDLE && ctx->program.draw_data_in_buffer) {
+        vur_reserve_draw_buffer(ctx, frame, ctx->draw_count);
     }
-}
 
-// Recording \\\
+    // Never blocks, a pipeline that is still compiling is replaced by the fallback. A pass
+    // is recorded again when its pipeline changes, once the real one is ready.
+    PipelineDesc desc = ctx->pipeline_desc;
+    for (uint32_t i = 0; i < ctx->batch_count; i++) {
+        const DrawBatch* batch = &ctx->draw_batches[i];
+        desc.features = ctx->pipeline_desc.features | batch->features;
+        desc.blend_enable = ctx->pipeline_desc.blend_enable ||
+                            batch->pass == VUR_PASS_TRANSPARENT;
+        ctx->batch_pipelines[i] = vur_pipeline_manager_get(&ctx->pipelines, &desc);
+    }
 
-void
-vur_record_buffers(VulkanContext* ctx)
+    // Only passes whose draws, pipelines or viewport changed are recorded
+    DrawStats stats = { 0 };
+    VkCommandBuffer pass_command_buffers[VUR_PASS_COUNT];
+    uint32_t pass_count = 0;
+    for (uint32_t i = 0; i < VUR_PASS_COUNT; i++) {
+        if (ctx->pass_draws[i].draw_count == 0) {
+            continue;
+        }
+
+        PassCache* cache = &frame->passes[i];
+        uint64_t hash = vur_hash_pass(ctx, i);
+        if (cache->hash == hash) {
+            stats.reused_passes++;
+        } else {
+            vur_record_pass(ctx, frame, i);
+            cache->hash = hash;
+            stats.recorded_passes++;
+        }
+
+        stats.draw_calls += cache->stats.draw_calls;
+        stats.pipeline_binds += cache->stats.pipeline_binds;
+        stats.descriptor_binds += cache->stats.descriptor_binds;
+        stats.push_constant_updates += cache->stats.push_constant_updates;
+        stats.skipped_binds += cache->stats.skipped_binds;
+        pass_command_buffers[pass_count++] = cache->command_buffer;
+    }
+    ctx->draw_stats = stats;
+
+    const SwapchainImageResources* image = &ctx->swapchain_image_resources[image_index];
+
+    vut_begin_command_buffer(command_buffer);
+    if (ctx->features.dynamic_rendering) {
+        // The render pass did the layout transitions, now they are done by hand. The
+        // previous contents are cleared, so the old layout can be undefined.
+        vut_transition_image(command_buffer, image->image, VK_IMAGE_ASPECT_COLOR_BIT,
+                             VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+        vut_begin_rendering(command_buffer, image->view, ctx->window_extent,
+                            VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    } else {
+        vut_begin_render_pass(command_buffer, ctx->render_pass, image->framebuffer,
+                              ctx->window_extent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }
+
+    if (pass_count) {
+        vkCmdExecuteCommands(command_buffer, pass_count, pass_command_buffers);
+    }
+
+    // Finishing up
+    if (ctx->features.dynamic_rendering) {
+        vut_end_rendering(command_buffer);
+        vut_transition_image(command_buffer, image->image, VK_IMAGE_ASPECT_COLOR_BIT,
+                             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                             VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    } else {
+        vkCmdEndRenderPass(command_buffer);
+    }
+
+    // After all other work, so reads see everything the frame wrote
+    vur_readback_record(&ctx->readback, command_buffer, ctx->frame_index);
+    if (ctx->capturing) {
+        vur_readback_record(&ctx->capture_readback, command_buffer, ctx->frame_index);
+    }
+
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        // Error
+    }
+}
+
+static bool
+vur_submit_compute(VulkanContext* ctx)
 {
-    for (size_t i = 0; i < ctx->swapchain_image_count; i++) {
-        vut_begin_command_buffer(ctx->swapchain_image_resources[i].command_buffer);
-        vut_begin_render_pass(ctx->swapchain_image_resources[i].command_buffer, ctx->render_pass,
-                              ctx->swapchain_image_resources[i].framebuffer, ctx->window_extent);
+    if (ctx->compute_callback == NULL) {
+        return false;
+    }
 
-        // Bind pipeline to command buffer and specify its type (graphics or compute)
-        vkCmdBindPipeline(ctx->swapchain_image_resources[i].command_buffer,
-                          VK_PIPELINE_BIND_POINT_GRAPHICS, ctx->pipeline);
+    // The graphics work of the frame waits on this, so its fence covers the compute pool
+    FrameResources* frame = &ctx->frames[ctx->frame_index];
+    vkResetCommandPool(ctx->device, frame->compute_command_pool, 0);
+    vut_begin_command_buffer(frame->compute_command_buffer);
+    ctx->compute_callback(frame->compute_command_buffer, ctx->frame_index,
+                          ctx->compute_user_data);
+    if (vkEndCommandBuffer(frame->compute_command_buffer) != VK_SUCCESS) {
+        // Error
+    }
 
-        // Record the pipeline in the command buffer
-        vkCmdDraw(ctx->swapchain_image_resources[i].command_buffer, 3, 1, 0, 0);
+    const VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .waitSemaphoreCount = 0,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &frame->compute_command_buffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &ctx->compute_complete_semaphores[ctx->frame_index],
+    };
+    if (vkQueueSubmit(ctx->compute_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+        // Error
+    }
 
-        // Finishing up
-        vkCmdEndRenderPass(ctx->swapchain_image_resources[i].command_buffer);
+    return true;
+}
 
-        if (vkEndCommandBuffer(ctx->swapchain_image_resources[i].command_buffer) != VK_SUCCESS) {
-            // Error
+// Readback callback of a captured frame, the user data is the renderer
+static void
+vur_capture_arrived(void* data, VkDeviceSize size, void* user_data)
+{
+    (void)size;
+    FrameCapture* capture = &((VulkanContext*)user_data)->capture;
+    for (uint32_t i = 0; i < capture->slot_count; i++) {
+        if (capture->slots[i].pixels == data) {
+            vur_capture_submit(capture, &capture->slots[i]);
+            return;
+        }
+    }
+}
+
+// Grows the capture staging to a swapchain image per frame once the frames in flight are
+// done with the old buffers
+static bool
+vur_capture_reserve(VulkanContext* ctx, VkDeviceSize size)
+{
+    Readback* readback = &ctx->capture_readback;
+    if (readback->frame_size >= size) {
+        return true;
+    }
+
+    if (readback->frame_size) {
+        vkDeviceWaitIdle(ctx->device);
+        for (uint32_t i = 0; i < FRAME_LAG; i++) {
+            vur_readback_complete(readback, i);
         }
+        vur_readback_destroy(readback);
+    }
+
+    if (vur_readback_init(ctx->device, ctx->gpu, FRAME_LAG, size, readback) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create the capture staging buffers\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Queues the copy of the image the frame renders to. The staging of the frame is empty and
+// large enough, so the copy is recorded by this frame. Dropped when no slot is free.
+static void
+vur_capture_frame(VulkanContext* ctx, uint32_t image_index)
+{
+    VkExtent2D extent = ctx->swapchain_extent;
+    if (!vur_capture_reserve(ctx, (VkDeviceSize)extent.width * extent.height * 4)) {
+        return;
+    }
+
+    CaptureSlot* slot = vur_capture_acquire(&ctx->capture, extent.width, extent.height);
+    if (slot == NULL) {
+        return;
     }
+
+    vur_readback_request_image(&ctx->capture_readback,
+                               ctx->swapchain_image_resources[image_index].image,
+                               VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, ctx->surface_format, extent, 4,
+                               slot->pixels, vur_capture_arrived, ctx);
 }
 
 // Main render loop
@@ -336,37 +956,66 @@ vur_draw(VulkanContext* ctx)
 {
     VkResult result;
 
+    // Nothing changed, the presented image is still right
+    if (ctx->on_demand && !atomic_exchange(&ctx->redraw, false)) {
+        return;
+    }
+
     result = vkWaitForFences(ctx->device, 1, &ctx->fences[ctx->frame_index], VK_TRUE, UINT64_MAX);
 
+    // Runs the memory pressure callback, which may free resources of finished frames
+    vut_memory_budget_update(&ctx->memory_budget);
+    vur_readback_complete(&ctx->readback, ctx->frame_index);
+    if (ctx->capturing) {
+        vur_readback_complete(&ctx->capture_readback, ctx->frame_index);
+    }
+#ifdef VUR_USE_HOST_ALLOCATOR
+    vut_host_allocator_begin_frame(&ctx->host_allocator);
+#endif
+
     uint32_t imageIndex;
     result = vkAcquireNextImageKHR(ctx->device, ctx->swapchain, UINT64_MAX,
                                    ctx->image_acquired_semaphores[ctx->frame_index], VK_NULL_HANDLE,
                                    &imageIndex);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         // Swapchain is out of date (e.g. the window was resized) and
         // must be recreated:
-        ctx->framebuffer_resized = false;
+        atomic_store_explicit(&ctx->framebuffer_resized, false, memory_order_relaxed);
         vur_resize(ctx);
         return;
     }
 
-    VkSemaphore waitSemaphores[] = { ctx->image_acquired_semaphores[ctx->frame_index] };
+    if (ctx->capturing) {
+        vur_capture_frame(ctx, imageIndex);
+    }
+
+    // Compute is submitted first so it can start while the previous frame rasterizes
+    bool compute_submitted = vur_submit_compute(ctx);
+    vur_record_frame(ctx, imageIndex);
+
+    VkSemaphore waitSemaphores[] = {
+        ctx->image_acquired_semaphores[ctx->frame_index],
+        ctx->compute_complete_semaphores[ctx->frame_index],
+    };
     VkSemaphore signalSemaphores[] = { ctx->draw_complete_semaphores[ctx->frame_index] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    VkPipelineStageFlags waitStages[] = {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        ctx->compute_wait_stages,
+    };
 
     const VkSubmitInfo submit_info = {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = 1,
+        .waitSemaphoreCount = compute_submitted ? 2 : 1,
         .pWaitSemaphores = waitSemaphores,
         .pWaitDstStageMask = waitStages,
         .commandBufferCount = 1,
-        .pCommandBuffers = &ctx->swapchain_image_resources[imageIndex].command_buffer,
+        .pCommandBuffers = &ctx->frames[ctx->frame_index].command_buffer,
         .signalSemaphoreCount = 1,
         .pSignalSemaphores = signalSemaphores,
     };
 
-    result = vkResetFences(ctx->device, 1, &ctx->fences[ctx->frame_index]);
+    vkResetFences(ctx->device, 1, &ctx->fences[ctx->frame_index]);
 
     if (vkQueueSubmit(ctx->graphics_queue, 1, &submit_info, ctx->fences[ctx->frame_index]) !=
         VK_SUCCESS) {
@@ -384,69 +1033,506 @@ vur_draw(VulkanContext* ctx)
         .pImageIndices = &imageIndex,
     };
 
-    vkQueuePresentKHR(ctx->present_queue, &present_info);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
-        ctx->framebuffer_resized) {
-        ctx->framebuffer_resized = false;
+    result = vkQueuePresentKHR(ctx->present_queue, &present_info);
+
+    // The frame was submitted, so the next one uses the next fence even when resizing.
+    // The deletion queue relies on every recorded frame advancing the index.
+    ctx->frame_index = (ctx->frame_index + 1) % FRAME_LAG;
+
+    // Acquire pairs with the resize callback, the extent read by vur_resize is the new one
+    bool resized = atomic_exchange_explicit(&ctx->framebuffer_resized, false,
+                                            memory_order_acquire);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || resized) {
         vur_resize(ctx);
-        return;
     } else if (result != VK_SUCCESS) {
         // Error
     }
 
-    ctx->frame_index = (ctx->frame_index + 1) % FRAME_LAG;
+    // Compiling pipelines replace the fallback and readbacks arrive only in later frames
+    if (ctx->on_demand &&
+        (vur_pipeline_manager_busy(&ctx->pipelines) || vur_readback_busy(&ctx->readback) ||
+         vur_readback_busy(&ctx->capture_readback))) {
+        atomic_store(&ctx->redraw, true);
+    }
+}
+
+// Key of the pipeline variant, features that do not fit only make the sort less good
+static uint32_t
+vur_draw_pipeline_id(ShaderFeatureFlags features)
+{
+    uint32_t lights = (features & VUR_FEATURE_LIGHT_COUNT_MASK) >> VUR_FEATURE_LIGHT_COUNT_SHIFT;
+    return (features & 0xfu) | (lights << 4);
+}
+
+// Draws that record the same commands, the depth only decided their order
+static bool
+vur_same_draw(const DrawCommand* a, const DrawCommand* b)
+{
+    return memcmp(a->data.transform, b->data.transform, sizeof(mat4)) == 0 &&
+           a->data.material == b->data.material && a->vertex_count == b->vertex_count &&
+           a->first_vertex == b->first_vertex && a->pass == b->pass &&
+           a->features == b->features;
+}
+
+static bool
+vur_grow_draws(VulkanContext* ctx, uint32_t count)
+{
+    // Each array is kept once it has grown, the capacity only counts when all of them have
+    DrawCommand* draws = realloc(ctx->draws, count * sizeof(DrawCommand));
+    if (draws == NULL) {
+        return false;
+    }
+    ctx->draws = draws;
+
+    DrawBatch* batches = realloc(ctx->draw_batches, count * sizeof(DrawBatch));
+    if (batches == NULL) {
+        return false;
+    }
+    ctx->draw_batches = batches;
+
+    VkPipeline* pipelines = realloc(ctx->batch_pipelines, count * sizeof(VkPipeline));
+    if (pipelines == NULL) {
+        return false;
+    }
+    ctx->batch_pipelines = pipelines;
+
+    // Keys and order with the scratch of the sort behind them
+    uint64_t* keys = realloc(ctx->draw_keys, 2 * (size_t)count * sizeof(uint64_t));
+    if (keys == NULL) {
+        return false;
+    }
+    ctx->draw_keys = keys;
+
+    uint32_t* order = realloc(ctx->draw_order, 2 * (size_t)count * sizeof(uint32_t));
+    if (order == NULL) {
+        return false;
+    }
+    ctx->draw_order = order;
+
+    ctx->draw_capacity = count;
+    return true;
+}
+
+bool
+vur_set_draws(VulkanContext* ctx, uint32_t count, const DrawCommand draws[])
+{
+    for (uint32_t i = 0; i < count; i++) {
+        if (draws[i].pass >= VUR_PASS_COUNT) {
+            fprintf(stderr, "Draw %u uses pass %u, there are %u\n", i, draws[i].pass,
+                    VUR_PASS_COUNT);
+            return false;
+        }
+    }
+
+    // Kept until the list grows, so the sort allocates nothing per frame
+    if (count > ctx->draw_capacity && !vur_grow_draws(ctx, count)) {
+        fprintf(stderr, "Failed to allocate %u draws\n", count);
+        return false;
+    }
+
+    uint64_t* keys = ctx->draw_keys;
+    uint32_t* order = ctx->draw_order;
+    for (uint32_t i = 0; i < count; i++) {
+        const DrawCommand* draw = &draws[i];
+        keys[i] = vur_draw_key(draw->pass, vur_draw_pipeline_id(draw->features),
+                               draw->data.material, draw->first_vertex, draw->depth);
+        order[i] = i;
+    }
+    vut_radix_sort(keys, order, count, keys + count, order + count);
+
+    // Compared with the old list in place, so a static scene keeps its recorded passes.
+    // Comparing is exact and faster than hashing the draws.
+    bool changed[VUR_PASS_COUNT] = { false };
+    for (uint32_t i = 0; i < count; i++) {
+        const DrawCommand* draw = &draws[order[i]];
+        if (i >= ctx->draw_count || !vur_same_draw(&ctx->draws[i], draw)) {
+            changed[draw->pass] = true;
+        }
+        ctx->draws[i] = *draw;
+    }
+    ctx->draw_count = count;
+
+    PassDraws previous[VUR_PASS_COUNT];
+    memcpy(previous, ctx->pass_draws, sizeof(previous));
+    for (uint32_t i = 0; i < VUR_PASS_COUNT; i++) {
+        ctx->pass_draws[i] = (PassDraws){ .version = previous[i].version };
+    }
+
+    // The sorted draws of a pass are next to each other, and so are its batches
+    ctx->batch_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const DrawCommand* draw = &ctx->draws[i];
+        PassDraws* pass = &ctx->pass_draws[draw->pass];
+        if (pass->draw_count == 0) {
+            pass->first_draw = i;
+            pass->first_batch = ctx->batch_count;
+        }
+
+        if (pass->batch_count == 0 ||
+            ctx->draw_batches[ctx->batch_count - 1].features != draw->features) {
+            ctx->draw_batches[ctx->batch_count++] = (DrawBatch){
+                .first_draw = i,
+                .pass = draw->pass,
+                .features = draw->features,
+            };
+            pass->batch_count++;
+        }
+
+        ctx->draw_batches[ctx->batch_count - 1].draw_count++;
+        pass->draw_count++;
+    }
+
+    // Draws that moved use other places in the draw buffer, so they count as changed
+    for (uint32_t i = 0; i < VUR_PASS_COUNT; i++) {
+        PassDraws* pass = &ctx->pass_draws[i];
+        if (changed[i] || pass->first_draw != previous[i].first_draw ||
+            pass->draw_count != previous[i].draw_count) {
+            pass->version++;
+            vur_mark_dirty(ctx);
+        }
+    }
+
+    return true;
 }
 
 void
-vur_resize(VulkanContext* ctx)
+vur_set_shader_features(VulkanContext* ctx, ShaderFeatureFlags features)
 {
+    assert(vur_on_render_thread(ctx));
+
+    // Variants are cached by their description, so switching back is free
+    if (ctx->pipeline_desc.features != features) {
+        ctx->pipeline_desc.features = features;
+        vur_mark_dirty(ctx);
+    }
+}
+
+DrawStats
+vur_get_draw_stats(const VulkanContext* ctx)
+{
+    return ctx->draw_stats;
+}
+
+void
+vur_set_memory_pressure_callback(VulkanContext* ctx,
+                                 float threshold,
+                                 MemoryPressureCallback callback,
+                                 void* user_data)
+{
+    vut_memory_budget_set_policy(&ctx->memory_budget, threshold, callback, user_data);
+}
+
+void
+vur_set_compute_callback(VulkanContext* ctx,
+                         VkPipelineStageFlags wait_stages,
+                         ComputeCallback callback,
+                         void* user_data)
+{
+    assert(vur_on_render_thread(ctx));
+
+    // A wait needs a stage, the shaders are where compute results are usually read
+    if (wait_stages == 0) {
+        wait_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+    ctx->compute_wait_stages = wait_stages;
+    ctx->compute_callback = callback;
+    ctx->compute_user_data = user_data;
+    vur_mark_dirty(ctx);
+}
+
+VkResult
+vur_create_compute_program(VulkanContext* ctx,
+                           const uint32_t code[],
+                           size_t size,
+                           ComputeProgram* program)
+{
+    // Shares the layouts and pipeline cache of the graphics programs
+    const ReflectedSet* bindless_set = ctx->features.descriptor_indexing ? &ctx->bindless.set
+                                                                         : NULL;
+    return vur_init_compute_program(ctx->device, &ctx->layout_cache, ctx->pipeline_builder.cache,
+                                    bindless_set, code, size, program);
+}
+
+ReadbackTicket
+vur_read_buffer(VulkanContext* ctx,
+                VkBuffer buffer,
+                VkDeviceSize offset,
+                VkDeviceSize size,
+                void* dst,
+                ReadbackCallback callback,
+                void* user_data)
+{
+    assert(vur_on_render_thread(ctx));
+
+    // Requests are recorded into the next frame, so there has to be one
+    vur_mark_dirty(ctx);
+    return vur_readback_request_buffer(&ctx->readback, buffer, offset, size, dst, callback,
+                                       user_data);
+}
+
+ReadbackTicket
+vur_read_image(VulkanContext* ctx,
+               VkImage image,
+               VkImageLayout layout,
+               VkFormat format,
+               VkExtent2D extent,
+               uint32_t texel_size,
+               void* dst,
+               ReadbackCallback callback,
+               void* user_data)
+{
+    assert(vur_on_render_thread(ctx));
+
+    vur_mark_dirty(ctx);
+    return vur_readback_request_image(&ctx->readback, image, layout, format, extent, texel_size,
+                                      dst, callback, user_data);
+}
+
+bool
+vur_is_read_done(const VulkanContext* ctx, ReadbackTicket ticket)
+{
+    return vur_readback_is_done(&ctx->readback, ticket);
+}
+
+static void*
+vur_render_thread(void* data)
+{
+    VulkanContext* ctx = data;
+
+    // Resizes recreate the swapchain on this thread, the init arena is ours until we stop
+    vut_set_scratch_arena(&ctx->init_arena);
+
+    while (!atomic_load(&ctx->render_thread_quit)) {
+        // A snapshot stays ours until the next read, the draws are copied anyway
+        if (ctx->on_demand) {
+            vur_wait_render_thread(ctx);
+        }
+
+        bool fresh;
+        const SceneSnapshot* snapshot = vut_triple_buffer_read(&ctx->snapshots, &fresh);
+        if (fresh) {
+            if (memcmp(snapshot->view, ctx->view, sizeof(mat4)) != 0 ||
+                memcmp(snapshot->projection, ctx->projection, sizeof(mat4)) != 0) {
+                vur_mark_dirty(ctx);
+            }
+            glm_mat4_copy((vec4*)snapshot->view, ctx->view);
+            glm_mat4_copy((vec4*)snapshot->projection, ctx->projection);
+            vur_set_shader_features(ctx, snapshot->features);
+            vur_set_draws(ctx, snapshot->draw_count, snapshot->draws);
+        }
+
+        vur_draw(ctx);
+    }
+
+    vut_set_scratch_arena(NULL);
+    return NULL;
+}
+
+void
+vur_start_render_thread(VulkanContext* ctx)
+{
+    if (atomic_load(&ctx->render_thread_running)) {
+        return;
+    }
+
+    vut_triple_buffer_init(sizeof(SceneSnapshot), &ctx->snapshots);
+    atomic_store(&ctx->framebuffer_extent,
+                 ((unsigned long long)ctx->window_extent.width << 32) |
+                     ctx->window_extent.height);
+    atomic_store(&ctx->render_thread_quit, false);
+
+    atomic_store(&ctx->render_thread_running, true);
+    if (pthread_create(&ctx->render_thread, NULL, vur_render_thread, ctx) != 0) {
+        fprintf(stderr, "Failed to start the render thread\n");
+        abort();
+    }
+}
+
+void
+vur_stop_render_thread(VulkanContext* ctx)
+{
+    if (!atomic_load(&ctx->render_thread_running)) {
+        return;
+    }
+
+    atomic_store(&ctx->render_thread_quit, true);
+    vur_wake_render_thread(ctx);
+    pthread_join(ctx->render_thread, NULL);
+    atomic_store(&ctx->render_thread_running, false);
+
+    // Each buffer owns the draws it was given, NULL when it was never written
+    for (uint32_t i = 0; i < 3; i++) {
+        SceneSnapshot* snapshot =
+            (SceneSnapshot*)(ctx->snapshots.data + i * ctx->snapshots.stride);
+        free(snapshot->draws);
+    }
+    vut_triple_buffer_destroy(&ctx->snapshots);
+}
+
+SceneSnapshot*
+vur_begin_snapshot(VulkanContext* ctx)
+{
+    return vut_triple_buffer_write(&ctx->snapshots);
+}
+
+DrawCommand*
+vur_snapshot_alloc_draws(SceneSnapshot* snapshot, uint32_t count)
+{
+    if (count > snapshot->draw_capacity) {
+        DrawCommand* draws = realloc(snapshot->draws, count * sizeof(DrawCommand));
+        if (draws == NULL) {
+            return NULL;
+        }
+        snapshot->draws = draws;
+        snapshot->draw_capacity = count;
+    }
+    snapshot->draw_count = count;
+
+    return snapshot->draws;
+}
+
+void
+vur_publish_snapshot(VulkanContext* ctx)
+{
+    vut_triple_buffer_publish(&ctx->snapshots);
+
+    // Whether the snapshot changes the image is up to the render thread
+    if (ctx->on_demand) {
+        vur_wake_render_thread(ctx);
+    }
+}
+
+void
+vur_run_jobs(VulkanContext* ctx, JobDecl decls[], uint32_t count, JobCounter* counter)
+{
+    vut_jobs_run(&ctx->jobs, decls, count, counter);
+}
+
+void
+vur_run_jobs_after(VulkanContext* ctx,
+                   JobCounter* dependency,
+                   JobDecl decls[],
+                   uint32_t count,
+                   JobCounter* counter)
+{
+    vut_jobs_run_after(&ctx->jobs, dependency, decls, count, counter);
+}
+
+void
+vur_wait_jobs(VulkanContext* ctx, JobCounter* counter)
+{
+    vut_jobs_wait(&ctx->jobs, counter);
+}
+
+bool
+vur_start_capture(VulkanContext* ctx, const char prefix[], CaptureFormat format)
+{
+    assert(vur_on_render_thread(ctx));
+
+    // Every presented frame is written, so the next one has to be drawn
+    vur_mark_dirty(ctx);
+    if (ctx->capturing) {
+        vur_stop_capture(ctx);
+    }
+
+    // Other formats would need a conversion, the swapchain is 8 bit in practice
+    bool bgra = ctx->surface_format == VK_FORMAT_B8G8R8A8_UNORM ||
+                ctx->surface_format == VK_FORMAT_B8G8R8A8_SRGB;
+    bool rgba = ctx->surface_format == VK_FORMAT_R8G8B8A8_UNORM ||
+                ctx->surface_format == VK_FORMAT_R8G8B8A8_SRGB;
+    if (!ctx->swapchain_readable || !(bgra || rgba)) {
+        fprintf(stderr, "The swapchain images can not be captured\n");
+        return false;
+    }
+
+    ctx->capturing = vur_capture_init(prefix, format, bgra, VUR_CAPTURE_SLOTS,
+                                      VUR_CAPTURE_THREADS, &ctx->capture);
+    return ctx->capturing;
+}
+
+void
+vur_stop_capture(VulkanContext* ctx)
+{
+    assert(vur_on_render_thread(ctx));
+
+    if (!ctx->capturing) {
+        return;
+    }
+
+    // Deliver the frames in flight before the workers stop
     vkDeviceWaitIdle(ctx->device);
+    for (uint32_t i = 0; i < FRAME_LAG; i++) {
+        vur_readback_complete(&ctx->capture_readback, i);
+    }
+    vur_readback_destroy(&ctx->capture_readback);
 
+    vur_capture_destroy(&ctx->capture);
+    ctx->capturing = false;
+}
+
+void
+vur_resize(VulkanContext* ctx)
+{
+    // No wait for the device, the old objects go to the deletion queue
     vur_update_window_size(ctx);
 
     // If minimized
     while (ctx->window_extent.width == 0 || ctx->window_extent.height == 0) {
+        if (atomic_load(&ctx->render_thread_running)) {
+            // The window thread handles the events, check back in a while
+            if (atomic_load(&ctx->render_thread_quit)) {
+                return;
+            }
+            nanosleep(&(struct timespec){ .tv_nsec = 10 * 1000 * 1000 }, NULL);
+        } else {
+            glfwWaitEvents();
+        }
         vur_update_window_size(ctx);
-        glfwWaitEvents();
     }
 
     vur_destroy_pipeline(ctx);
 
+    // The image of the new size has not been drawn yet
+    atomic_store(&ctx->redraw, true);
+
     printf("Resizing window! Current size is { %d, %d }\n", ctx->window_extent.width,
            ctx->window_extent.height);
     // Second, re-perform the vur_prepare() function, which will re-create the
-    // swapchain:
+    // swapchain. Recorded passes depend on the extent, so they pick up the new size.
     vur_prepare(ctx);
-    vur_record_buffers(ctx);
 }
 
 void
 vur_destroy_pipeline(VulkanContext* ctx)
 {
+    // Frames in flight may still render to the images. Framebuffers are null handles when
+    // using dynamic rendering, those are skipped.
     for (uint32_t i = 0; i < ctx->swapchain_image_count; i++) {
-        vkDestroyFramebuffer(ctx->device, ctx->swapchain_image_resources[i].framebuffer, NULL);
+        const SwapchainImageResources* image = &ctx->swapchain_image_resources[i];
+        vur_deletion_queue_push(&ctx->deletion_queue, VK_OBJECT_TYPE_FRAMEBUFFER,
+                                (uint64_t)image->framebuffer);
+        vur_deletion_queue_push(&ctx->deletion_queue, VK_OBJECT_TYPE_IMAGE_VIEW,
+                                (uint64_t)image->view);
     }
 
-    vkDestroyPipeline(ctx->device, ctx->pipeline, NULL);
-    vkDestroyPipelineLayout(ctx->device, ctx->pipeline_layout, NULL);
-    vkDestroyRenderPass(ctx->device, ctx->render_pass, NULL);
-
-    for (uint32_t i = 0; i < ctx->swapchain_image_count; i++) {
-        vkDestroyImageView(ctx->device, ctx->swapchain_image_resources[i].view, NULL);
-        vkFreeCommandBuffers(ctx->device, ctx->command_pool, 1,
-                             &ctx->swapchain_image_resources[i].command_buffer);
-    }
-    free(ctx->swapchain_image_resources);
+    // Nothing but the swapchain image resources outlives a scope of the init arena
+    vut_arena_reset(&ctx->init_arena);
+    ctx->swapchain_image_resources = NULL;
 }
 
 void
 vur_destroy(VulkanContext* ctx)
 {
     // Make sure the vulkan is ready to be destroyed
+    vur_stop_render_thread(ctx);
     vkDeviceWaitIdle(ctx->device);
+    vur_stop_capture(ctx);
 
-    // Destroys are in different function because of resizing
+    // Destroys are in different function because of resizing. The device is idle, so
+    // everything that was retired can go.
     vur_destroy_pipeline(ctx);
+    vur_deletion_queue_destroy(&ctx->deletion_queue);
+    vur_readback_destroy(&ctx->readback);
 
     // Wait for fences from present operations
     for (uint32_t i = 0; i < FRAME_LAG; i++) {
@@ -454,16 +1540,54 @@ vur_destroy(VulkanContext* ctx)
         if (result != VK_SUCCESS) {
             // Error
         }
-        vkDestroyFence(ctx->device, ctx->fences[i], NULL);
-        vkDestroySemaphore(ctx->device, ctx->image_acquired_semaphores[i], NULL);
-        vkDestroySemaphore(ctx->device, ctx->draw_complete_semaphores[i], NULL);
+        vkDestroyFence(ctx->device, ctx->fences[i], vut_get_allocator());
+        vkDestroySemaphore(ctx->device, ctx->image_acquired_semaphores[i], vut_get_allocator());
+        vkDestroySemaphore(ctx->device, ctx->draw_complete_semaphores[i], vut_get_allocator());
+        vkDestroySemaphore(ctx->device, ctx->compute_complete_semaphores[i],
+                           vut_get_allocator());
+        vkDestroyCommandPool(ctx->device, ctx->frames[i].command_pool, vut_get_allocator());
+        vkDestroyCommandPool(ctx->device, ctx->frames[i].compute_command_pool,
+                             vut_get_allocator());
+        vkDestroyCommandPool(ctx->device, ctx->frames[i].pass_command_pool,
+                             vut_get_allocator());
+        vkDestroyBuffer(ctx->device, ctx->frames[i].draw_buffer, vut_get_allocator());
+        vut_free_memory(ctx->device, ctx->frames[i].draw_memory);
+        if (ctx->frames[i].descriptors.buffer) {
+            vur_descriptor_buffer_destroy(&ctx->frames[i].descriptors);
+        }
+        vur_descriptor_allocator_destroy(&ctx->frames[i].set_allocator);
+        vut_arena_destroy(&ctx->frames[i].arena);
     }
 
-    vkDestroyCommandPool(ctx->device, ctx->command_pool, NULL);
-    vkDestroySwapchainKHR(ctx->device, ctx->swapchain, NULL);
-    vkDestroySurfaceKHR(ctx->instance, ctx->surface, NULL);
-    vkDestroyDevice(ctx->device, NULL);
-    vkDestroyInstance(ctx->instance, NULL);
+    // The set layout is owned by the layout cache
+    vur_bindless_destroy(&ctx->bindless);
+    free(ctx->draws);
+    free(ctx->draw_batches);
+    free(ctx->batch_pipelines);
+    free(ctx->draw_keys);
+    free(ctx->draw_order);
+
+    vur_pipeline_manager_destroy(&ctx->pipelines);
+    vkDestroyRenderPass(ctx->device, ctx->render_pass, vut_get_allocator());
+    vur_pipeline_builder_destroy(&ctx->pipeline_builder);
+    vur_destroy_shader_program(ctx->device, &ctx->program);
+    vut_layout_cache_destroy(&ctx->layout_cache);
+    vkDestroyCommandPool(ctx->device, ctx->command_pool, vut_get_allocator());
+    vkDestroySwapchainKHR(ctx->device, ctx->swapchain, vut_get_allocator());
+    vut_set_memory_budget(NULL);
+    vut_memory_budget_destroy(&ctx->memory_budget);
+    vkDestroySurfaceKHR(ctx->instance, ctx->surface, vut_get_allocator());
+    vkDestroyDevice(ctx->device, vut_get_allocator());
+    vkDestroyInstance(ctx->instance, vut_get_allocator());
+#ifdef VUR_USE_HOST_ALLOCATOR
+    vut_set_allocator(NULL);
+    vut_host_allocator_destroy(&ctx->host_allocator);
+#endif
+    vut_set_scratch_arena(NULL);
+    vut_arena_destroy(&ctx->init_arena);
+    vut_jobs_destroy(&ctx->jobs);
+    pthread_cond_destroy(&ctx->idle_condition);
+    pthread_mutex_destroy(&ctx->idle_mutex);
 
     // Close any open window
     glfwTerminate();
@@ -7,8 +7,33 @@
 // TODO: Fix
 #include "../extern/cglm/include/cglm/cglm.h"
 
+#include "bindless.h"
+#include "capture.h"
+#include "compute.h"
+#include "deletion_queue.h"
+#include "descriptor_allocator.h"
+#include "draw_sort.h"
+#include "jobs.h"
+#include "pipeline.h"
+#include "readback.h"
+#include "transform.h"
+#include "triple_buffer.h"
+#include "vk_util.h"
+
 #define FRAME_LAG 2
 
+// Capacity of the linear arenas for temporary CPU data
+#define VUR_INIT_ARENA_SIZE (256 * 1024)
+#define VUR_FRAME_ARENA_SIZE (64 * 1024)
+
+// Staging memory per frame for vur_read_buffer and vur_read_image. Captures have their own,
+// sized from the swapchain.
+#define VUR_READBACK_FRAME_SIZE (16 * 1024 * 1024)
+
+// Frames that can be between the GPU copy and the written file, and the encoding threads
+#define VUR_CAPTURE_SLOTS 8
+#define VUR_CAPTURE_THREADS 3
+
 /*
  * structure to track all objects related to a texture.
  */
@@ -33,7 +58,6 @@ struct texture_object
 typedef struct
 {
     VkImage image;
-    VkCommandBuffer command_buffer;
     VkImageView view;
     VkBuffer uniform_buffer;
     VkDeviceMemory uniform_memory;
@@ -41,6 +65,156 @@ typedef struct
     VkDescriptorSet descriptor_set;
 } SwapchainImageResources;
 
+/**
+ * @brief Per draw shader parameters. Pushed as push constants, so keep it small.
+ * The layout must match DrawData in the shaders. The material is the index into the
+ * bindless arrays, VUR_BINDLESS_NONE draws without a texture.
+ */
+typedef struct
+{
+    mat4 transform;
+    uint32_t material;
+} DrawData;
+
+/**
+ * @brief One draw of the draw list. Draws are sorted by their state when they are set, so
+ * zero initialize the ones that are not used: a zero draw is opaque with the features
+ * set with vur_set_shader_features.
+ */
+typedef struct
+{
+    DrawData data;
+    uint32_t vertex_count;
+    uint32_t first_vertex;
+
+    // The DrawPass, transparent draws are blended
+    uint32_t pass;
+    // Added to the features of the renderer for this draw
+    ShaderFeatureFlags features;
+    // Distance to the camera, orders the draws within their state or pass
+    float depth;
+} DrawCommand;
+
+/**
+ * @brief Work executed for the draw list of the last frame. Passes whose draws did not
+ * change reuse their commands, only the recorded passes cost CPU time.
+ */
+typedef struct
+{
+    uint32_t draw_calls;
+    uint32_t pipeline_binds;
+    uint32_t descriptor_binds;
+    uint32_t push_constant_updates;
+    // Binds and pushes left out because the state was already set
+    uint32_t skipped_binds;
+
+    uint32_t recorded_passes;
+    uint32_t reused_passes;
+} DrawStats;
+
+/**
+ * @brief Sorted draws that share their pass and shader features, so one pipeline
+ */
+typedef struct
+{
+    uint32_t first_draw;
+    uint32_t draw_count;
+    uint32_t pass;
+    ShaderFeatureFlags features;
+} DrawBatch;
+
+/**
+ * @brief The sorted draws and batches of one pass. The version changes whenever the draws
+ * of the pass change, so recorded commands can be reused until then.
+ */
+typedef struct
+{
+    uint32_t first_draw;
+    uint32_t draw_count;
+    uint32_t first_batch;
+    uint32_t batch_count;
+    uint64_t version;
+} PassDraws;
+
+/**
+ * @brief Secondary command buffer with the draws of one pass, executed every frame until
+ * the draws of the pass or the state they were recorded with change
+ */
+typedef struct
+{
+    VkCommandBuffer command_buffer;
+    // Hash of everything the commands depend on, 0 when nothing is recorded
+    uint64_t hash;
+    // Counts of the recording, added to the stats of every frame that executes it
+    DrawStats stats;
+} PassCache;
+
+/**
+ * @brief Everything the render thread draws a frame from, published by the game thread with
+ * vur_publish_snapshot. The render thread only reads it, so it is never locked.
+ */
+typedef struct
+{
+    mat4 view;
+    mat4 projection;
+    // Applied with vur_set_shader_features
+    ShaderFeatureFlags features;
+
+    // Owned by the snapshot, allocate with vur_snapshot_alloc_draws
+    uint32_t draw_count;
+    uint32_t draw_capacity;
+    DrawCommand* draws;
+} SceneSnapshot;
+
+/**
+ * @brief Records the compute work of a frame. Compute runs on the compute queue, which may
+ * be a different family than graphics: resources both queues use must be created with
+ * VK_SHARING_MODE_CONCURRENT or transferred with queue family ownership barriers.
+ *
+ * @param[in] command_buffer Begun command buffer, ended and submitted by the renderer
+ * @param[in] frame_index The frame in flight, to index per frame resources
+ * @param[in] user_data The pointer given with vur_set_compute_callback
+ */
+typedef void (*ComputeCallback)(VkCommandBuffer command_buffer,
+                                uint32_t frame_index,
+                                void* user_data);
+
+/**
+ * @brief Resources that are in flight for one of the FRAME_LAG frames. They can be
+ * reused once the fence of the frame has been waited on.
+ */
+typedef struct
+{
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffer;
+
+    // Compute work submitted before the graphics work of the frame
+    VkCommandPool compute_command_pool;
+    VkCommandBuffer compute_command_buffer;
+
+    // Draw data for programs whose push constants exceed the device limit
+    VkBuffer draw_buffer;
+    VkDeviceMemory draw_memory;
+    VkDeviceSize draw_buffer_size;
+    uint8_t* draw_data;
+
+    // Set of the draw buffer. Recorded passes keep using it across frames, so the chain is
+    // not reset every frame but only when the set is replaced, after the fence of the frame.
+    DescriptorAllocator set_allocator;
+    VkDescriptorSet draw_set;
+
+    // Sets of the frame when the layout cache uses descriptor buffers, one per draw
+    VkDeviceAddress draw_address;
+    DescriptorBuffer descriptors;
+
+    // Temporary CPU data of the frame, reset when the frame is recorded
+    Arena arena;
+
+    // Commands of every pass, reused while the pass does not change
+    VkCommandPool pass_command_pool;
+    PassCache passes[VUR_PASS_COUNT];
+} FrameResources;
+
 /**
  * @brief Context for the renderer
  *
@@ -53,9 +227,24 @@ typedef struct _VulkanContext
     VkExtent2D window_extent;
     const char* name;
 
+    // Workers shared by every subsystem, see vur_run_jobs
+    JobSystem jobs;
+
+    // Driver host allocations with VUR_USE_HOST_ALLOCATOR, see vut_host_allocator_get_stats
+    HostAllocator host_allocator;
+
+    // Temporary arrays of initialization and resizes, and the swapchain image resources.
+    // Reset when the swapchain is recreated.
+    Arena init_arena;
+
     VkInstance instance;
     VkPhysicalDevice gpu;
+    VkPhysicalDeviceProperties gpu_properties;
     VkDevice device;
+    DeviceFeatures features;
+
+    // Usage and budget per heap, refreshed every frame
+    MemoryBudget memory_budget;
     VkQueue graphics_queue;
     VkQueue present_queue;
     uint32_t graphics_queue_family_index;
@@ -63,15 +252,41 @@ typedef struct _VulkanContext
     VkSemaphore image_acquired_semaphores[FRAME_LAG];
     VkSemaphore draw_complete_semaphores[FRAME_LAG];
 
+    // Async compute, the compute queue is the graphics queue when the device has no other
+    VkQueue compute_queue;
+    uint32_t compute_queue_family_index;
+    bool async_compute;
+    VkSemaphore compute_complete_semaphores[FRAME_LAG];
+    ComputeCallback compute_callback;
+    void* compute_user_data;
+    VkPipelineStageFlags compute_wait_stages;
+
     VkFormat surface_format;
     VkColorSpaceKHR color_space;
 
     VkSurfaceKHR surface;
     VkSwapchainKHR swapchain;
+    VkExtent2D swapchain_extent;
+    // The images can be copied from, which vur_start_capture needs
+    bool swapchain_readable;
     uint32_t swapchain_image_count;
     SwapchainImageResources* swapchain_image_resources;
     VkPresentModeKHR present_mode;
     VkFence fences[FRAME_LAG];
+    FrameResources frames[FRAME_LAG];
+
+    // Objects replaced while running, destroyed once frames in flight are done with them
+    DeletionQueue deletion_queue;
+
+    // Copies to the CPU, recorded at the end of a frame and delivered FRAME_LAG frames later
+    Readback readback;
+
+    // Every presented image is read back and written to a file while capturing. The staging
+    // holds one swapchain image per frame, so a copy is recorded by the frame that acquired
+    // the image and never waits for a later one.
+    FrameCapture capture;
+    Readback capture_readback;
+    bool capturing;
 
     VkCommandPool command_pool;
     VkCommandPool present_command_pool;
@@ -86,11 +301,36 @@ typedef struct _VulkanContext
         VkImageView view;
     } depth;
 
+    // Pipeline layouts are owned by the layout cache
+    LayoutCache layout_cache;
+    PipelineBuilder pipeline_builder;
+    PipelineManager pipelines;
+    ShaderProgram program;
+    PipelineDesc pipeline_desc;
     VkPipelineLayout pipeline_layout;
-    VkPipeline pipeline;
 
     VkDescriptorSetLayout descriptor_layout;
-    VkDescriptorPool descriptor_pool;
+    BindlessTable bindless;
+
+    // Aligned size of the draw data set and offset of its binding in a descriptor buffer
+    VkDeviceSize draw_set_size;
+    VkDeviceSize draw_binding_offset;
+
+    // Draws recorded every frame, replaced with vur_set_draws
+    uint32_t draw_count;
+    uint32_t draw_capacity;
+    DrawCommand* draws;
+    VkDeviceSize draw_stride;
+    DrawStats draw_stats;
+
+    // The sorted draws split by pipeline state and pass, with the pipeline of every batch
+    uint32_t batch_count;
+    DrawBatch* draw_batches;
+    VkPipeline* batch_pipelines;
+    // Keys and order of the sort, twice the capacity for its scratch
+    uint64_t* draw_keys;
+    uint32_t* draw_order;
+    PassDraws pass_draws[VUR_PASS_COUNT];
 
     VkRenderPass render_pass;
 
@@ -99,7 +339,24 @@ typedef struct _VulkanContext
     mat4 model;
 
     bool should_quit;
-    bool framebuffer_resized;
+    atomic_bool framebuffer_resized;
+
+    // vur_draw runs on its own thread, drawing the latest SceneSnapshot
+    atomic_bool render_thread_running;
+    pthread_t render_thread;
+    atomic_bool render_thread_quit;
+    TripleBuffer snapshots;
+    // Framebuffer size polled by the window thread, width in the high half
+    atomic_ullong framebuffer_extent;
+
+    // With on demand rendering vur_draw only draws after something changed, see
+    // vur_set_on_demand. An idle render thread sleeps on the condition until woken.
+    bool on_demand;
+    double idle_timeout;
+    atomic_bool redraw;
+    pthread_mutex_t idle_mutex;
+    pthread_cond_t idle_condition;
+    bool render_thread_woken;
 
     uint32_t current_buffer;
     int frame_index;
@@ -125,13 +382,298 @@ void
 vur_update_window(VulkanContext* ctx);
 
 /**
- * @brief Draw new frame
+ * @brief Draw new frame. With on demand rendering nothing is drawn unless something
+ * changed since the last frame.
  *
  * @param[in] ctx VulkanContext handle
  */
 void
 vur_draw(VulkanContext* ctx);
 
+/**
+ * @brief Only draw when the image would change, for applications that are mostly static.
+ * vur_update_window then waits for events while nothing is dirty and vur_draw skips
+ * frames. New draws, shader features, camera snapshots, readbacks and window resizes or
+ * damage mark the frame dirty on their own. Anything else that changes the image, like
+ * new texture contents or compute work, needs vur_request_redraw. Set it before starting
+ * the render thread. With a render thread the render thread sleeps instead and
+ * vur_update_window keeps polling, so the window thread still publishes snapshots.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] enabled Draw on demand instead of every frame
+ * @param[in] idle_timeout Longest wait for events in seconds, so the application still
+ * gets to run its own timers. 0 or less waits until an event or redraw request arrives.
+ */
+void
+vur_set_on_demand(VulkanContext* ctx, bool enabled, double idle_timeout);
+
+/**
+ * @brief Mark the frame dirty so the next vur_draw draws with on demand rendering. Can be
+ * called from any thread and wakes vur_update_window and the render thread.
+ *
+ * @param[in] ctx VulkanContext handle
+ */
+void
+vur_request_redraw(VulkanContext* ctx);
+
+/**
+ * @brief Run vur_draw on a render thread until vur_stop_render_thread, so simulation and
+ * rendering run at their own rates and a fence wait no longer stalls the simulation. The
+ * calling thread keeps calling vur_update_window and publishes snapshots. Until the thread
+ * stops, other threads may only call the snapshot and window functions. The draws and
+ * shader features go through the snapshots. Reads, captures and the compute callback
+ * belong to the render thread: set them up before starting it or from its callbacks,
+ * debug builds assert this.
+ *
+ * @param[in] ctx VulkanContext handle
+ */
+void
+vur_start_render_thread(VulkanContext* ctx);
+
+/**
+ * @brief Finish the frame being drawn and join the render thread
+ *
+ * @param[in] ctx VulkanContext handle
+ */
+void
+vur_stop_render_thread(VulkanContext* ctx);
+
+/**
+ * @brief Get the snapshot to fill for the next publish. It holds an older frame, so write
+ * every field.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @return SceneSnapshot* The snapshot, owned by the calling thread until it is published
+ */
+SceneSnapshot*
+vur_begin_snapshot(VulkanContext* ctx);
+
+/**
+ * @brief Size the draws of a snapshot, the memory is reused by later snapshots
+ *
+ * @param[in] snapshot The snapshot
+ * @param[in] count Amount of draws
+ * @return DrawCommand* The draws to fill, NULL when they can not be allocated. The snapshot
+ * keeps its previous draws then.
+ */
+DrawCommand*
+vur_snapshot_alloc_draws(SceneSnapshot* snapshot, uint32_t count);
+
+/**
+ * @brief Hand the snapshot to the render thread, which draws it from its next frame on
+ *
+ * @param[in] ctx VulkanContext handle
+ */
+void
+vur_publish_snapshot(VulkanContext* ctx);
+
+/**
+ * @brief Replace the draw list. The draws are copied and recorded every frame until
+ * the list is replaced again. They are sorted by pass, pipeline, material, vertices and
+ * depth, so draws with the same state are recorded together and share their binds.
+ * The commands of a pass are recorded once and reused while its draws stay the same, so
+ * setting an unchanged list costs a comparison and no recording. On failure the old list
+ * is kept.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] count Amount of draws
+ * @param[in] draws The draws, their pass below VUR_PASS_COUNT
+ * @return true The list is replaced
+ */
+bool
+vur_set_draws(VulkanContext* ctx, uint32_t count, const DrawCommand draws[]);
+
+/**
+ * @brief Select the shader variant to draw with. A variant that is not compiled yet
+ * is built in the background while the default variant draws in its place. With a render
+ * thread, set SceneSnapshot.features instead.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] features VUR_FEATURE_* bits, with VUR_FEATURE_LIGHTS(count) for the lights
+ */
+void
+vur_set_shader_features(VulkanContext* ctx, ShaderFeatureFlags features);
+
+/**
+ * @brief Get the binds and draws recorded for the last frame, to see what sorting saves.
+ * Call it from the thread that draws.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @return DrawStats The counts
+ */
+DrawStats
+vur_get_draw_stats(const VulkanContext* ctx);
+
+/**
+ * @brief Get called every frame while a memory heap is close to its budget, so the
+ * application can evict or downsize streamable resources before the driver starts paging.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] threshold Fraction of the budget above which the callback runs, like 0.9
+ * @param[in] callback The callback, NULL to remove it
+ * @param[in] user_data Passed to the callback
+ */
+void
+vur_set_memory_pressure_callback(VulkanContext* ctx,
+                                 float threshold,
+                                 MemoryPressureCallback callback,
+                                 void* user_data);
+
+/**
+ * @brief Record compute work every frame. It is submitted to the compute queue before the
+ * graphics work of the frame, which waits on it at the given stages, so it overlaps with
+ * the rasterization of the previous frame. Only from the render thread while it runs.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] wait_stages Graphics stages that consume the results of the compute work, 0
+ * for the vertex and fragment shaders
+ * @param[in] callback The callback, NULL to stop submitting compute work
+ * @param[in] user_data Passed to the callback
+ */
+void
+vur_set_compute_callback(VulkanContext* ctx,
+                         VkPipelineStageFlags wait_stages,
+                         ComputeCallback callback,
+                         void* user_data);
+
+/**
+ * @brief Create a compute program that shares the layouts, pipeline cache and bindless
+ * table of the renderer. Record it from the compute callback and destroy it with
+ * vur_destroy_compute_program before the renderer. When the renderer uses descriptor
+ * buffers so does the program: its sets come from vur_compute_alloc_buffer_set and are bound
+ * with vur_compute_bind_buffers, together with bindless.descriptors at bindless.set_offset.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] code SPIR-V of the compute shader
+ * @param[in] size Size of the shader in bytes
+ * @param[out] program The created program
+ * @return VkResult
+ */
+VkResult
+vur_create_compute_program(VulkanContext* ctx,
+                           const uint32_t code[],
+                           size_t size,
+                           ComputeProgram* program);
+
+/**
+ * @brief Copy a buffer range to the CPU at the end of the next frame. The data arrives once
+ * that frame has finished on the GPU, vur_draw never waits for it. While a render thread
+ * runs, request reads from it, like from a readback or compute callback.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] buffer Buffer created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+ * @param[in] offset Start of the range
+ * @param[in] size Size of the range, at most VUR_READBACK_FRAME_SIZE
+ * @param[out] dst Memory of at least size bytes, must stay valid until the read is done
+ * @param[in] callback Called when the data is in dst, NULL to poll with vur_is_read_done
+ * @param[in] user_data Passed to the callback
+ * @return ReadbackTicket VUR_READBACK_INVALID_TICKET when the range is too large
+ */
+ReadbackTicket
+vur_read_buffer(VulkanContext* ctx,
+                VkBuffer buffer,
+                VkDeviceSize offset,
+                VkDeviceSize size,
+                void* dst,
+                ReadbackCallback callback,
+                void* user_data);
+
+/**
+ * @brief Copy a color or depth image to the CPU at the end of the next frame, see
+ * vur_read_buffer
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] image Image created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+ * @param[in] layout The layout of the image at the end of the frame
+ * @param[in] format Format of the image, depth formats copy their depth aspect
+ * @param[in] extent Size of the image
+ * @param[in] texel_size Bytes per texel of the copied aspect
+ * @param[out] dst Memory for the tightly packed texels
+ * @param[in] callback Called when the data is in dst, NULL to poll with vur_is_read_done
+ * @param[in] user_data Passed to the callback
+ * @return ReadbackTicket VUR_READBACK_INVALID_TICKET when the image is too large
+ */
+ReadbackTicket
+vur_read_image(VulkanContext* ctx,
+               VkImage image,
+               VkImageLayout layout,
+               VkFormat format,
+               VkExtent2D extent,
+               uint32_t texel_size,
+               void* dst,
+               ReadbackCallback callback,
+               void* user_data);
+
+/**
+ * @brief Check if a read has arrived in its destination
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] ticket The ticket returned by vur_read_buffer or vur_read_image
+ * @return true The data is in the destination
+ */
+bool
+vur_is_read_done(const VulkanContext* ctx, ReadbackTicket ticket);
+
+/**
+ * @brief Run jobs on the workers of the renderer, which also compile its pipelines. Split
+ * work like culling, command recording and asset decoding into jobs instead of starting
+ * threads, so every subsystem shares the cores.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] decls The jobs, must stay valid until the counter reaches zero
+ * @param[in] count Amount of jobs
+ * @param[in] counter Counter to wait on the jobs with
+ */
+void
+vur_run_jobs(VulkanContext* ctx, JobDecl decls[], uint32_t count, JobCounter* counter);
+
+/**
+ * @brief Run jobs once the jobs of a dependency are done, see vur_run_jobs
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] dependency Counter of the jobs to run after
+ * @param[in] decls The jobs, must stay valid until the counter reaches zero
+ * @param[in] count Amount of jobs
+ * @param[in] counter Counter to wait on the jobs with
+ */
+void
+vur_run_jobs_after(VulkanContext* ctx,
+                   JobCounter* dependency,
+                   JobDecl decls[],
+                   uint32_t count,
+                   JobCounter* counter);
+
+/**
+ * @brief Wait for the jobs of a counter, running jobs on the calling thread meanwhile
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] counter The counter
+ */
+void
+vur_wait_jobs(VulkanContext* ctx, JobCounter* counter);
+
+/**
+ * @brief Write every presented frame to a numbered image file until vur_stop_capture. The
+ * frames are read back without stalling and encoded on worker threads. When the workers
+ * fall behind, vur_draw waits for them, so every frame is written.
+ * Start and stop it before or after a render thread, not while one runs.
+ *
+ * @param[in] ctx VulkanContext handle
+ * @param[in] prefix Path and start of the file names, like "frames/capture_"
+ * @param[in] format File format
+ * @return true The capture has started
+ */
+bool
+vur_start_capture(VulkanContext* ctx, const char prefix[], CaptureFormat format);
+
+/**
+ * @brief Wait for the frames in flight, write them and stop capturing
+ *
+ * @param[in] ctx VulkanContext handle
+ */
+void
+vur_stop_capture(VulkanContext* ctx);
+
 // Destroy
 /**
  * @brief Destroy the renderer before closing app
@@ -0,0 +1,770 @@
+/**
+ * @file spirv_reflect.c
+ * @brief Minimal SPIR-V reflection to derive pipeline interfaces from shaders
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "spirv_reflect.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SPIRV_MAGIC 0x07230203u
+#define SPIRV_HEADER_WORDS 5
+
+// Opcodes, decorations and enums from the SPIR-V specification that we care about
+enum
+{
+    OP_ENTRY_POINT = 15,
+    OP_TYPE_BOOL = 20,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_MATRIX = 24,
+    OP_TYPE_IMAGE = 25,
+    OP_TYPE_SAMPLER = 26,
+    OP_TYPE_SAMPLED_IMAGE = 27,
+    OP_TYPE_ARRAY = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_CONSTANT = 43,
+    OP_SPEC_CONSTANT_TRUE = 48,
+    OP_SPEC_CONSTANT_FALSE = 49,
+    OP_SPEC_CONSTANT = 50,
+    OP_VARIABLE = 59,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+};
+
+enum
+{
+    DECORATION_SPEC_ID = 1,
+    DECORATION_BLOCK = 2,
+    DECORATION_BUFFER_BLOCK = 3,
+    DECORATION_ARRAY_STRIDE = 6,
+    DECORATION_MATRIX_STRIDE = 7,
+    DECORATION_BUILT_IN = 11,
+    DECORATION_LOCATION = 30,
+    DECORATION_BINDING = 33,
+    DECORATION_DESCRIPTOR_SET = 34,
+    DECORATION_OFFSET = 35,
+};
+
+enum
+{
+    STORAGE_UNIFORM_CONSTANT = 0,
+    STORAGE_INPUT = 1,
+    STORAGE_UNIFORM = 2,
+    STORAGE_PUSH_CONSTANT = 9,
+    STORAGE_STORAGE_BUFFER = 12,
+};
+
+enum
+{
+    DIM_BUFFER = 5,
+    DIM_SUBPASS_DATA = 6,
+};
+
+enum
+{
+    ID_HAS_SET = 1 << 0,
+    ID_HAS_BINDING = 1 << 1,
+    ID_HAS_LOCATION = 1 << 2,
+    ID_HAS_SPEC_ID = 1 << 3,
+    ID_BUILT_IN = 1 << 4,
+    ID_BLOCK = 1 << 5,
+    ID_BUFFER_BLOCK = 1 << 6,
+    ID_HAS_OFFSET = 1 << 7,
+};
+
+/**
+ * @brief What we remember about every result id in the module
+ */
+typedef struct
+{
+    uint32_t opcode;
+    uint32_t flags;
+
+    // Pointee, element, component or column type depending on the opcode
+    uint32_t type;
+    uint32_t storage_class;
+    // Component count, column count, array length id or constant value
+    uint32_t count;
+    // Bit width for scalars, signedness for integers is stored in sampled
+    uint32_t width;
+    uint32_t sampled;
+    uint32_t dim;
+
+    uint32_t set;
+    uint32_t binding;
+    uint32_t location;
+    uint32_t spec_id;
+    uint32_t array_stride;
+
+    // Structs: the member with the highest offset, used to compute the block size, and the
+    // lowest offset where a push constant range starts
+    const uint32_t* members;
+    uint32_t member_count;
+    uint32_t first_offset;
+    uint32_t last_member;
+    uint32_t last_offset;
+    uint32_t last_matrix_stride;
+} SpirvId;
+
+static VkShaderStageFlagBits
+execution_model_to_stage(uint32_t model)
+{
+    switch (model) {
+    case 0:
+        return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1:
+        return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2:
+        return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3:
+        return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4:
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+        return 0;
+    }
+}
+
+static uint32_t
+type_size(const SpirvId* ids, uint32_t bound, uint32_t type_id, uint32_t matrix_stride)
+{
+    if (type_id >= bound) {
+        return 0;
+    }
+
+    const SpirvId* type = &ids[type_id];
+    switch (type->opcode) {
+    case OP_TYPE_BOOL:
+        return 4;
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+        return type->width / 8;
+    case OP_TYPE_VECTOR:
+        return type->count * type_size(ids, bound, type->type, 0);
+    case OP_TYPE_MATRIX:
+        if (matrix_stride) {
+            return type->count * matrix_stride;
+        }
+        return type->count * type_size(ids, bound, type->type, 0);
+    case OP_TYPE_ARRAY: {
+        uint32_t length = type->count < bound ? ids[type->count].count : 0;
+        uint32_t stride = type->array_stride;
+        if (stride == 0) {
+            stride = type_size(ids, bound, type->type, matrix_stride);
+        }
+        return length * stride;
+    }
+    case OP_TYPE_STRUCT:
+        if (type->member_count == 0) {
+            return 0;
+        }
+        return type->last_offset + type_size(ids, bound, type->members[type->last_member],
+                                             type->last_matrix_stride);
+    default:
+        // Runtime arrays and opaque types have no size
+        return 0;
+    }
+}
+
+static VkFormat
+input_format(const SpirvId* ids, uint32_t bound, uint32_t type_id)
+{
+    uint32_t components = 1;
+    const SpirvId* scalar = &ids[type_id];
+    if (scalar->opcode == OP_TYPE_VECTOR) {
+        components = scalar->count;
+        scalar = scalar->type < bound ? &ids[scalar->type] : NULL;
+    }
+
+    if (scalar == NULL || scalar->width != 32 || components < 1 || components > 4) {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    static const VkFormat float_formats[4] = {
+        VK_FORMAT_R32_SFLOAT,
+        VK_FORMAT_R32G32_SFLOAT,
+        VK_FORMAT_R32G32B32_SFLOAT,
+        VK_FORMAT_R32G32B32A32_SFLOAT,
+    };
+    static const VkFormat sint_formats[4] = {
+        VK_FORMAT_R32_SINT,
+        VK_FORMAT_R32G32_SINT,
+        VK_FORMAT_R32G32B32_SINT,
+        VK_FORMAT_R32G32B32A32_SINT,
+    };
+    static const VkFormat uint_formats[4] = {
+        VK_FORMAT_R32_UINT,
+        VK_FORMAT_R32G32_UINT,
+        VK_FORMAT_R32G32B32_UINT,
+        VK_FORMAT_R32G32B32A32_UINT,
+    };
+
+    if (scalar->opcode == OP_TYPE_FLOAT) {
+        return float_formats[components - 1];
+    } else if (scalar->opcode == OP_TYPE_INT) {
+        return scalar->sampled ? sint_formats[components - 1] : uint_formats[components - 1];
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+static VkResult
+add_binding(ShaderReflection* reflection,
+            uint32_t set,
+            const VkDescriptorSetLayoutBinding* binding,
+            bool unsized)
+{
+    if (set >= VUT_MAX_DESCRIPTOR_SETS) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    ReflectedSet* reflected = &reflection->sets[set];
+    for (uint32_t i = 0; i < reflected->binding_count; i++) {
+        VkDescriptorSetLayoutBinding* existing = &reflected->bindings[i];
+        if (existing->binding == binding->binding) {
+            if (existing->descriptorType != binding->descriptorType ||
+                existing->descriptorCount != binding->descriptorCount) {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            existing->stageFlags |= binding->stageFlags;
+            return VK_SUCCESS;
+        }
+    }
+
+    if (reflected->binding_count == VUT_MAX_SET_BINDINGS) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // Keep the bindings sorted so equal sets hash the same
+    uint32_t i = reflected->binding_count++;
+    while (i > 0 && reflected->bindings[i - 1].binding > binding->binding) {
+        reflected->bindings[i] = reflected->bindings[i - 1];
+        i--;
+    }
+    reflected->bindings[i] = *binding;
+    reflected->unsized |= unsized;
+
+    if (set + 1 > reflection->set_count) {
+        reflection->set_count = set + 1;
+    }
+
+    return VK_SUCCESS;
+}
+
+static VkResult
+add_push_constant_range(ShaderReflection* reflection, const VkPushConstantRange* range)
+{
+    if (reflection->push_constant_range_count == 0) {
+        reflection->push_constant_range = *range;
+        reflection->push_constant_range_count = 1;
+        return VK_SUCCESS;
+    }
+
+    // A single range visible to all stages is always a valid layout
+    VkPushConstantRange* merged = &reflection->push_constant_range;
+    uint32_t end = merged->offset + merged->size;
+    if (range->offset + range->size > end) {
+        end = range->offset + range->size;
+    }
+    if (range->offset < merged->offset) {
+        merged->offset = range->offset;
+    }
+    merged->size = end - merged->offset;
+    merged->stageFlags |= range->stageFlags;
+
+    return VK_SUCCESS;
+}
+
+static VkResult
+reflect_variable(ShaderReflection* reflection,
+                 const SpirvId* ids,
+                 uint32_t bound,
+                 const SpirvId* variable,
+                 VkShaderStageFlagBits stage)
+{
+    const SpirvId* pointer = variable->type < bound ? &ids[variable->type] : NULL;
+    if (pointer == NULL || pointer->opcode != OP_TYPE_POINTER || pointer->type >= bound) {
+        return VK_SUCCESS;
+    }
+
+    uint32_t type_id = pointer->type;
+
+    if (variable->storage_class == STORAGE_PUSH_CONSTANT) {
+        const SpirvId* block = &ids[type_id];
+        if (block->opcode != OP_TYPE_STRUCT || block->member_count == 0) {
+            return VK_SUCCESS;
+        }
+
+        // Blocks with an explicit offset start past 0, like the second stage of a split range
+        uint32_t end = type_size(ids, bound, type_id, 0);
+        const VkPushConstantRange range = {
+            .stageFlags = stage,
+            .offset = block->first_offset,
+            .size = (end - block->first_offset + 3) & ~3u,
+        };
+        return add_push_constant_range(reflection, &range);
+    }
+
+    if (variable->storage_class == STORAGE_INPUT) {
+        if (stage != VK_SHADER_STAGE_VERTEX_BIT || (variable->flags & ID_BUILT_IN) ||
+            !(variable->flags & ID_HAS_LOCATION)) {
+            return VK_SUCCESS;
+        }
+
+        if (reflection->vertex_attribute_count == VUT_MAX_VERTEX_INPUTS) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        reflection->vertex_attributes[reflection->vertex_attribute_count++] =
+            (VkVertexInputAttributeDescription){
+                .location = variable->location,
+                .binding = 0,
+                .format = input_format(ids, bound, type_id),
+                // Stored in the size until the offsets are assigned
+                .offset = type_size(ids, bound, type_id, 0),
+            };
+        return VK_SUCCESS;
+    }
+
+    if (variable->storage_class != STORAGE_UNIFORM_CONSTANT &&
+        variable->storage_class != STORAGE_UNIFORM &&
+        variable->storage_class != STORAGE_STORAGE_BUFFER) {
+        return VK_SUCCESS;
+    }
+
+    // Unwrap arrays of descriptors
+    uint32_t count = 1;
+    bool unsized = false;
+    if (ids[type_id].opcode == OP_TYPE_ARRAY) {
+        uint32_t length = ids[type_id].count;
+        count = length < bound ? ids[length].count : 1;
+        type_id = ids[type_id].type;
+    } else if (ids[type_id].opcode == OP_TYPE_RUNTIME_ARRAY) {
+        // Only valid in the bindless set, which replaces it with the counts of the table
+        count = 0;
+        unsized = true;
+        type_id = ids[type_id].type;
+    }
+
+    if (type_id >= bound) {
+        return VK_SUCCESS;
+    }
+
+    const SpirvId* type = &ids[type_id];
+    VkDescriptorType descriptor_type;
+    switch (type->opcode) {
+    case OP_TYPE_SAMPLER:
+        descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        break;
+    case OP_TYPE_SAMPLED_IMAGE:
+        descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        break;
+    case OP_TYPE_IMAGE:
+        if (type->dim == DIM_SUBPASS_DATA) {
+            descriptor_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        } else if (type->dim == DIM_BUFFER) {
+            descriptor_type = type->sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                                                 : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        } else {
+            descriptor_type = type->sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                                 : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        break;
+    case OP_TYPE_STRUCT:
+        if (variable->storage_class == STORAGE_STORAGE_BUFFER ||
+            (type->flags & ID_BUFFER_BLOCK)) {
+            descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        } else {
+            descriptor_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        break;
+    default:
+        // Acceleration structures and other types are not supported yet
+        return VK_SUCCESS;
+    }
+
+    const VkDescriptorSetLayoutBinding binding = {
+        .binding = variable->binding,
+        .descriptorType = descriptor_type,
+        .descriptorCount = count,
+        .stageFlags = stage,
+        .pImmutableSamplers = NULL,
+    };
+
+    return add_binding(reflection, variable->set, &binding, unsized);
+}
+
+static void
+assign_vertex_offsets(ShaderReflection* reflection)
+{
+    // Sort on location and pack the attributes interleaved in binding 0
+    VkVertexInputAttributeDescription* attributes = reflection->vertex_attributes;
+    for (uint32_t i = 1; i < reflection->vertex_attribute_count; i++) {
+        VkVertexInputAttributeDescription attribute = attributes[i];
+        uint32_t j = i;
+        while (j > 0 && attributes[j - 1].location > attribute.location) {
+            attributes[j] = attributes[j - 1];
+            j--;
+        }
+        attributes[j] = attribute;
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < reflection->vertex_attribute_count; i++) {
+        uint32_t size = attributes[i].offset;
+        attributes[i].offset = offset;
+        offset += size;
+    }
+
+    reflection->vertex_stride = offset;
+}
+
+// Word of the id an instruction defines or decorates, 0 if it has none, and the words it
+// needs to be read. Returns false for instructions that are not reflected.
+static bool
+instruction_layout(uint32_t opcode, uint32_t* id_word, uint32_t* min_length)
+{
+    switch (opcode) {
+    case OP_ENTRY_POINT:
+        // The execution model is a literal, there is no id to check
+        *id_word = 0;
+        *min_length = 2;
+        return true;
+    case OP_DECORATE:
+        *id_word = 1;
+        *min_length = 3;
+        return true;
+    case OP_TYPE_INT:
+    case OP_TYPE_VECTOR:
+    case OP_TYPE_MATRIX:
+    case OP_TYPE_ARRAY:
+    case OP_TYPE_POINTER:
+        *id_word = 1;
+        *min_length = 4;
+        return true;
+    case OP_MEMBER_DECORATE:
+        *id_word = 1;
+        *min_length = 5;
+        return true;
+    case OP_TYPE_BOOL:
+    case OP_TYPE_SAMPLER:
+    case OP_TYPE_STRUCT:
+        *id_word = 1;
+        *min_length = 2;
+        return true;
+    case OP_TYPE_FLOAT:
+    case OP_TYPE_RUNTIME_ARRAY:
+    case OP_TYPE_SAMPLED_IMAGE:
+        *id_word = 1;
+        *min_length = 3;
+        return true;
+    case OP_TYPE_IMAGE:
+        *id_word = 1;
+        *min_length = 8;
+        return true;
+    case OP_CONSTANT:
+    case OP_SPEC_CONSTANT:
+    case OP_VARIABLE:
+        *id_word = 2;
+        *min_length = 4;
+        return true;
+    case OP_SPEC_CONSTANT_TRUE:
+    case OP_SPEC_CONSTANT_FALSE:
+        *id_word = 2;
+        *min_length = 3;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The last member of a struct is only known once all its offsets are, and the MatrixStride
+// of a member may come before them
+static void
+assign_matrix_strides(const uint32_t code[], size_t word_count, SpirvId* ids, uint32_t bound)
+{
+    size_t offset = SPIRV_HEADER_WORDS;
+    while (offset < word_count) {
+        const uint32_t* instruction = &code[offset];
+        uint32_t length = instruction[0] >> 16;
+
+        if ((instruction[0] & 0xFFFF) == OP_MEMBER_DECORATE && length >= 5 &&
+            instruction[1] < bound && instruction[3] == DECORATION_MATRIX_STRIDE) {
+            SpirvId* block = &ids[instruction[1]];
+            if ((block->flags & ID_HAS_OFFSET) && instruction[2] == block->last_member) {
+                block->last_matrix_stride = instruction[4];
+            }
+        }
+
+        offset += length;
+    }
+}
+
+VkResult
+vut_reflect_shader(const uint32_t code[], size_t size, ShaderReflection* reflection)
+{
+    memset(reflection, 0, sizeof(*reflection));
+
+    size_t word_count = size / sizeof(uint32_t);
+    if (word_count < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    uint32_t bound = code[3];
+    SpirvId* ids = calloc(bound, sizeof(SpirvId));
+    if (ids == NULL) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkShaderStageFlagBits stage = 0;
+
+    // First pass: collect types, decorations and variables
+    size_t offset = SPIRV_HEADER_WORDS;
+    while (offset < word_count) {
+        const uint32_t* instruction = &code[offset];
+        uint32_t opcode = instruction[0] & 0xFFFF;
+        uint32_t length = instruction[0] >> 16;
+
+        if (length == 0 || offset + length > word_count) {
+            free(ids);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        // Only the id that is written to is checked here, the other words can be literals.
+        // Type ids in the operands are checked where they are looked up.
+        uint32_t id_word = 0;
+        uint32_t min_length = 0;
+        if (!instruction_layout(opcode, &id_word, &min_length) || length < min_length ||
+            (id_word != 0 && instruction[id_word] >= bound)) {
+            offset += length;
+            continue;
+        }
+
+        uint32_t target = instruction[1];
+        uint32_t result_id = id_word == 2 ? instruction[2] : 0;
+
+        switch (opcode) {
+        case OP_ENTRY_POINT:
+            if (stage == 0) {
+                stage = execution_model_to_stage(instruction[1]);
+            }
+            break;
+        case OP_DECORATE:
+            // Only Block and BufferBlock have no literal operand
+            if (length < 3 || (length < 4 && instruction[2] != DECORATION_BLOCK &&
+                               instruction[2] != DECORATION_BUFFER_BLOCK)) {
+                break;
+            }
+            switch (instruction[2]) {
+            case DECORATION_SPEC_ID:
+                ids[target].spec_id = instruction[3];
+                ids[target].flags |= ID_HAS_SPEC_ID;
+                break;
+            case DECORATION_BLOCK:
+                ids[target].flags |= ID_BLOCK;
+                break;
+            case DECORATION_BUFFER_BLOCK:
+                ids[target].flags |= ID_BUFFER_BLOCK;
+                break;
+            case DECORATION_ARRAY_STRIDE:
+                ids[target].array_stride = instruction[3];
+                break;
+            case DECORATION_BUILT_IN:
+                ids[target].flags |= ID_BUILT_IN;
+                break;
+            case DECORATION_LOCATION:
+                ids[target].location = instruction[3];
+                ids[target].flags |= ID_HAS_LOCATION;
+                break;
+            case DECORATION_BINDING:
+                ids[target].binding = instruction[3];
+                ids[target].flags |= ID_HAS_BINDING;
+                break;
+            case DECORATION_DESCRIPTOR_SET:
+                ids[target].set = instruction[3];
+                ids[target].flags |= ID_HAS_SET;
+                break;
+            }
+            break;
+        case OP_MEMBER_DECORATE:
+            if (length < 5) {
+                break;
+            }
+            if (instruction[3] == DECORATION_BUILT_IN) {
+                ids[target].flags |= ID_BUILT_IN;
+            } else if (instruction[3] == DECORATION_OFFSET) {
+                SpirvId* block = &ids[target];
+                if (!(block->flags & ID_HAS_OFFSET) || instruction[4] < block->first_offset) {
+                    block->first_offset = instruction[4];
+                }
+                if (!(block->flags & ID_HAS_OFFSET) || instruction[4] >= block->last_offset) {
+                    block->last_member = instruction[2];
+                    block->last_offset = instruction[4];
+                }
+                block->flags |= ID_HAS_OFFSET;
+            }
+            break;
+        case OP_TYPE_BOOL:
+        case OP_TYPE_SAMPLER:
+            ids[target].opcode = opcode;
+            break;
+        case OP_TYPE_INT:
+            ids[target].opcode = opcode;
+            ids[target].width = instruction[2];
+            ids[target].sampled = instruction[3];
+            break;
+        case OP_TYPE_FLOAT:
+            ids[target].opcode = opcode;
+            ids[target].width = instruction[2];
+            break;
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_ARRAY:
+            ids[target].opcode = opcode;
+            ids[target].type = instruction[2];
+            ids[target].count = instruction[3];
+            break;
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_SAMPLED_IMAGE:
+            ids[target].opcode = opcode;
+            ids[target].type = instruction[2];
+            break;
+        case OP_TYPE_IMAGE:
+            ids[target].opcode = opcode;
+            ids[target].type = instruction[2];
+            ids[target].dim = instruction[3];
+            ids[target].sampled = instruction[7];
+            break;
+        case OP_TYPE_STRUCT:
+            ids[target].opcode = opcode;
+            ids[target].members = &instruction[2];
+            ids[target].member_count = length - 2;
+            break;
+        case OP_TYPE_POINTER:
+            ids[target].opcode = opcode;
+            ids[target].storage_class = instruction[2];
+            ids[target].type = instruction[3];
+            break;
+        case OP_CONSTANT:
+        case OP_SPEC_CONSTANT:
+        case OP_SPEC_CONSTANT_TRUE:
+        case OP_SPEC_CONSTANT_FALSE:
+        case OP_VARIABLE:
+            ids[result_id].opcode = opcode;
+            ids[result_id].type = target;
+            if (opcode == OP_VARIABLE) {
+                ids[result_id].storage_class = instruction[3];
+            } else if (opcode == OP_CONSTANT || opcode == OP_SPEC_CONSTANT) {
+                ids[result_id].count = instruction[3];
+            } else {
+                ids[result_id].count = opcode == OP_SPEC_CONSTANT_TRUE;
+            }
+            break;
+        }
+
+        offset += length;
+    }
+
+    reflection->stages = stage;
+    assign_matrix_strides(code, word_count, ids, bound);
+
+    // Second pass over the ids now that all decorations are known
+    VkResult result = VK_SUCCESS;
+    for (uint32_t id = 0; id < bound && result == VK_SUCCESS; id++) {
+        const SpirvId* info = &ids[id];
+
+        if (info->opcode == OP_VARIABLE) {
+            result = reflect_variable(reflection, ids, bound, info, stage);
+        } else if ((info->flags & ID_HAS_SPEC_ID) &&
+                   (info->opcode == OP_SPEC_CONSTANT || info->opcode == OP_SPEC_CONSTANT_TRUE ||
+                    info->opcode == OP_SPEC_CONSTANT_FALSE)) {
+            if (reflection->spec_constant_count == VUT_MAX_SPEC_CONSTANTS) {
+                result = VK_ERROR_INITIALIZATION_FAILED;
+                break;
+            }
+
+            uint32_t constant_size = type_size(ids, bound, info->type, 0);
+            reflection->spec_constants[reflection->spec_constant_count++] =
+                (VkSpecializationMapEntry){
+                    .constantID = info->spec_id,
+                    .offset = reflection->spec_data_size,
+                    .size = constant_size,
+                };
+            reflection->spec_data_size += constant_size;
+        }
+    }
+
+    assign_vertex_offsets(reflection);
+
+    free(ids);
+    return result;
+}
+
+VkResult
+vut_reflect_merge(ShaderReflection* reflection, const ShaderReflection* other)
+{
+    reflection->stages |= other->stages;
+
+    for (uint32_t set = 0; set < other->set_count; set++) {
+        const ReflectedSet* reflected = &other->sets[set];
+        for (uint32_t i = 0; i < reflected->binding_count; i++) {
+            VkResult result =
+                add_binding(reflection, set, &reflected->bindings[i], reflected->unsized);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+        }
+    }
+
+    if (other->push_constant_range_count) {
+        add_push_constant_range(reflection, &other->push_constant_range);
+    }
+
+    // Only the vertex stage has vertex inputs
+    if (reflection->vertex_attribute_count == 0) {
+        reflection->vertex_attribute_count = other->vertex_attribute_count;
+        memcpy(reflection->vertex_attributes, other->vertex_attributes,
+               sizeof(other->vertex_attributes));
+        reflection->vertex_stride = other->vertex_stride;
+    }
+
+    // Specialization constants with the same id are shared between stages
+    for (uint32_t i = 0; i < other->spec_constant_count; i++) {
+        const VkSpecializationMapEntry* entry = &other->spec_constants[i];
+
+        bool found = false;
+        for (uint32_t j = 0; j < reflection->spec_constant_count; j++) {
+            if (reflection->spec_constants[j].constantID == entry->constantID) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            if (reflection->spec_constant_count == VUT_MAX_SPEC_CONSTANTS) {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            reflection->spec_constants[reflection->spec_constant_count++] =
+                (VkSpecializationMapEntry){
+                    .constantID = entry->constantID,
+                    .offset = reflection->spec_data_size,
+                    .size = entry->size,
+                };
+            reflection->spec_data_size += entry->size;
+        }
+    }
+
+    return VK_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file spirv_reflect.h
+ * @brief Minimal SPIR-V reflection to derive pipeline interfaces from shaders
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef SPIRV_REFLECT_H
+#define SPIRV_REFLECT_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define VUT_MAX_DESCRIPTOR_SETS 4
+#define VUT_MAX_SET_BINDINGS 16
+#define VUT_MAX_VERTEX_INPUTS 16
+#define VUT_MAX_SPEC_CONSTANTS 16
+
+/**
+ * @brief The bindings of one descriptor set used by a shader
+ */
+typedef struct
+{
+    uint32_t binding_count;
+    VkDescriptorSetLayoutBinding bindings[VUT_MAX_SET_BINDINGS];
+    // Set when a binding is a runtime array. Its descriptorCount is 0 until the set is
+    // replaced by the bindless set, the layout cache rejects it otherwise.
+    bool unsized;
+} ReflectedSet;
+
+/**
+ * @brief Everything the pipeline needs to know about the interface of one or more shaders
+ */
+typedef struct
+{
+    VkShaderStageFlags stages;
+
+    // Highest used set index + 1. Sets in between may be empty
+    uint32_t set_count;
+    ReflectedSet sets[VUT_MAX_DESCRIPTOR_SETS];
+
+    // All push constant blocks are merged into a single range
+    uint32_t push_constant_range_count;
+    VkPushConstantRange push_constant_range;
+
+    // Vertex shader inputs, packed in location order in binding 0
+    uint32_t vertex_attribute_count;
+    VkVertexInputAttributeDescription vertex_attributes[VUT_MAX_VERTEX_INPUTS];
+    uint32_t vertex_stride;
+
+    // Specialization constants, offsets are tightly packed in the order they were found
+    uint32_t spec_constant_count;
+    VkSpecializationMapEntry spec_constants[VUT_MAX_SPEC_CONSTANTS];
+    uint32_t spec_data_size;
+} ShaderReflection;
+
+/**
+ * @brief Extract descriptor bindings, push constants, vertex inputs and specialization
+ * constants from a SPIR-V module
+ *
+ * @param[in] code The SPIR-V words
+ * @param[in] size The size of the code in bytes
+ * @param[out] reflection The interface of the shader
+ * @return VkResult VK_ERROR_INITIALIZATION_FAILED if the code is not valid SPIR-V or
+ * exceeds the reflection limits
+ */
+VkResult
+vut_reflect_shader(const uint32_t code[], size_t size, ShaderReflection* reflection);
+
+/**
+ * @brief Merge the interface of another stage into a reflection.
+ * Bindings used by both stages get the stage flags of both.
+ *
+ * @param[in, out] reflection The reflection to merge into
+ * @param[in] other The reflection of the other stage
+ * @return VkResult VK_ERROR_INITIALIZATION_FAILED if the stages disagree on a binding
+ */
+VkResult
+vut_reflect_merge(ShaderReflection* reflection, const ShaderReflection* other);
+
+#endif // SPIRV_REFLECT_H
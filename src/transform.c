@@ -0,0 +1,414 @@
+/**
+ * @file transform.c
+ * @brief Transform hierarchy stored as structure of arrays, with vectorized propagation of
+ * the world matrices
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "transform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The kernel needs AVX2 for the gathers and FMA, build with VUR_USE_AVX2
+#if defined(__AVX2__) && defined(__FMA__)
+#define TRANSFORM_SIMD
+#include <immintrin.h>
+#endif
+
+// Nodes computed together by the vector kernel
+#define TRANSFORM_LANES 8
+
+// Arrays \\\
+
+typedef struct
+{
+    void** array;
+    size_t element_size;
+} TransformArray;
+
+// Every array with one element per node, to grow and permute them alike
+static uint32_t
+transform_arrays(TransformHierarchy* hierarchy, TransformArray arrays[16])
+{
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < 3; c++) {
+        arrays[count++] = (TransformArray){ (void**)&hierarchy->position[c], sizeof(float) };
+        arrays[count++] = (TransformArray){ (void**)&hierarchy->scale[c], sizeof(float) };
+    }
+    for (uint32_t c = 0; c < 4; c++) {
+        arrays[count++] = (TransformArray){ (void**)&hierarchy->rotation[c], sizeof(float) };
+    }
+    arrays[count++] = (TransformArray){ (void**)&hierarchy->parent, sizeof(int32_t) };
+    arrays[count++] = (TransformArray){ (void**)&hierarchy->depth, sizeof(uint32_t) };
+    arrays[count++] = (TransformArray){ (void**)&hierarchy->dirty, sizeof(uint8_t) };
+    arrays[count++] = (TransformArray){ (void**)&hierarchy->world_dirty, sizeof(uint8_t) };
+    arrays[count++] = (TransformArray){ (void**)&hierarchy->index_handle, sizeof(uint32_t) };
+    arrays[count++] = (TransformArray){ (void**)&hierarchy->world, sizeof(TransformMatrix) };
+    return count;
+}
+
+static void*
+transform_realloc(void* array, size_t size)
+{
+    void* result = realloc(array, size);
+    if (result == NULL) {
+        fprintf(stderr, "Failed to allocate %zu bytes for the transform hierarchy\n", size);
+        abort();
+    }
+    return result;
+}
+
+static void
+transform_grow(TransformHierarchy* hierarchy, uint32_t capacity)
+{
+    TransformArray arrays[16];
+    uint32_t array_count = transform_arrays(hierarchy, arrays);
+    for (uint32_t a = 0; a < array_count; a++) {
+        *arrays[a].array = transform_realloc(*arrays[a].array, capacity * arrays[a].element_size);
+    }
+    hierarchy->handle_index =
+        transform_realloc(hierarchy->handle_index, capacity * sizeof(uint32_t));
+    hierarchy->level_start =
+        transform_realloc(hierarchy->level_start, (capacity + 1) * sizeof(uint32_t));
+    hierarchy->capacity = capacity;
+}
+
+// Sorts the nodes by depth, keeping the order within a depth
+static void
+transform_sort(TransformHierarchy* hierarchy)
+{
+    uint32_t count = hierarchy->count;
+
+    // Counting sort, the depths are at most the node count
+    uint32_t max_depth = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        max_depth = hierarchy->depth[i] > max_depth ? hierarchy->depth[i] : max_depth;
+    }
+    uint32_t* offsets = transform_realloc(NULL, (max_depth + 2) * sizeof(uint32_t));
+    memset(offsets, 0, (max_depth + 2) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        offsets[hierarchy->depth[i] + 1]++;
+    }
+    for (uint32_t d = 0; d <= max_depth; d++) {
+        offsets[d + 1] += offsets[d];
+    }
+
+    uint32_t* new_index = transform_realloc(NULL, count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        new_index[i] = offsets[hierarchy->depth[i]]++;
+    }
+    free(offsets);
+
+    // Parents point to the new indices before they move
+    for (uint32_t i = 0; i < count; i++) {
+        if (hierarchy->parent[i] >= 0) {
+            hierarchy->parent[i] = (int32_t)new_index[hierarchy->parent[i]];
+        }
+    }
+
+    uint8_t* scratch = transform_realloc(NULL, count * sizeof(TransformMatrix));
+    TransformArray arrays[16];
+    uint32_t array_count = transform_arrays(hierarchy, arrays);
+    for (uint32_t a = 0; a < array_count; a++) {
+        uint8_t* array = *arrays[a].array;
+        size_t size = arrays[a].element_size;
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(scratch + new_index[i] * size, array + i * size, size);
+        }
+        memcpy(array, scratch, count * size);
+    }
+    free(scratch);
+    free(new_index);
+
+    for (uint32_t i = 0; i < count; i++) {
+        hierarchy->handle_index[hierarchy->index_handle[i]] = i;
+    }
+
+    hierarchy->unsorted = false;
+}
+
+static void
+transform_find_levels(TransformHierarchy* hierarchy)
+{
+    hierarchy->level_count = 0;
+    for (uint32_t i = 0; i < hierarchy->count; i++) {
+        if (i == 0 || hierarchy->depth[i] != hierarchy->depth[i - 1]) {
+            hierarchy->level_start[hierarchy->level_count++] = i;
+        }
+    }
+    hierarchy->level_start[hierarchy->level_count] = hierarchy->count;
+}
+
+// Kernels \\\
+
+// Rows of the local matrix of node i
+static void
+transform_local(const TransformHierarchy* hierarchy, uint32_t i, float local[12])
+{
+    float x = hierarchy->rotation[0][i], y = hierarchy->rotation[1][i];
+    float z = hierarchy->rotation[2][i], w = hierarchy->rotation[3][i];
+    float sx = hierarchy->scale[0][i], sy = hierarchy->scale[1][i], sz = hierarchy->scale[2][i];
+
+    local[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+    local[1] = 2.0f * (x * y - z * w) * sy;
+    local[2] = 2.0f * (x * z + y * w) * sz;
+    local[3] = hierarchy->position[0][i];
+    local[4] = 2.0f * (x * y + z * w) * sx;
+    local[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+    local[6] = 2.0f * (y * z - x * w) * sz;
+    local[7] = hierarchy->position[1][i];
+    local[8] = 2.0f * (x * z - y * w) * sx;
+    local[9] = 2.0f * (y * z + x * w) * sy;
+    local[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+    local[11] = hierarchy->position[2][i];
+}
+
+static void
+transform_update_node(TransformHierarchy* hierarchy, uint32_t i)
+{
+    float local[12];
+    transform_local(hierarchy, i, local);
+
+    float* world = &hierarchy->world[i].rows[0][0];
+    if (hierarchy->parent[i] < 0) {
+        memcpy(world, local, sizeof(local));
+        return;
+    }
+
+    const float* parent = &hierarchy->world[hierarchy->parent[i]].rows[0][0];
+    for (uint32_t r = 0; r < 3; r++) {
+        const float* p = parent + r * 4;
+        for (uint32_t c = 0; c < 4; c++) {
+            world[r * 4 + c] = p[0] * local[c] + p[1] * local[4 + c] + p[2] * local[8 + c];
+        }
+        world[r * 4 + 3] += p[3];
+    }
+}
+
+#ifdef TRANSFORM_SIMD
+// Eight nodes of the same depth starting at i, so none is the parent of another
+static void
+transform_update_lanes(TransformHierarchy* hierarchy, uint32_t i, bool roots)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+
+    __m256 x = _mm256_loadu_ps(hierarchy->rotation[0] + i);
+    __m256 y = _mm256_loadu_ps(hierarchy->rotation[1] + i);
+    __m256 z = _mm256_loadu_ps(hierarchy->rotation[2] + i);
+    __m256 w = _mm256_loadu_ps(hierarchy->rotation[3] + i);
+    __m256 sx = _mm256_loadu_ps(hierarchy->scale[0] + i);
+    __m256 sy = _mm256_loadu_ps(hierarchy->scale[1] + i);
+    __m256 sz = _mm256_loadu_ps(hierarchy->scale[2] + i);
+
+    __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+    __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+    __m256 xw = _mm256_mul_ps(x, w), yw = _mm256_mul_ps(y, w), zw = _mm256_mul_ps(z, w);
+
+    __m256 local[12];
+    local[0] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx);
+    local[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, zw)), sy);
+    local[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, yw)), sz);
+    local[3] = _mm256_loadu_ps(hierarchy->position[0] + i);
+    local[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, zw)), sx);
+    local[5] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy);
+    local[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, xw)), sz);
+    local[7] = _mm256_loadu_ps(hierarchy->position[1] + i);
+    local[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, yw)), sx);
+    local[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, xw)), sy);
+    local[10] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz);
+    local[11] = _mm256_loadu_ps(hierarchy->position[2] + i);
+
+    __m256 world[12];
+    if (roots) {
+        memcpy(world, local, sizeof(world));
+    } else {
+        // Gather the parent matrices, one element of eight parents at a time
+        const float* base = &hierarchy->world[0].rows[0][0];
+        __m256i offsets = _mm256_mullo_epi32(
+            _mm256_loadu_si256((const __m256i*)(hierarchy->parent + i)), _mm256_set1_epi32(12));
+
+        for (uint32_t r = 0; r < 3; r++) {
+            __m256 p0 = _mm256_i32gather_ps(base + r * 4 + 0, offsets, 4);
+            __m256 p1 = _mm256_i32gather_ps(base + r * 4 + 1, offsets, 4);
+            __m256 p2 = _mm256_i32gather_ps(base + r * 4 + 2, offsets, 4);
+            __m256 p3 = _mm256_i32gather_ps(base + r * 4 + 3, offsets, 4);
+            for (uint32_t c = 0; c < 4; c++) {
+                __m256 value = _mm256_mul_ps(p0, local[c]);
+                value = _mm256_fmadd_ps(p1, local[4 + c], value);
+                value = _mm256_fmadd_ps(p2, local[8 + c], value);
+                world[r * 4 + c] = value;
+            }
+            world[r * 4 + 3] = _mm256_add_ps(world[r * 4 + 3], p3);
+        }
+    }
+
+    // Back to one matrix per node, only the dirty ones are written
+    float lanes[12][TRANSFORM_LANES];
+    for (uint32_t e = 0; e < 12; e++) {
+        _mm256_storeu_ps(lanes[e], world[e]);
+    }
+    for (uint32_t l = 0; l < TRANSFORM_LANES; l++) {
+        if (hierarchy->world_dirty[i + l]) {
+            float* matrix = &hierarchy->world[i + l].rows[0][0];
+            for (uint32_t e = 0; e < 12; e++) {
+                matrix[e] = lanes[e][l];
+            }
+        }
+    }
+}
+#endif
+
+// Hierarchy \\\
+
+void
+vut_transform_hierarchy_init(uint32_t capacity, TransformHierarchy* hierarchy)
+{
+    memset(hierarchy, 0, sizeof(*hierarchy));
+    transform_grow(hierarchy, capacity > 0 ? capacity : 64);
+}
+
+uint32_t
+vut_transform_add(TransformHierarchy* hierarchy, uint32_t parent)
+{
+    if (hierarchy->count == hierarchy->capacity) {
+        transform_grow(hierarchy, hierarchy->capacity * 2);
+    }
+
+    uint32_t i = hierarchy->count++;
+    uint32_t handle = i;
+    hierarchy->handle_index[handle] = i;
+    hierarchy->index_handle[i] = handle;
+
+    for (uint32_t c = 0; c < 3; c++) {
+        hierarchy->position[c][i] = 0.0f;
+        hierarchy->rotation[c][i] = 0.0f;
+        hierarchy->scale[c][i] = 1.0f;
+    }
+    hierarchy->rotation[3][i] = 1.0f;
+
+    if (parent == VUT_TRANSFORM_ROOT) {
+        hierarchy->parent[i] = -1;
+        hierarchy->depth[i] = 0;
+    } else {
+        uint32_t parent_index = hierarchy->handle_index[parent];
+        hierarchy->parent[i] = (int32_t)parent_index;
+        hierarchy->depth[i] = hierarchy->depth[parent_index] + 1;
+    }
+    hierarchy->dirty[i] = 1;
+
+    // Appending at the deepest level keeps the order
+    if (i > 0 && hierarchy->depth[i] < hierarchy->depth[i - 1]) {
+        hierarchy->unsorted = true;
+    }
+
+    return handle;
+}
+
+void
+vut_transform_set_position(TransformHierarchy* hierarchy, uint32_t handle, vec3 position)
+{
+    uint32_t i = hierarchy->handle_index[handle];
+    for (uint32_t c = 0; c < 3; c++) {
+        hierarchy->position[c][i] = position[c];
+    }
+    hierarchy->dirty[i] = 1;
+}
+
+void
+vut_transform_set_rotation(TransformHierarchy* hierarchy, uint32_t handle, versor rotation)
+{
+    uint32_t i = hierarchy->handle_index[handle];
+    for (uint32_t c = 0; c < 4; c++) {
+        hierarchy->rotation[c][i] = rotation[c];
+    }
+    hierarchy->dirty[i] = 1;
+}
+
+void
+vut_transform_set_scale(TransformHierarchy* hierarchy, uint32_t handle, vec3 scale)
+{
+    uint32_t i = hierarchy->handle_index[handle];
+    for (uint32_t c = 0; c < 3; c++) {
+        hierarchy->scale[c][i] = scale[c];
+    }
+    hierarchy->dirty[i] = 1;
+}
+
+void
+vut_transform_hierarchy_update(TransformHierarchy* hierarchy)
+{
+    if (hierarchy->unsorted) {
+        transform_sort(hierarchy);
+    }
+    transform_find_levels(hierarchy);
+
+    // Parents come first, so one pass carries the changes down the hierarchy
+    uint32_t count = hierarchy->count;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t parent = hierarchy->parent[i];
+        hierarchy->world_dirty[i] =
+            hierarchy->dirty[i] | (parent >= 0 ? hierarchy->world_dirty[parent] : 0);
+        hierarchy->dirty[i] = 0;
+    }
+
+    for (uint32_t level = 0; level < hierarchy->level_count; level++) {
+        uint32_t i = hierarchy->level_start[level];
+        uint32_t end = hierarchy->level_start[level + 1];
+
+#ifdef TRANSFORM_SIMD
+        // Blocks of one level only, the next level reads the results
+        for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+            uint64_t dirty;
+            memcpy(&dirty, hierarchy->world_dirty + i, sizeof(dirty));
+            if (dirty) {
+                transform_update_lanes(hierarchy, i, level == 0);
+            }
+        }
+#endif
+
+        for (; i < end; i++) {
+            if (hierarchy->world_dirty[i]) {
+                transform_update_node(hierarchy, i);
+            }
+        }
+    }
+}
+
+uint32_t
+vut_transform_index(const TransformHierarchy* hierarchy, uint32_t handle)
+{
+    return hierarchy->handle_index[handle];
+}
+
+void
+vut_transform_world_mat4(const TransformHierarchy* hierarchy, uint32_t handle, mat4 dest)
+{
+    const TransformMatrix* world = &hierarchy->world[hierarchy->handle_index[handle]];
+    for (uint32_t column = 0; column < 4; column++) {
+        for (uint32_t row = 0; row < 3; row++) {
+            dest[column][row] = world->rows[row][column];
+        }
+        dest[column][3] = column == 3 ? 1.0f : 0.0f;
+    }
+}
+
+void
+vut_transform_hierarchy_destroy(TransformHierarchy* hierarchy)
+{
+    TransformArray arrays[16];
+    uint32_t array_count = transform_arrays(hierarchy, arrays);
+    for (uint32_t a = 0; a < array_count; a++) {
+        free(*arrays[a].array);
+    }
+    free(hierarchy->handle_index);
+    free(hierarchy->level_start);
+
+    memset(hierarchy, 0, sizeof(*hierarchy));
+}
@@ -0,0 +1,158 @@
+/**
+ * @file transform.h
+ * @brief Transform hierarchy stored as structure of arrays, with vectorized propagation of
+ * the world matrices
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "../extern/cglm/include/cglm/cglm.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Parent of the nodes without one
+#define VUT_TRANSFORM_ROOT UINT32_MAX
+
+/**
+ * @brief Affine world matrix as three rows of rotation and scale with the translation in
+ * the last column. Matches three vec4 rows in a shader, 48 bytes instead of 64.
+ */
+typedef struct
+{
+    float rows[3][4];
+} TransformMatrix;
+
+/**
+ * @brief Local translation, rotation and scale of every node, one array per component.
+ * Nodes are kept sorted by depth, so parents come before their children and the nodes of
+ * one depth never depend on each other. Updates recompute only the world matrices of
+ * changed nodes and their descendants, eight nodes at a time with AVX2.
+ *
+ * Nodes are referred to by handles, which stay valid when the nodes are sorted.
+ */
+typedef struct
+{
+    uint32_t count;
+    uint32_t capacity;
+
+    float* position[3];
+    // Quaternion x, y, z, w
+    float* rotation[4];
+    float* scale[3];
+
+    // Index of the parent, -1 for roots
+    int32_t* parent;
+    uint32_t* depth;
+    // The local transform changed since the last update
+    uint8_t* dirty;
+    // The world matrix is recomputed by the running update
+    uint8_t* world_dirty;
+
+    // Handles are the order of creation
+    uint32_t* handle_index;
+    uint32_t* index_handle;
+
+    // Set when a node was added above the deepest level, the next update sorts
+    bool unsorted;
+
+    // First node of every depth, with the node count at the end
+    uint32_t level_count;
+    uint32_t* level_start;
+
+    TransformMatrix* world;
+} TransformHierarchy;
+
+/**
+ * @brief Create an empty hierarchy
+ *
+ * @param[in] capacity Nodes to allocate for, the arrays grow when needed
+ * @param[out] hierarchy The hierarchy
+ */
+void
+vut_transform_hierarchy_init(uint32_t capacity, TransformHierarchy* hierarchy);
+
+/**
+ * @brief Add a node with an identity local transform
+ *
+ * @param[in] hierarchy The hierarchy
+ * @param[in] parent Handle of the parent, VUT_TRANSFORM_ROOT for none
+ * @return uint32_t Handle of the node
+ */
+uint32_t
+vut_transform_add(TransformHierarchy* hierarchy, uint32_t parent);
+
+/**
+ * @brief Set the local translation of a node
+ *
+ * @param[in] hierarchy The hierarchy
+ * @param[in] handle The node
+ * @param[in] position Translation relative to the parent
+ */
+void
+vut_transform_set_position(TransformHierarchy* hierarchy, uint32_t handle, vec3 position);
+
+/**
+ * @brief Set the local rotation of a node
+ *
+ * @param[in] hierarchy The hierarchy
+ * @param[in] handle The node
+ * @param[in] rotation Normalized quaternion, x y z w like cglm
+ */
+void
+vut_transform_set_rotation(TransformHierarchy* hierarchy, uint32_t handle, versor rotation);
+
+/**
+ * @brief Set the local scale of a node
+ *
+ * @param[in] hierarchy The hierarchy
+ * @param[in] handle The node
+ * @param[in] scale Scale along the local axes
+ */
+void
+vut_transform_set_scale(TransformHierarchy* hierarchy, uint32_t handle, vec3 scale);
+
+/**
+ * @brief Recompute the world matrices of the changed nodes and their descendants
+ *
+ * @param[in] hierarchy The hierarchy
+ */
+void
+vut_transform_hierarchy_update(TransformHierarchy* hierarchy);
+
+/**
+ * @brief Get the index of a node in the world matrices. Indices change when an update sorts
+ * the nodes, handles do not.
+ *
+ * @param[in] hierarchy The hierarchy
+ * @param[in] handle The node
+ * @return uint32_t Index into hierarchy->world
+ */
+uint32_t
+vut_transform_index(const TransformHierarchy* hierarchy, uint32_t handle);
+
+/**
+ * @brief Get the world matrix of a node as a column major mat4, like DrawData.transform
+ *
+ * @param[in] hierarchy The hierarchy, updated since the node last changed
+ * @param[in] handle The node
+ * @param[out] dest The matrix
+ */
+void
+vut_transform_world_mat4(const TransformHierarchy* hierarchy, uint32_t handle, mat4 dest);
+
+/**
+ * @brief Free the hierarchy
+ *
+ * @param[in] hierarchy The hierarchy
+ */
+void
+vut_transform_hierarchy_destroy(TransformHierarchy* hierarchy);
+
+#endif // TRANSFORM_H
@@ -0,0 +1,79 @@
+/**
+ * @file triple_buffer.c
+ * @brief Lock free hand over of the latest version of some data from one thread to another
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "triple_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VUT_TRIPLE_BUFFER_FRESH 4u
+#define VUT_TRIPLE_BUFFER_INDEX 3u
+
+// Buffers are cache line aligned, so the threads never write to the same line
+#define VUT_TRIPLE_BUFFER_ALIGNMENT 64
+
+void
+vut_triple_buffer_init(size_t size, TripleBuffer* buffer)
+{
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->stride =
+        (size + VUT_TRIPLE_BUFFER_ALIGNMENT - 1) & ~(size_t)(VUT_TRIPLE_BUFFER_ALIGNMENT - 1);
+    buffer->data = aligned_alloc(VUT_TRIPLE_BUFFER_ALIGNMENT, 3 * buffer->stride);
+    if (buffer->data == NULL) {
+        fprintf(stderr, "Failed to allocate a triple buffer of %zu bytes\n", size);
+        abort();
+    }
+    memset(buffer->data, 0, 3 * buffer->stride);
+
+    buffer->write_index = 0;
+    atomic_init(&buffer->middle, 1);
+    buffer->read_index = 2;
+}
+
+void*
+vut_triple_buffer_write(TripleBuffer* buffer)
+{
+    return buffer->data + buffer->write_index * buffer->stride;
+}
+
+void
+vut_triple_buffer_publish(TripleBuffer* buffer)
+{
+    // Release the written data, acquire the buffer the reader gave up
+    unsigned int middle = atomic_exchange_explicit(
+        &buffer->middle, buffer->write_index | VUT_TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    buffer->write_index = middle & VUT_TRIPLE_BUFFER_INDEX;
+}
+
+const void*
+vut_triple_buffer_read(TripleBuffer* buffer, bool* fresh)
+{
+    bool swapped = false;
+    if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & VUT_TRIPLE_BUFFER_FRESH) {
+        unsigned int middle = atomic_exchange_explicit(&buffer->middle, buffer->read_index,
+                                                       memory_order_acq_rel);
+        buffer->read_index = middle & VUT_TRIPLE_BUFFER_INDEX;
+        swapped = true;
+    }
+
+    if (fresh) {
+        *fresh = swapped;
+    }
+
+    return buffer->data + buffer->read_index * buffer->stride;
+}
+
+void
+vut_triple_buffer_destroy(TripleBuffer* buffer)
+{
+    free(buffer->data);
+    memset(buffer, 0, sizeof(*buffer));
+}
@@ -0,0 +1,82 @@
+/**
+ * @file triple_buffer.h
+ * @brief Lock free hand over of the latest version of some data from one thread to another
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Three buffers for one writer and one reader thread. The writer fills its buffer and
+ * publishes it by swapping it with the middle one, the reader takes the middle one when it
+ * is newer than its own. Neither ever waits, the reader skips versions it was too slow for.
+ */
+typedef struct
+{
+    uint8_t* data;
+    size_t stride;
+
+    // Index of the middle buffer, with VUT_TRIPLE_BUFFER_FRESH when it was not read yet
+    atomic_uint middle;
+
+    // Owned by the writer and the reader thread
+    uint32_t write_index;
+    uint32_t read_index;
+} TripleBuffer;
+
+/**
+ * @brief Allocate the three buffers, zero initialized
+ *
+ * @param[in] size Size of one buffer
+ * @param[out] buffer The triple buffer
+ */
+void
+vut_triple_buffer_init(size_t size, TripleBuffer* buffer);
+
+/**
+ * @brief Get the buffer of the writer. It holds the version from two publishes ago, so
+ * overwrite everything.
+ *
+ * @param[in] buffer The triple buffer
+ * @return void* The buffer to write
+ */
+void*
+vut_triple_buffer_write(TripleBuffer* buffer);
+
+/**
+ * @brief Hand the buffer of the writer to the reader, the writer gets another buffer
+ *
+ * @param[in] buffer The triple buffer
+ */
+void
+vut_triple_buffer_publish(TripleBuffer* buffer);
+
+/**
+ * @brief Get the latest published buffer. It stays the same until the next read.
+ *
+ * @param[in] buffer The triple buffer
+ * @param[out] fresh Set when the buffer was published since the previous read, may be NULL
+ * @return const void* The buffer to read
+ */
+const void*
+vut_triple_buffer_read(TripleBuffer* buffer, bool* fresh);
+
+/**
+ * @brief Free the buffers
+ *
+ * @param[in] buffer The triple buffer
+ */
+void
+vut_triple_buffer_destroy(TripleBuffer* buffer);
+
+#endif // TRIPLE_BUFFER_H
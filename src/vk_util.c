@@ -14,14 +14,54 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
-#include <errno.h>
 
 #define DEBUG 1
 
 // Helper function (WARNING: DO NOT USE WITH FUNCTION POINTERS, HELL WILL BEFALL ALL)
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
 
+// Extension functions are not exported by the loader, vut_init_device loads them
+static PFN_vkCmdBeginRenderingKHR cmd_begin_rendering;
+static PFN_vkCmdEndRenderingKHR cmd_end_rendering;
+static PFN_vkGetDescriptorSetLayoutSizeEXT get_descriptor_set_layout_size;
+static PFN_vkGetDescriptorSetLayoutBindingOffsetEXT get_descriptor_set_layout_binding_offset;
+static PFN_vkGetDescriptorEXT get_descriptor;
+static PFN_vkCmdBindDescriptorBuffersEXT cmd_bind_descriptor_buffers;
+static PFN_vkCmdSetDescriptorBufferOffsetsEXT cmd_set_descriptor_buffer_offsets;
+
+// Budget that device memory allocations are counted against, see vut_set_memory_budget
+static MemoryBudget* memory_budget;
+
+// Passed as pAllocator to every create and destroy call
+static const VkAllocationCallbacks* allocator;
+
+void
+vut_set_allocator(const VkAllocationCallbacks* callbacks)
+{
+    allocator = callbacks;
+}
+
+const VkAllocationCallbacks*
+vut_get_allocator(void)
+{
+    return allocator;
+}
+
+// Temporary arrays of enumerations, see vut_set_scratch_arena
+static _Thread_local Arena* scratch_arena;
+
+void
+vut_set_scratch_arena(Arena* arena)
+{
+    scratch_arena = arena;
+}
+
+Arena*
+vut_get_scratch_arena(void)
+{
+    return scratch_arena;
+}
+
 void
 get_required_extensions(uint32_t* extension_count, const char* extensions[])
 {
@@ -85,7 +125,7 @@ vut_init_instance(const char app_name[], VkInstance* instance)
         .pNext = NULL,
         .pApplicationName = app_name,
         .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
-        .apiVersion = VK_API_VERSION_1_0,
+        .apiVersion = VK_API_VERSION_1_2,
         .pEngineName = "No Engine",
     };
 
@@ -93,9 +133,10 @@ vut_init_instance(const char app_name[], VkInstance* instance)
     uint32_t extension_count = 0;
     get_required_extensions(&extension_count, NULL);
 
-    const char** extensions = malloc(extension_count * sizeof extensions);
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    const char** extensions = VUT_ARENA_ALLOC(scratch_arena, const char*, extension_count);
     get_required_extensions(&extension_count, extensions);
-    
+
     // Create instance
     const char* layer_names[] = { "VK_LAYER_KHRONOS_validation" };
     const VkInstanceCreateInfo instance_info = {
@@ -114,9 +155,9 @@ vut_init_instance(const char app_name[], VkInstance* instance)
 #endif
     };
 
-    VkResult result = vkCreateInstance(&instance_info, NULL, instance);
+    VkResult result = vkCreateInstance(&instance_info, vut_get_allocator(), instance);
 
-    free(extensions);
+    vut_arena_end_scope(scope);
     return result;
 }
 
@@ -150,7 +191,9 @@ vut_pick_physical_device(VkPhysicalDevice* gpus, uint32_t gpu_count, VkPhysicalD
         vkGetPhysicalDeviceQueueFamilyProperties(gpus[i], &queue_family_count, NULL);
 
         // Allocate the memory for the amount of queue families
-        VkQueueFamilyProperties queue_properties[queue_family_count];
+        ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+        VkQueueFamilyProperties* queue_properties =
+            VUT_ARENA_ALLOC(scratch_arena, VkQueueFamilyProperties, queue_family_count);
 
         // Fill the queue family properties array
         vkGetPhysicalDeviceQueueFamilyProperties(gpus[i], &queue_family_count, queue_properties);
@@ -175,6 +218,7 @@ vut_pick_physical_device(VkPhysicalDevice* gpus, uint32_t gpu_count, VkPhysicalD
                 }
             }
         }
+        vut_arena_end_scope(scope);
 
         if (discrete_device_index != -1) {
             *gpu = gpus[discrete_device_index];
@@ -198,13 +242,15 @@ vut_get_queue_family_indices(VkPhysicalDevice gpu,
     // Retrieve count by passing NULL
     uint32_t queue_family_count;
     vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, NULL);
-    VkQueueFamilyProperties queue_properties[queue_family_count];
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    VkQueueFamilyProperties* queue_properties =
+        VUT_ARENA_ALLOC(scratch_arena, VkQueueFamilyProperties, queue_family_count);
 
     // Fill the queue family properties array
     vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, queue_properties);
 
     // Iterate over each queue to learn whether it supports presenting:
-    VkBool32 supports_present[queue_family_count];
+    VkBool32* supports_present = VUT_ARENA_ALLOC(scratch_arena, VkBool32, queue_family_count);
     for (uint32_t i = 0; i < queue_family_count; i++) {
         vkGetPhysicalDeviceSurfaceSupportKHR(gpu, i, surface, &supports_present[i]);
     }
@@ -247,46 +293,305 @@ vut_get_queue_family_indices(VkPhysicalDevice gpu,
     *present_queue_family_index = present_index;
     *separate_present_queue = (graphics_index != present_index);
 
+    vut_arena_end_scope(scope);
     return true;
 }
 
-VkResult
-vut_init_device(VkPhysicalDevice gpu, uint32_t graphics_queue_family_index, VkDevice* device)
+void
+vut_get_compute_queue(VkPhysicalDevice gpu,
+                      uint32_t graphics_queue_family_index,
+                      uint32_t* compute_queue_family_index,
+                      uint32_t* compute_queue_index)
 {
-    // When using a single queue no priority is required
-    float queue_priority[1] = { 1.0 };
+    uint32_t queue_family_count;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, NULL);
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    VkQueueFamilyProperties* queue_properties =
+        VUT_ARENA_ALLOC(scratch_arena, VkQueueFamilyProperties, queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, queue_properties);
+
+    // Share the graphics queue unless something better is found
+    *compute_queue_family_index = graphics_queue_family_index;
+    *compute_queue_index = 0;
+
+    if (queue_properties[graphics_queue_family_index].queueCount > 1) {
+        *compute_queue_index = 1;
+    }
+
+    for (uint32_t i = 0; i < queue_family_count; i++) {
+        VkQueueFlags flags = queue_properties[i].queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+            *compute_queue_family_index = i;
+            *compute_queue_index = 0;
+            break;
+        }
+    }
+
+    vut_arena_end_scope(scope);
+}
 
-    const VkDeviceQueueCreateInfo queue_info = {
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+bool
+vut_has_device_extension(VkPhysicalDevice gpu, const char extension_name[])
+{
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(gpu, NULL, &extension_count, NULL);
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    VkExtensionProperties* extensions =
+        VUT_ARENA_ALLOC(scratch_arena, VkExtensionProperties, extension_count);
+    vkEnumerateDeviceExtensionProperties(gpu, NULL, &extension_count, extensions);
+
+    bool found = false;
+    for (uint32_t i = 0; i < extension_count && !found; i++) {
+        found = strcmp(extensions[i].extensionName, extension_name) == 0;
+    }
+
+    vut_arena_end_scope(scope);
+    return found;
+}
+
+void
+vut_query_device_features(VkPhysicalDevice gpu, DeviceFeatures* features)
+{
+    memset(features, 0, sizeof(*features));
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipeline_library = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
         .pNext = NULL,
-        .flags = 0,
-        .queueFamilyIndex = graphics_queue_family_index,
-        .queueCount = 1,
-        .pQueuePriorities = queue_priority,
     };
 
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+        .pNext = &pipeline_library,
+    };
+
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+        .pNext = &dynamic_rendering,
+    };
+
+    VkPhysicalDeviceBufferDeviceAddressFeatures device_address = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES,
+        .pNext = &descriptor_indexing,
+    };
+
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptor_buffer = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = &device_address,
+    };
+
+    VkPhysicalDeviceFeatures2 features2 = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &descriptor_buffer,
+    };
+    vkGetPhysicalDeviceFeatures2(gpu, &features2);
+
+    features->graphics_pipeline_library =
+        pipeline_library.graphicsPipelineLibrary &&
+        vut_has_device_extension(gpu, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+        vut_has_device_extension(gpu, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    features->dynamic_rendering =
+        dynamic_rendering.dynamicRendering &&
+        vut_has_device_extension(gpu, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+
+    // Everything the bindless set needs, the extension itself is core in Vulkan 1.2
+    features->descriptor_indexing =
+        descriptor_indexing.runtimeDescriptorArray &&
+        descriptor_indexing.descriptorBindingPartiallyBound &&
+        descriptor_indexing.descriptorBindingUpdateUnusedWhilePending &&
+        descriptor_indexing.descriptorBindingSampledImageUpdateAfterBind &&
+        descriptor_indexing.descriptorBindingStorageBufferUpdateAfterBind &&
+        descriptor_indexing.shaderSampledImageArrayNonUniformIndexing &&
+        descriptor_indexing.shaderStorageBufferArrayNonUniformIndexing;
+
+    // Descriptors in a buffer point at resources with their device address
+    features->descriptor_buffer =
+        descriptor_buffer.descriptorBuffer && device_address.bufferDeviceAddress &&
+        vut_has_device_extension(gpu, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+
+    // Only adds a query, there is no feature struct
+    features->memory_budget = vut_has_device_extension(gpu, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+}
+
+void
+vut_get_descriptor_indexing_properties(VkPhysicalDevice gpu,
+                                       VkPhysicalDeviceDescriptorIndexingProperties* properties)
+{
+    *properties = (VkPhysicalDeviceDescriptorIndexingProperties){
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+        .pNext = NULL,
+    };
+
+    VkPhysicalDeviceProperties2 properties2 = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = properties,
+    };
+    vkGetPhysicalDeviceProperties2(gpu, &properties2);
+}
+
+void
+vut_get_descriptor_buffer_properties(VkPhysicalDevice gpu,
+                                     VkPhysicalDeviceDescriptorBufferPropertiesEXT* properties)
+{
+    *properties = (VkPhysicalDeviceDescriptorBufferPropertiesEXT){
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT,
+        .pNext = NULL,
+    };
+
+    VkPhysicalDeviceProperties2 properties2 = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = properties,
+    };
+    vkGetPhysicalDeviceProperties2(gpu, &properties2);
+}
+
+VkResult
+vut_init_device(VkPhysicalDevice gpu,
+                uint32_t graphics_queue_family_index,
+                uint32_t compute_queue_family_index,
+                uint32_t compute_queue_index,
+                const DeviceFeatures* features,
+                VkDevice* device)
+{
+    // Graphics and compute get the same priority, neither should starve the other
+    const float queue_priorities[2] = { 1.0, 1.0 };
+
+    // The compute queue is either in its own family or the second of the graphics family
+    VkDeviceQueueCreateInfo queue_infos[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .queueFamilyIndex = graphics_queue_family_index,
+            .queueCount = 1,
+            .pQueuePriorities = queue_priorities,
+        },
+    };
+    uint32_t queue_info_count = 1;
+    if (compute_queue_family_index == graphics_queue_family_index) {
+        queue_infos[0].queueCount = compute_queue_index + 1;
+    } else {
+        queue_infos[queue_info_count++] = (VkDeviceQueueCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .queueFamilyIndex = compute_queue_family_index,
+            .queueCount = 1,
+            .pQueuePriorities = queue_priorities,
+        };
+    }
+
     // Device needs swapchain for displaying graphics
-    const char* device_extensions[1] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    const char* device_extensions[8] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    uint32_t extension_count = 1;
+
+    // Optional features are chained on the create info
+    const void* next = NULL;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipeline_library = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .pNext = NULL,
+        .graphicsPipelineLibrary = VK_TRUE,
+    };
+    if (features->graphics_pipeline_library) {
+        device_extensions[extension_count++] = VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME;
+        device_extensions[extension_count++] = VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME;
+        pipeline_library.pNext = (void*)next;
+        next = &pipeline_library;
+    }
+
+    // Depth stencil resolve, which dynamic rendering depends on, is core in Vulkan 1.2
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+        .pNext = NULL,
+        .dynamicRendering = VK_TRUE,
+    };
+    if (features->dynamic_rendering) {
+        device_extensions[extension_count++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+        dynamic_rendering.pNext = (void*)next;
+        next = &dynamic_rendering;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+        .pNext = NULL,
+        .runtimeDescriptorArray = VK_TRUE,
+        .descriptorBindingPartiallyBound = VK_TRUE,
+        .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+        .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+        .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+        .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+        .shaderStorageBufferArrayNonUniformIndexing = VK_TRUE,
+    };
+    if (features->descriptor_indexing) {
+        // Promoted to Vulkan 1.2, still enabled for devices that only support 1.1
+        if (vut_has_device_extension(gpu, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+            device_extensions[extension_count++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+        }
+        descriptor_indexing.pNext = (void*)next;
+        next = &descriptor_indexing;
+    }
+
+    VkPhysicalDeviceBufferDeviceAddressFeatures device_address = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES,
+        .pNext = NULL,
+        .bufferDeviceAddress = VK_TRUE,
+    };
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptor_buffer = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = &device_address,
+        .descriptorBuffer = VK_TRUE,
+    };
+    if (features->descriptor_buffer) {
+        device_extensions[extension_count++] = VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME;
+        device_address.pNext = (void*)next;
+        next = &descriptor_buffer;
+    }
+
+    if (features->memory_budget) {
+        device_extensions[extension_count++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+    }
 
     const VkDeviceCreateInfo device_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext = NULL,
+        .pNext = next,
         .flags = 0,
-        .queueCreateInfoCount = 1,
-        .pQueueCreateInfos = &queue_info,
-        .enabledExtensionCount = 1,
+        .queueCreateInfoCount = queue_info_count,
+        .pQueueCreateInfos = queue_infos,
+        .enabledExtensionCount = extension_count,
         .ppEnabledExtensionNames = device_extensions,
         .enabledLayerCount = 0,
         .ppEnabledLayerNames = NULL,
         .pEnabledFeatures = NULL,
     };
 
-    VkResult result = vkCreateDevice(gpu, &device_info, NULL, device);
+    VkResult result = vkCreateDevice(gpu, &device_info, vut_get_allocator(), device);
     if (result) {
         fprintf(stderr, "An unknown error occured while creating a device\n");
         abort();
     }
 
+    if (features->dynamic_rendering) {
+        cmd_begin_rendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(
+            *device, "vkCmdBeginRenderingKHR");
+        cmd_end_rendering =
+            (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(*device, "vkCmdEndRenderingKHR");
+    }
+
+    if (features->descriptor_buffer) {
+        get_descriptor_set_layout_size = (PFN_vkGetDescriptorSetLayoutSizeEXT)vkGetDeviceProcAddr(
+            *device, "vkGetDescriptorSetLayoutSizeEXT");
+        get_descriptor_set_layout_binding_offset =
+            (PFN_vkGetDescriptorSetLayoutBindingOffsetEXT)vkGetDeviceProcAddr(
+                *device, "vkGetDescriptorSetLayoutBindingOffsetEXT");
+        get_descriptor =
+            (PFN_vkGetDescriptorEXT)vkGetDeviceProcAddr(*device, "vkGetDescriptorEXT");
+        cmd_bind_descriptor_buffers = (PFN_vkCmdBindDescriptorBuffersEXT)vkGetDeviceProcAddr(
+            *device, "vkCmdBindDescriptorBuffersEXT");
+        cmd_set_descriptor_buffer_offsets =
+            (PFN_vkCmdSetDescriptorBufferOffsetsEXT)vkGetDeviceProcAddr(
+                *device, "vkCmdSetDescriptorBufferOffsetsEXT");
+    }
+
     return VK_SUCCESS;
 }
 
@@ -294,7 +599,7 @@ VkResult
 vut_init_surface(VkInstance instance, GLFWwindow* window, VkSurfaceKHR* surface)
 {
     // Let GLFW handle cross-platform surface creation
-    if (glfwCreateWindowSurface(instance, window, NULL, surface) != VK_SUCCESS) {
+    if (glfwCreateWindowSurface(instance, window, vut_get_allocator(), surface) != VK_SUCCESS) {
         // Error
     }
 
@@ -310,7 +615,7 @@ vut_init_semaphore(VkDevice device, VkSemaphore* semaphore)
         .flags = 0,
     };
 
-    VkResult result = vkCreateSemaphore(device, &semaphore_info, NULL, semaphore);
+    VkResult result = vkCreateSemaphore(device, &semaphore_info, vut_get_allocator(), semaphore);
     if (result) {
         // Error
     }
@@ -319,15 +624,15 @@ vut_init_semaphore(VkDevice device, VkSemaphore* semaphore)
 }
 
 VkResult
-vut_init_fence(VkDevice device, VkFence* fence)
+vut_init_fence(VkDevice device, VkFenceCreateFlags flags, VkFence* fence)
 {
     const VkFenceCreateInfo fence_info = {
         .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
         .pNext = NULL,
-        .flags = 0,
+        .flags = flags,
     };
 
-    VkResult result = vkCreateFence(device, &fence_info, NULL, fence);
+    VkResult result = vkCreateFence(device, &fence_info, vut_get_allocator(), fence);
     if (result) {
         // Error
     }
@@ -348,7 +653,8 @@ vut_get_present_mode(VkSurfaceCapabilitiesKHR capabilities,
         // Error
     }
 
-    VkPresentModeKHR present_modes[count];
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    VkPresentModeKHR* present_modes = VUT_ARENA_ALLOC(scratch_arena, VkPresentModeKHR, count);
     result = vkGetPhysicalDeviceSurfacePresentModesKHR(gpu, surface, &count, present_modes);
     if (result) {
         // Error
@@ -369,6 +675,7 @@ vut_get_present_mode(VkSurfaceCapabilitiesKHR capabilities,
         }
     }
 
+    vut_arena_end_scope(scope);
     return present_mode;
 }
 
@@ -414,7 +721,9 @@ vut_get_surface_format(VkPhysicalDevice gpu,
         // Error
     }
 
-    VkSurfaceFormatKHR surface_formats[format_count];
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    VkSurfaceFormatKHR* surface_formats =
+        VUT_ARENA_ALLOC(scratch_arena, VkSurfaceFormatKHR, format_count);
     result = vkGetPhysicalDeviceSurfaceFormatsKHR(gpu, surface, &format_count, surface_formats);
     if (result) {
         // Error
@@ -430,6 +739,7 @@ vut_get_surface_format(VkPhysicalDevice gpu,
     }
     *color_space = surface_formats[0].colorSpace;
 
+    vut_arena_end_scope(scope);
     return VK_SUCCESS;
 }
 
@@ -481,6 +791,12 @@ vut_init_swapchain(VkPhysicalDevice gpu,
         }
     }
 
+    // Readable when the surface allows it, so frames can be captured
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
     const VkSwapchainCreateInfoKHR swapchain_create_info = {
         .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
         .pNext = NULL,
@@ -491,7 +807,7 @@ vut_init_swapchain(VkPhysicalDevice gpu,
         .imageColorSpace = color_space,
         .imageExtent = extent,
         .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage = usage,
         .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = NULL,
@@ -502,19 +818,15 @@ vut_init_swapchain(VkPhysicalDevice gpu,
         .oldSwapchain = old_swapchain,
     };
 
-    VkResult result = vkCreateSwapchainKHR(device, &swapchain_create_info, NULL, swapchain);
+    VkResult result =
+        vkCreateSwapchainKHR(device, &swapchain_create_info, vut_get_allocator(), swapchain);
     if (result) {
         fprintf(stderr, "Failed to create swapchain\n");
         abort();
     }
 
-    // If we just re-created an existing swapchain, we should destroy the old
-    // swapchain at this point.
-    // Note: destroying the swapchain also cleans up all its associated
-    // presentable images once the platform is done with them.
-    if (old_swapchain != VK_NULL_HANDLE) {
-        vkDestroySwapchainKHR(device, old_swapchain, NULL);
-    }
+    // The old swapchain is retired, frames in flight may still present to it. The caller
+    // destroys it, which also cleans up its presentable images.
 
     return VK_SUCCESS;
 }
@@ -551,7 +863,7 @@ vut_init_image_view(VkDevice device,
         .image = swapchain_image,
     };
 
-    VkResult result = vkCreateImageView(device, &color_image_view, NULL, image_view);
+    VkResult result = vkCreateImageView(device, &color_image_view, vut_get_allocator(), image_view);
     if (result) {
         // Error
     }
@@ -561,70 +873,79 @@ vut_init_image_view(VkDevice device,
 
 // Pipeline
 VkResult
-read_shader_file(const char* name, size_t* size, uint32_t code[])
+vut_init_shader_module(VkDevice device,
+                       const uint32_t code[],
+                       size_t size,
+                       VkShaderModule* shader_module)
 {
-    if (code == NULL) {
-        struct stat sb;
-        if (stat(name, &sb) != -1) {
-            *size = sb.st_size;
-        }
-
-        return VK_SUCCESS;
-    }
-
-    FILE* shader;
-    shader = fopen(name, "rb");
-    if (shader == NULL) {
-        printf("  err %d \n", errno);
-    }
-
-    size_t bytes_written = fread(code, sizeof(char), *size, shader);
-    if (bytes_written != *size) {
-        // Error
-    }
+    const VkShaderModuleCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .codeSize = size,
+        .pCode = code,
+    };
 
-    return VK_SUCCESS;
+    return vkCreateShaderModule(device, &create_info, vut_get_allocator(), shader_module);
 }
 
 VkResult
-vut_init_shader_module(VkDevice device, char* shader_name, VkShaderModule* shader_module)
+vut_init_descriptor_set_layout(VkDevice device,
+                               uint32_t binding_count,
+                               const VkDescriptorSetLayoutBinding bindings[],
+                               VkDescriptorSetLayoutCreateFlags flags,
+                               VkDescriptorSetLayout* descriptor_layout)
 {
-    size_t size;
-    read_shader_file(shader_name, &size, NULL);
-    uint32_t bytes[size];
-    read_shader_file(shader_name, &size, bytes);
+    bool update_after_bind = flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+
+    ArenaScope scope = vut_arena_begin_scope(scratch_arena);
+    VkDescriptorBindingFlags* binding_flags =
+        VUT_ARENA_ALLOC(scratch_arena, VkDescriptorBindingFlags, binding_count);
+    for (uint32_t i = 0; i < binding_count; i++) {
+        binding_flags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                           VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    }
 
-    VkShaderModuleCreateInfo createInfo = {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = size,
-        .pCode = bytes,
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .pNext = NULL,
+        .bindingCount = binding_count,
+        .pBindingFlags = binding_flags,
     };
 
-    if (vkCreateShaderModule(device, &createInfo, NULL, shader_module) != VK_SUCCESS) {
-        return false;
-    }
+    const VkDescriptorSetLayoutCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = update_after_bind ? &flags_info : NULL,
+        .flags = flags,
+        .bindingCount = binding_count,
+        .pBindings = bindings,
+    };
 
-    return true;
+    VkResult result = vkCreateDescriptorSetLayout(device, &create_info, vut_get_allocator(),
+                                                  descriptor_layout);
+    vut_arena_end_scope(scope);
+    return result;
 }
 
 VkResult
 vut_init_pipeline_layout(VkDevice device,
-                         VkDescriptorSetLayout* descriptor_layout,
+                         uint32_t set_layout_count,
+                         const VkDescriptorSetLayout set_layouts[],
+                         uint32_t push_constant_range_count,
+                         const VkPushConstantRange push_constant_ranges[],
                          VkPipelineLayout* pipeline_layout)
 {
     const VkPipelineLayoutCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = NULL,
-        .setLayoutCount = 0,
-        .pSetLayouts = descriptor_layout,
+        .setLayoutCount = set_layout_count,
+        .pSetLayouts = set_layouts,
+        .pushConstantRangeCount = push_constant_range_count,
+        .pPushConstantRanges = push_constant_ranges,
     };
 
-    VkResult result = vkCreatePipelineLayout(device, &create_info, NULL, pipeline_layout);
-    if (result) {
-        // Error
-    }
-
-    return VK_SUCCESS;
+    return vkCreatePipelineLayout(device, &create_info, vut_get_allocator(), pipeline_layout);
 }
 
 VkResult
@@ -660,7 +981,8 @@ vut_prepare_render_pass(VkDevice device, VkFormat surface_format, VkRenderPass*
         .pSubpasses = &subpass,
     };
 
-    VkResult result = vkCreateRenderPass(device, &render_pass_info, NULL, render_pass);
+    VkResult result =
+        vkCreateRenderPass(device, &render_pass_info, vut_get_allocator(), render_pass);
     if (result) {
         // Error
     }
@@ -668,8 +990,24 @@ vut_prepare_render_pass(VkDevice device, VkFormat surface_format, VkRenderPass*
     return VK_SUCCESS;
 }
 
+VkResult
+vut_init_pipeline_cache(VkDevice device, VkPipelineCache* pipeline_cache)
+{
+    const VkPipelineCacheCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .initialDataSize = 0,
+        .pInitialData = NULL,
+    };
+
+    return vkCreatePipelineCache(device, &create_info, vut_get_allocator(), pipeline_cache);
+}
+
 VkResult
 vut_init_pipeline(VkDevice device,
+                  VkPipelineCache pipeline_cache,
+                  VkPipelineCreateFlags flags,
                   const VkPipelineShaderStageCreateInfo stages[],
                   const VkPipelineVertexInputStateCreateInfo* vertex_input,
                   const VkPipelineInputAssemblyStateCreateInfo* input_assembly,
@@ -677,12 +1015,16 @@ vut_init_pipeline(VkDevice device,
                   const VkPipelineRasterizationStateCreateInfo* rasterizer,
                   const VkPipelineMultisampleStateCreateInfo* multisampling,
                   const VkPipelineColorBlendStateCreateInfo* color_blending,
+                  const VkPipelineDynamicStateCreateInfo* dynamic_state,
                   VkPipelineLayout pipeline_layout,
                   VkRenderPass render_pass,
+                  const VkPipelineRenderingCreateInfoKHR* rendering,
                   VkPipeline* pipeline)
 {
     VkGraphicsPipelineCreateInfo pipelineInfo = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = rendering,
+        .flags = flags,
         .stageCount = 2,
         .pStages = stages,
         .pVertexInputState = vertex_input,
@@ -692,7 +1034,7 @@ vut_init_pipeline(VkDevice device,
         .pMultisampleState = multisampling,
         .pDepthStencilState = NULL,
         .pColorBlendState = color_blending,
-        .pDynamicState = NULL,
+        .pDynamicState = dynamic_state,
         .layout = pipeline_layout,
         .renderPass = render_pass,
         .subpass = 0,
@@ -700,12 +1042,82 @@ vut_init_pipeline(VkDevice device,
         .basePipelineIndex = -1,
     };
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, pipeline) !=
-        VK_SUCCESS) {
-        return false;
-    }
+    return vkCreateGraphicsPipelines(device, pipeline_cache, 1, &pipelineInfo, vut_get_allocator(),
+                                     pipeline);
+}
 
-    return true;
+VkResult
+vut_init_pipeline_library(VkDevice device,
+                          VkPipelineCache pipeline_cache,
+                          VkGraphicsPipelineLibraryFlagsEXT parts,
+                          const VkGraphicsPipelineCreateInfo* create_info,
+                          VkPipeline* library)
+{
+    VkGraphicsPipelineLibraryCreateInfoEXT library_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .pNext = (void*)create_info->pNext,
+        .flags = parts,
+    };
+
+    VkGraphicsPipelineCreateInfo pipeline_info = *create_info;
+    pipeline_info.pNext = &library_info;
+    pipeline_info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+                           VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+    return vkCreateGraphicsPipelines(device, pipeline_cache, 1, &pipeline_info, vut_get_allocator(),
+                                     library);
+}
+
+VkResult
+vut_link_pipeline(VkDevice device,
+                  VkPipelineCache pipeline_cache,
+                  uint32_t library_count,
+                  const VkPipeline libraries[],
+                  VkPipelineLayout pipeline_layout,
+                  VkPipelineCreateFlags flags,
+                  bool optimize,
+                  VkPipeline* pipeline)
+{
+    const VkPipelineLibraryCreateInfoKHR library_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .pNext = NULL,
+        .libraryCount = library_count,
+        .pLibraries = libraries,
+    };
+
+    const VkGraphicsPipelineCreateInfo pipeline_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &library_info,
+        .flags = flags | (optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0),
+        .layout = pipeline_layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    return vkCreateGraphicsPipelines(device, pipeline_cache, 1, &pipeline_info, vut_get_allocator(),
+                                     pipeline);
+}
+
+VkResult
+vut_init_compute_pipeline(VkDevice device,
+                          VkPipelineCache pipeline_cache,
+                          VkPipelineCreateFlags flags,
+                          const VkPipelineShaderStageCreateInfo* stage,
+                          VkPipelineLayout pipeline_layout,
+                          VkPipeline* pipeline)
+{
+    const VkComputePipelineCreateInfo pipeline_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = flags,
+        .stage = *stage,
+        .layout = pipeline_layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    return vkCreateComputePipelines(device, pipeline_cache, 1, &pipeline_info, vut_get_allocator(),
+                                    pipeline);
 }
 
 VkResult
@@ -728,7 +1140,7 @@ vut_prepare_framebuffer(VkDevice device,
         .layers = 1,
     };
 
-    VkResult result = vkCreateFramebuffer(device, &create_info, NULL, framebuffer);
+    VkResult result = vkCreateFramebuffer(device, &create_info, vut_get_allocator(), framebuffer);
     if (result) {
         // Error
     }
@@ -736,19 +1148,290 @@ vut_prepare_framebuffer(VkDevice device,
     return VK_SUCCESS;
 }
 
+// Buffers
+
+uint32_t
+vut_find_memory_type(VkPhysicalDevice gpu, uint32_t type_bits, VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(gpu, &memory_properties);
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+        if ((type_bits & (1u << i)) &&
+            (memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+void
+vut_set_memory_budget(MemoryBudget* budget)
+{
+    memory_budget = budget;
+}
+
+VkResult
+vut_allocate_memory(VkDevice device,
+                    const VkMemoryAllocateInfo* alloc_info,
+                    VkDeviceMemory* memory)
+{
+    VkResult result = vkAllocateMemory(device, alloc_info, vut_get_allocator(), memory);
+    // Memory the budget does not know about would never be counted, so it is not handed out
+    if (result == VK_SUCCESS && memory_budget &&
+        !vut_memory_budget_track(memory_budget, *memory, alloc_info->memoryTypeIndex,
+                                 alloc_info->allocationSize)) {
+        vkFreeMemory(device, *memory, vut_get_allocator());
+        *memory = VK_NULL_HANDLE;
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return result;
+}
+
+void
+vut_free_memory(VkDevice device, VkDeviceMemory memory)
+{
+    if (memory_budget && memory != VK_NULL_HANDLE) {
+        vut_memory_budget_untrack(memory_budget, memory);
+    }
+
+    vkFreeMemory(device, memory, vut_get_allocator());
+}
+
+VkResult
+vut_init_buffer(VkDevice device,
+                VkPhysicalDevice gpu,
+                VkDeviceSize size,
+                VkBufferUsageFlags usage,
+                VkMemoryPropertyFlags properties,
+                VkBuffer* buffer,
+                VkDeviceMemory* memory)
+{
+    const VkBufferCreateInfo buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    VkResult result = vkCreateBuffer(device, &buffer_info, vut_get_allocator(), buffer);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, *buffer, &requirements);
+
+    // Buffers read through their device address need memory that has one
+    const VkMemoryAllocateFlagsInfo flags_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .pNext = NULL,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+        .deviceMask = 0,
+    };
+
+    const VkMemoryAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &flags_info : NULL,
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = vut_find_memory_type(gpu, requirements.memoryTypeBits, properties),
+    };
+
+    if (alloc_info.memoryTypeIndex == UINT32_MAX) {
+        result = VK_ERROR_FEATURE_NOT_PRESENT;
+    } else {
+        result = vut_allocate_memory(device, &alloc_info, memory);
+    }
+    if (result == VK_SUCCESS) {
+        result = vkBindBufferMemory(device, *buffer, *memory, 0);
+        if (result != VK_SUCCESS) {
+            vut_free_memory(device, *memory);
+        }
+    }
+
+    if (result != VK_SUCCESS) {
+        vkDestroyBuffer(device, *buffer, vut_get_allocator());
+        *buffer = VK_NULL_HANDLE;
+        *memory = VK_NULL_HANDLE;
+    }
+
+    return result;
+}
+
+// Descriptors
+
+VkResult
+vut_init_descriptor_pool(VkDevice device,
+                         VkDescriptorPoolCreateFlags flags,
+                         uint32_t max_sets,
+                         uint32_t pool_size_count,
+                         const VkDescriptorPoolSize pool_sizes[],
+                         VkDescriptorPool* descriptor_pool)
+{
+    const VkDescriptorPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = flags,
+        .maxSets = max_sets,
+        .poolSizeCount = pool_size_count,
+        .pPoolSizes = pool_sizes,
+    };
+
+    return vkCreateDescriptorPool(device, &create_info, vut_get_allocator(), descriptor_pool);
+}
+
+VkResult
+vut_alloc_descriptor_set(VkDevice device,
+                         VkDescriptorPool descriptor_pool,
+                         VkDescriptorSetLayout layout,
+                         VkDescriptorSet* descriptor_set)
+{
+    const VkDescriptorSetAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = NULL,
+        .descriptorPool = descriptor_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+
+    return vkAllocateDescriptorSets(device, &alloc_info, descriptor_set);
+}
+
+void
+vut_write_buffer_descriptor(VkDevice device,
+                            VkDescriptorSet descriptor_set,
+                            uint32_t binding,
+                            VkDescriptorType type,
+                            VkBuffer buffer,
+                            VkDeviceSize range)
+{
+    const VkDescriptorBufferInfo buffer_info = {
+        .buffer = buffer,
+        .offset = 0,
+        .range = range,
+    };
+
+    const VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = NULL,
+        .dstSet = descriptor_set,
+        .dstBinding = binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pBufferInfo = &buffer_info,
+    };
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+}
+
+void
+vut_write_image_descriptor(VkDevice device,
+                           VkDescriptorSet descriptor_set,
+                           uint32_t binding,
+                           VkDescriptorType type,
+                           VkImageView view,
+                           VkImageLayout layout)
+{
+    const VkDescriptorImageInfo image_info = {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = view,
+        .imageLayout = layout,
+    };
+
+    const VkWriteDescriptorSet write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = NULL,
+        .dstSet = descriptor_set,
+        .dstBinding = binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pImageInfo = &image_info,
+    };
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+}
+
+VkDeviceAddress
+vut_get_buffer_address(VkDevice device, VkBuffer buffer)
+{
+    const VkBufferDeviceAddressInfo address_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .pNext = NULL,
+        .buffer = buffer,
+    };
+
+    return vkGetBufferDeviceAddress(device, &address_info);
+}
+
+VkDeviceSize
+vut_get_descriptor_set_layout_size(VkDevice device, VkDescriptorSetLayout layout)
+{
+    VkDeviceSize size;
+    get_descriptor_set_layout_size(device, layout, &size);
+    return size;
+}
+
+VkDeviceSize
+vut_get_descriptor_binding_offset(VkDevice device, VkDescriptorSetLayout layout, uint32_t binding)
+{
+    VkDeviceSize offset;
+    get_descriptor_set_layout_binding_offset(device, layout, binding, &offset);
+    return offset;
+}
+
+void
+vut_get_descriptor(VkDevice device,
+                   const VkDescriptorGetInfoEXT* info,
+                   size_t size,
+                   void* descriptor)
+{
+    get_descriptor(device, info, size, descriptor);
+}
+
+void
+vut_bind_descriptor_buffers(VkCommandBuffer buffer,
+                            uint32_t count,
+                            const VkDescriptorBufferBindingInfoEXT bindings[])
+{
+    cmd_bind_descriptor_buffers(buffer, count, bindings);
+}
+
+void
+vut_set_descriptor_buffer_offsets(VkCommandBuffer buffer,
+                                  VkPipelineBindPoint bind_point,
+                                  VkPipelineLayout layout,
+                                  uint32_t first_set,
+                                  uint32_t count,
+                                  const uint32_t buffer_indices[],
+                                  const VkDeviceSize offsets[])
+{
+    cmd_set_descriptor_buffer_offsets(buffer, bind_point, layout, first_set, count, buffer_indices,
+                                      offsets);
+}
+
 // Command Buffers
 
 VkResult
-vut_init_command_pool(VkDevice device, uint32_t family_index, VkCommandPool* command_pool)
+vut_init_command_pool(VkDevice device,
+                      uint32_t family_index,
+                      VkCommandPoolCreateFlags flags,
+                      VkCommandPool* command_pool)
 {
     const VkCommandPoolCreateInfo command_pool_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
         .pNext = NULL,
-        .flags = 0,
+        .flags = flags,
         .queueFamilyIndex = family_index,
     };
 
-    VkResult result = vkCreateCommandPool(device, &command_pool_info, NULL, command_pool);
+    VkResult result =
+        vkCreateCommandPool(device, &command_pool_info, vut_get_allocator(), command_pool);
     if (result) {
         // Error
     }
@@ -778,6 +1461,23 @@ vut_alloc_command_buffer(VkDevice device,
     return VK_SUCCESS;
 }
 
+VkResult
+vut_alloc_secondary_command_buffers(VkDevice device,
+                                    VkCommandPool command_pool,
+                                    uint32_t count,
+                                    VkCommandBuffer command_buffers[])
+{
+    const VkCommandBufferAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = NULL,
+        .commandPool = command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = count,
+    };
+
+    return vkAllocateCommandBuffers(device, &alloc_info, command_buffers);
+}
+
 VkResult
 vut_begin_command_buffer(VkCommandBuffer command_buffer)
 {
@@ -796,11 +1496,43 @@ vut_begin_command_buffer(VkCommandBuffer command_buffer)
     return VK_SUCCESS;
 }
 
+VkResult
+vut_begin_secondary_command_buffer(VkCommandBuffer command_buffer,
+                                   VkRenderPass render_pass,
+                                   VkFormat color_format)
+{
+    const VkCommandBufferInheritanceRenderingInfoKHR rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &color_format,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+
+    // The framebuffer is left out, the buffer is executed with every swapchain image
+    const VkCommandBufferInheritanceInfo inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = render_pass ? NULL : &rendering_info,
+        .renderPass = render_pass,
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+    };
+
+    const VkCommandBufferBeginInfo buffer_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance_info,
+    };
+
+    return vkBeginCommandBuffer(command_buffer, &buffer_begin_info);
+}
+
 VkResult
 vut_begin_render_pass(VkCommandBuffer buffer,
                       VkRenderPass render_pass,
                       VkFramebuffer framebuffer,
-                      VkExtent2D extent)
+                      VkExtent2D extent,
+                      VkSubpassContents contents)
 {
     VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
 
@@ -814,7 +1546,125 @@ vut_begin_render_pass(VkCommandBuffer buffer,
         .pClearValues = &clearColor,
     };
 
-    vkCmdBeginRenderPass(buffer, &render_pass_begin, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(buffer, &render_pass_begin, contents);
 
     return VK_SUCCESS;
-}
\ No newline at end of file
+}
+
+void
+vut_begin_rendering(VkCommandBuffer buffer,
+                    VkImageView image_view,
+                    VkExtent2D extent,
+                    VkSubpassContents contents)
+{
+    const VkRenderingAttachmentInfoKHR color_attachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+        .imageView = image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .resolveMode = VK_RESOLVE_MODE_NONE,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = { 0.0f, 0.0f, 0.0f, 1.0f },
+    };
+
+    const VkRenderingInfoKHR rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+        .flags = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                     ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR
+                     : 0,
+        .renderArea.offset = { 0, 0 },
+        .renderArea.extent = extent,
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment,
+    };
+
+    cmd_begin_rendering(buffer, &rendering_info);
+}
+
+void
+vut_end_rendering(VkCommandBuffer buffer)
+{
+    cmd_end_rendering(buffer);
+}
+
+VkImageAspectFlags
+vut_get_format_aspect(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+void
+vut_transition_image(VkCommandBuffer buffer,
+                     VkImage image,
+                     VkImageAspectFlags aspect,
+                     VkImageLayout old_layout,
+                     VkImageLayout new_layout,
+                     VkPipelineStageFlags src_stage,
+                     VkAccessFlags src_access,
+                     VkPipelineStageFlags dst_stage,
+                     VkAccessFlags dst_access)
+{
+    const VkImageMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = src_access,
+        .dstAccessMask = dst_access,
+        .oldLayout = old_layout,
+        .newLayout = new_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange.aspectMask = aspect,
+        .subresourceRange.baseMipLevel = 0,
+        .subresourceRange.levelCount = 1,
+        .subresourceRange.baseArrayLayer = 0,
+        .subresourceRange.layerCount = 1,
+    };
+
+    vkCmdPipelineBarrier(buffer, src_stage, dst_stage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+void
+vut_memory_barrier(VkCommandBuffer buffer,
+                   VkPipelineStageFlags src_stage,
+                   VkAccessFlags src_access,
+                   VkPipelineStageFlags dst_stage,
+                   VkAccessFlags dst_access)
+{
+    const VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = src_access,
+        .dstAccessMask = dst_access,
+    };
+
+    vkCmdPipelineBarrier(buffer, src_stage, dst_stage, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+void
+vut_dispatch(VkCommandBuffer buffer,
+             uint32_t group_count_x,
+             uint32_t group_count_y,
+             uint32_t group_count_z)
+{
+    vkCmdDispatch(buffer, group_count_x, group_count_y, group_count_z);
+}
+
+void
+vut_dispatch_indirect(VkCommandBuffer buffer, VkBuffer indirect_buffer, VkDeviceSize offset)
+{
+    vkCmdDispatchIndirect(buffer, indirect_buffer, offset);
+}
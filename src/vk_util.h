@@ -15,8 +15,61 @@
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
 
+#include "arena.h"
+#include "host_allocator.h"
+#include "memory_budget.h"
+
 #include <stdbool.h>
 
+/**
+ * @brief Optional device functionality, detected by vut_query_device_features and
+ * enabled by vut_init_device
+ */
+typedef struct
+{
+    bool graphics_pipeline_library;
+    bool dynamic_rendering;
+    bool descriptor_indexing;
+    bool descriptor_buffer;
+    bool memory_budget;
+} DeviceFeatures;
+
+/**
+ * @brief Set the host allocation callbacks passed to every Vulkan create and destroy call.
+ * Set it before the instance is created and keep it until the instance is destroyed.
+ *
+ * @param[in] callbacks The callbacks, NULL for the allocator of the driver
+ */
+void
+vut_set_allocator(const VkAllocationCallbacks* callbacks);
+
+/**
+ * @brief Get the host allocation callbacks set with vut_set_allocator
+ *
+ * @return const VkAllocationCallbacks* NULL when the driver allocates itself
+ */
+const VkAllocationCallbacks*
+vut_get_allocator(void);
+
+/**
+ * @brief Set the arena that enumerations during initialization and swapchain creation, and
+ * set layout creation, use for their temporary arrays. Those functions take a scope and
+ * end it before returning. The arena is thread local: every thread that calls them sets
+ * its own, and an arena is only set on one thread at a time.
+ *
+ * @param[in] arena The arena
+ */
+void
+vut_set_scratch_arena(Arena* arena);
+
+/**
+ * @brief Get the arena the calling thread set with vut_set_scratch_arena
+ *
+ * @return Arena* The arena
+ */
+Arena*
+vut_get_scratch_arena(void);
+
 /**
  * @brief Create window and check support
  *
@@ -62,16 +115,81 @@ vut_get_physical_devices(VkInstance instance,
 VkResult
 vut_pick_physical_device(VkPhysicalDevice* gpus, uint32_t gpu_count, VkPhysicalDevice gpu[]);
 
+/**
+ * @brief Check if the GPU supports a device extension
+ *
+ * @param[in] gpu The physical device handle
+ * @param[in] extension_name Name of the extension, e.g. VK_KHR_SWAPCHAIN_EXTENSION_NAME
+ * @return true The extension is available
+ */
+bool
+vut_has_device_extension(VkPhysicalDevice gpu, const char extension_name[]);
+
+/**
+ * @brief Detect which optional features the GPU supports
+ *
+ * @param[in] gpu The physical device handle
+ * @param[out] features The supported features
+ */
+void
+vut_query_device_features(VkPhysicalDevice gpu, DeviceFeatures* features);
+
+/**
+ * @brief Get the descriptor limits that apply to update after bind sets
+ *
+ * @param[in] gpu The physical device handle
+ * @param[out] properties The descriptor indexing limits
+ */
+void
+vut_get_descriptor_indexing_properties(VkPhysicalDevice gpu,
+                                       VkPhysicalDeviceDescriptorIndexingProperties* properties);
+
+/**
+ * @brief Get the descriptor sizes and alignment of VK_EXT_descriptor_buffer
+ *
+ * @param[in] gpu The physical device handle
+ * @param[out] properties The descriptor buffer properties
+ */
+void
+vut_get_descriptor_buffer_properties(VkPhysicalDevice gpu,
+                                     VkPhysicalDeviceDescriptorBufferPropertiesEXT* properties);
+
 /**
  * @brief Initialize the Vulkan device
  *
  * @param[in] gpu The GPU the device is created for
  * @param[in] graphics_queue_family_index The queue for graphics presentation
+ * @param[in] compute_queue_family_index The family of the compute queue
+ * @param[in] compute_queue_index Index of the compute queue in its family, 0 when it is
+ * the graphics queue
+ * @param[in] features The optional features to enable, must be supported. Also loads
+ * the extension functions used by the vut_ wrappers, so only one device is supported
  * @param[out] device The created device
  * @return VkResult VK_SUCCESS if device is created succesfully
  */
 VkResult
-vut_init_device(VkPhysicalDevice gpu, uint32_t graphics_queue_family_index, VkDevice* device);
+vut_init_device(VkPhysicalDevice gpu,
+                uint32_t graphics_queue_family_index,
+                uint32_t compute_queue_family_index,
+                uint32_t compute_queue_index,
+                const DeviceFeatures* features,
+                VkDevice* device);
+
+/**
+ * @brief Find the queue compute work is submitted to. A family with compute but without
+ * graphics runs next to rasterization on most hardware, else a second queue of the
+ * graphics family is used, else compute shares the graphics queue.
+ *
+ * @param[in] gpu The handle for the vulkan physical device
+ * @param[in] graphics_queue_family_index The family of the graphics queue
+ * @param[out] compute_queue_family_index The family of the compute queue
+ * @param[out] compute_queue_index Index of the compute queue in its family
+ */
+void
+vut_get_compute_queue(VkPhysicalDevice gpu,
+                      uint32_t graphics_queue_family_index,
+                      uint32_t* compute_queue_family_index,
+                      uint32_t* compute_queue_index);
 
 /**
  * @brief Get the indices of the graphics and present queues
@@ -151,8 +269,9 @@ vut_get_surface_format(VkPhysicalDevice gpu,
  * @param[in] format The chosen surface format
  * @param[in] present_mode The chosen present mode
  * @param[in] color_space The chosen color space
- * @param[in, out] swapchain Old swapchain will be destroyed. Points to newly created swapchain
- * @return VkResult The result of vkCreateSwapchainKHR or vkDestroySwapchainKHR
+ * @param[in, out] swapchain Old swapchain is retired but not destroyed, the caller destroys
+ * it once no frame uses it. Points to newly created swapchain
+ * @return VkResult The result of vkCreateSwapchainKHR
  */
 VkResult
 vut_init_swapchain(VkPhysicalDevice gpu,
@@ -196,30 +315,71 @@ vut_init_image_view(VkDevice device,
  * @brief Initialize a shader for Vulkan
  *
  * @param[in] device Device handle
- * @param[in] shader_name Path + name of the shader
+ * @param[in] code The SPIR-V words of the shader, see shaders.h
+ * @param[in] size The size of the code in bytes
  * @param[out] shader_module The created module
  * @return VkResult The return of vkCreateShaderModule
  */
 VkResult
-vut_init_shader_module(VkDevice device, char* shader_name, VkShaderModule* shader_module);
+vut_init_shader_module(VkDevice device,
+                       const uint32_t code[],
+                       size_t size,
+                       VkShaderModule* shader_module);
+
+/**
+ * @brief Initialize a descriptor set layout
+ *
+ * @param[in] device The vulkan device handle
+ * @param[in] binding_count The amount of bindings
+ * @param[in] bindings The bindings in the set
+ * @param[in] flags With VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT the
+ * bindings may be written while the set is bound and need not all be valid
+ * @param[out] descriptor_layout The created descriptor set layout
+ * @return VkResult
+ */
+VkResult
+vut_init_descriptor_set_layout(VkDevice device,
+                               uint32_t binding_count,
+                               const VkDescriptorSetLayoutBinding bindings[],
+                               VkDescriptorSetLayoutCreateFlags flags,
+                               VkDescriptorSetLayout* descriptor_layout);
 
 /**
  * @brief Initialize the layout for the grpahics pipeline
  *
  * @param[in] device The vulkan device handle
- * @param[in] descriptor_layout Layout of the descriptor set
+ * @param[in] set_layout_count The amount of descriptor set layouts
+ * @param[in] set_layouts Layouts of the descriptor sets
+ * @param[in] push_constant_range_count The amount of push constant ranges
+ * @param[in] push_constant_ranges The push constant ranges
  * @param[out] pipeline_layout The created pipeline layout
  * @return VkResult
  */
 VkResult
 vut_init_pipeline_layout(VkDevice device,
-                         VkDescriptorSetLayout* descriptor_layout,
+                         uint32_t set_layout_count,
+                         const VkDescriptorSetLayout set_layouts[],
+                         uint32_t push_constant_range_count,
+                         const VkPushConstantRange push_constant_ranges[],
                          VkPipelineLayout* pipeline_layout);
 
+/**
+ * @brief Create an empty pipeline cache. Pipeline caches are internally synchronized so
+ * one cache can be shared by threads compiling pipelines concurrently.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[out] pipeline_cache The created pipeline cache
+ * @return VkResult
+ */
+VkResult
+vut_init_pipeline_cache(VkDevice device, VkPipelineCache* pipeline_cache);
+
 /**
  * @brief Create the pipeline
  *
  * @param[in] device
+ * @param[in] pipeline_cache The cache to use, may be VK_NULL_HANDLE
+ * @param[in] flags VkPipelineCreateFlags of the pipeline
  * @param[in] stages
  * @param[in] vertex_input
  * @param[in] input_assembly
@@ -227,13 +387,17 @@ vut_init_pipeline_layout(VkDevice device,
  * @param[in] rasterizer
  * @param[in] multisampling
  * @param[in] color_blending
+ * @param[in] dynamic_state The state that is set while recording, may be NULL
  * @param[in] pipeline_layout
- * @param[in] render_pass
+ * @param[in] render_pass The render pass, VK_NULL_HANDLE with dynamic rendering
+ * @param[in] rendering The attachment formats for dynamic rendering, NULL with a render pass
  * @param[out] pipeline
  * @return VkResult
  */
 VkResult
 vut_init_pipeline(VkDevice device,
+                  VkPipelineCache pipeline_cache,
+                  VkPipelineCreateFlags flags,
                   const VkPipelineShaderStageCreateInfo stages[],
                   const VkPipelineVertexInputStateCreateInfo* vertex_input,
                   const VkPipelineInputAssemblyStateCreateInfo* input_assembly,
@@ -241,10 +405,73 @@ vut_init_pipeline(VkDevice device,
                   const VkPipelineRasterizationStateCreateInfo* rasterizer,
                   const VkPipelineMultisampleStateCreateInfo* multisampling,
                   const VkPipelineColorBlendStateCreateInfo* color_blending,
+                  const VkPipelineDynamicStateCreateInfo* dynamic_state,
                   VkPipelineLayout pipeline_layout,
                   VkRenderPass render_pass,
+                  const VkPipelineRenderingCreateInfoKHR* rendering,
                   VkPipeline* pipeline);
 
+/**
+ * @brief Create one part of a pipeline with VK_EXT_graphics_pipeline_library. Only the
+ * state belonging to the parts is read from the create info. The link time optimization
+ * info is retained so the library can be used in an optimized link as well.
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] pipeline_cache The cache to use, may be VK_NULL_HANDLE
+ * @param[in] parts The VK_GRAPHICS_PIPELINE_LIBRARY_*_BIT_EXT parts in the library
+ * @param[in] create_info The pipeline state
+ * @param[out] library The created library
+ * @return VkResult
+ */
+VkResult
+vut_init_pipeline_library(VkDevice device,
+                          VkPipelineCache pipeline_cache,
+                          VkGraphicsPipelineLibraryFlagsEXT parts,
+                          const VkGraphicsPipelineCreateInfo* create_info,
+                          VkPipeline* library);
+
+/**
+ * @brief Link pipeline libraries into a complete pipeline
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] pipeline_cache The cache to use, may be VK_NULL_HANDLE
+ * @param[in] library_count Amount of libraries
+ * @param[in] libraries Libraries that together contain all parts of a pipeline
+ * @param[in] pipeline_layout The layout of the complete pipeline
+ * @param[in] flags VkPipelineCreateFlags the libraries were created with
+ * @param[in] optimize Run link time optimization. Slower to link, faster to execute
+ * @param[out] pipeline The linked pipeline
+ * @return VkResult
+ */
+VkResult
+vut_link_pipeline(VkDevice device,
+                  VkPipelineCache pipeline_cache,
+                  uint32_t library_count,
+                  const VkPipeline libraries[],
+                  VkPipelineLayout pipeline_layout,
+                  VkPipelineCreateFlags flags,
+                  bool optimize,
+                  VkPipeline* pipeline);
+
+/**
+ * @brief Create a compute pipeline
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] pipeline_cache The cache to use, may be VK_NULL_HANDLE
+ * @param[in] flags VkPipelineCreateFlags of the pipeline
+ * @param[in] stage The compute shader stage
+ * @param[in] pipeline_layout The pipeline layout
+ * @param[out] pipeline The created pipeline
+ * @return VkResult
+ */
+VkResult
+vut_init_compute_pipeline(VkDevice device,
+                          VkPipelineCache pipeline_cache,
+                          VkPipelineCreateFlags flags,
+                          const VkPipelineShaderStageCreateInfo* stage,
+                          VkPipelineLayout pipeline_layout,
+                          VkPipeline* pipeline);
+
 /**
  * @brief Create the render pass
  *
@@ -273,6 +500,218 @@ vut_prepare_framebuffer(VkDevice device,
                         VkExtent2D window_extent,
                         VkFramebuffer* framebuffer);
 
+/**
+ * @brief Find a memory type that is allowed for a resource and has the properties
+ *
+ * @param[in] gpu The physical device handle
+ * @param[in] type_bits Allowed memory types from VkMemoryRequirements
+ * @param[in] properties Required memory properties
+ * @return uint32_t The memory type index, UINT32_MAX if there is none
+ */
+uint32_t
+vut_find_memory_type(VkPhysicalDevice gpu, uint32_t type_bits, VkMemoryPropertyFlags properties);
+
+/**
+ * @brief Count device memory allocated by the vut_ functions against a budget
+ *
+ * @param[in] budget The budget, NULL to stop counting
+ */
+void
+vut_set_memory_budget(MemoryBudget* budget);
+
+/**
+ * @brief Allocate device memory and count it against the budget set with
+ * vut_set_memory_budget
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] alloc_info Size and memory type of the allocation
+ * @param[out] memory The allocated memory
+ * @return VkResult VK_ERROR_OUT_OF_HOST_MEMORY when the budget can not track the memory
+ */
+VkResult
+vut_allocate_memory(VkDevice device,
+                    const VkMemoryAllocateInfo* alloc_info,
+                    VkDeviceMemory* memory);
+
+/**
+ * @brief Free device memory allocated with vut_allocate_memory or vut_init_buffer
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] memory The memory, may be VK_NULL_HANDLE
+ */
+void
+vut_free_memory(VkDevice device, VkDeviceMemory memory);
+
+/**
+ * @brief Create a buffer with its own dedicated memory
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] gpu The physical device handle
+ * @param[in] size Size of the buffer in bytes
+ * @param[in] usage How the buffer is used
+ * @param[in] properties Required memory properties
+ * @param[out] buffer The created buffer
+ * @param[out] memory The memory bound to the buffer
+ * @return VkResult
+ */
+VkResult
+vut_init_buffer(VkDevice device,
+                VkPhysicalDevice gpu,
+                VkDeviceSize size,
+                VkBufferUsageFlags usage,
+                VkMemoryPropertyFlags properties,
+                VkBuffer* buffer,
+                VkDeviceMemory* memory);
+
+/**
+ * @brief Create a descriptor pool
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] flags VkDescriptorPoolCreateFlags of the pool
+ * @param[in] max_sets Maximum amount of sets allocated from the pool
+ * @param[in] pool_size_count Amount of pool sizes
+ * @param[in] pool_sizes Amount of descriptors per type
+ * @param[out] descriptor_pool The created pool
+ * @return VkResult
+ */
+VkResult
+vut_init_descriptor_pool(VkDevice device,
+                         VkDescriptorPoolCreateFlags flags,
+                         uint32_t max_sets,
+                         uint32_t pool_size_count,
+                         const VkDescriptorPoolSize pool_sizes[],
+                         VkDescriptorPool* descriptor_pool);
+
+/**
+ * @brief Allocate a descriptor set
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] descriptor_pool The pool to allocate from
+ * @param[in] layout The layout of the set
+ * @param[out] descriptor_set The allocated set
+ * @return VkResult
+ */
+VkResult
+vut_alloc_descriptor_set(VkDevice device,
+                         VkDescriptorPool descriptor_pool,
+                         VkDescriptorSetLayout layout,
+                         VkDescriptorSet* descriptor_set);
+
+/**
+ * @brief Point a buffer binding of a descriptor set to a buffer
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] descriptor_set The set to update
+ * @param[in] binding The binding in the set
+ * @param[in] type The descriptor type of the binding
+ * @param[in] buffer The buffer
+ * @param[in] range Size of the visible range, from the start of the buffer
+ */
+void
+vut_write_buffer_descriptor(VkDevice device,
+                            VkDescriptorSet descriptor_set,
+                            uint32_t binding,
+                            VkDescriptorType type,
+                            VkBuffer buffer,
+                            VkDeviceSize range);
+
+/**
+ * @brief Point an image binding of a descriptor set to an image view
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] descriptor_set The set to update
+ * @param[in] binding The binding in the set
+ * @param[in] type The descriptor type of the binding, like VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+ * @param[in] view The image view
+ * @param[in] layout The layout of the image when the set is used, VK_IMAGE_LAYOUT_GENERAL
+ * for storage images
+ */
+void
+vut_write_image_descriptor(VkDevice device,
+                           VkDescriptorSet descriptor_set,
+                           uint32_t binding,
+                           VkDescriptorType type,
+                           VkImageView view,
+                           VkImageLayout layout);
+
+/**
+ * @brief Get the device address of a buffer created with
+ * VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] buffer The buffer
+ * @return VkDeviceAddress
+ */
+VkDeviceAddress
+vut_get_buffer_address(VkDevice device, VkBuffer buffer);
+
+/**
+ * @brief Get the size a set with a layout takes up in a descriptor buffer
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] layout A layout created with VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+ * @return VkDeviceSize
+ */
+VkDeviceSize
+vut_get_descriptor_set_layout_size(VkDevice device, VkDescriptorSetLayout layout);
+
+/**
+ * @brief Get the offset of a binding from the start of a set in a descriptor buffer
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] layout The layout of the set
+ * @param[in] binding The binding
+ * @return VkDeviceSize
+ */
+VkDeviceSize
+vut_get_descriptor_binding_offset(VkDevice device, VkDescriptorSetLayout layout, uint32_t binding);
+
+/**
+ * @brief Write the data of a descriptor to memory, usually a mapped descriptor buffer
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] info The type and resource of the descriptor
+ * @param[in] size The descriptor size of the type from the descriptor buffer properties
+ * @param[out] descriptor Where the descriptor is written
+ */
+void
+vut_get_descriptor(VkDevice device,
+                   const VkDescriptorGetInfoEXT* info,
+                   size_t size,
+                   void* descriptor);
+
+/**
+ * @brief Bind descriptor buffers, replacing all previously bound descriptor buffers
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] count Amount of descriptor buffers
+ * @param[in] bindings The address and usage of every buffer
+ */
+void
+vut_bind_descriptor_buffers(VkCommandBuffer buffer,
+                            uint32_t count,
+                            const VkDescriptorBufferBindingInfoEXT bindings[]);
+
+/**
+ * @brief Point descriptor sets at offsets in the bound descriptor buffers
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] bind_point Graphics or compute
+ * @param[in] layout The pipeline layout
+ * @param[in] first_set The first set to point
+ * @param[in] count Amount of sets
+ * @param[in] buffer_indices Index of the bound descriptor buffer of every set
+ * @param[in] offsets Offset of every set in its descriptor buffer
+ */
+void
+vut_set_descriptor_buffer_offsets(VkCommandBuffer buffer,
+                                  VkPipelineBindPoint bind_point,
+                                  VkPipelineLayout layout,
+                                  uint32_t first_set,
+                                  uint32_t count,
+                                  const uint32_t buffer_indices[],
+                                  const VkDeviceSize offsets[]);
+
 /**
  * @brief Create a semaphore for synchronisation on the gpu
  *
@@ -287,22 +726,27 @@ vut_init_semaphore(VkDevice device, VkSemaphore* semaphore);
  * @brief Create a new fence for synchronisation
  *
  * @param[in] device The Vulkan device handle
+ * @param[in] flags VK_FENCE_CREATE_SIGNALED_BIT to start in the signaled state
  * @param[out] fence The created fence
  * @return VkResult
  */
 VkResult
-vut_init_fence(VkDevice device, VkFence* fence);
+vut_init_fence(VkDevice device, VkFenceCreateFlags flags, VkFence* fence);
 
 /**
  * @brief Create a new command pool
  *
  * @param[in] device The Vulkan device handle
  * @param[in] family_index One command pool can only apply to one queue
+ * @param[in] flags Creation flags, e.g. VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
  * @param[out] command_pool The created command pool
  * @return VkResult
  */
 VkResult
-vut_init_command_pool(VkDevice device, uint32_t family_index, VkCommandPool* command_pool);
+vut_init_command_pool(VkDevice device,
+                      uint32_t family_index,
+                      VkCommandPoolCreateFlags flags,
+                      VkCommandPool* command_pool);
 
 /**
  * @brief Allocate the command buffer
@@ -319,6 +763,23 @@ vut_alloc_command_buffer(VkDevice device,
                          uint32_t count,
                          VkCommandBuffer* command_buffer);
 
+/**
+ * @brief Allocate secondary command buffers, which are recorded once and executed from
+ * primary command buffers inside a render pass
+ *
+ * @param[in] device The Vulkan device handle
+ * @param[in] command_pool Pool created with VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+ * when the buffers are recorded one at a time
+ * @param[in] count Amount of command buffers
+ * @param[out] command_buffers The allocated command buffers
+ * @return VkResult
+ */
+VkResult
+vut_alloc_secondary_command_buffers(VkDevice device,
+                                    VkCommandPool command_pool,
+                                    uint32_t count,
+                                    VkCommandBuffer command_buffers[]);
+
 /**
  * @brief Start recording with the command buffer
  *
@@ -328,6 +789,22 @@ vut_alloc_command_buffer(VkDevice device,
 VkResult
 vut_begin_command_buffer(VkCommandBuffer command_buffer);
 
+/**
+ * @brief Start recording a secondary command buffer that continues a render pass, or
+ * dynamic rendering to a single color attachment when there is no render pass. It can be
+ * executed again as long as it is not in flight twice.
+ *
+ * @param[in] command_buffer The secondary command buffer
+ * @param[in] render_pass The render pass it is executed in, VK_NULL_HANDLE for dynamic
+ * rendering
+ * @param[in] color_format Format of the color attachment with dynamic rendering
+ * @return VkResult
+ */
+VkResult
+vut_begin_secondary_command_buffer(VkCommandBuffer command_buffer,
+                                   VkRenderPass render_pass,
+                                   VkFormat color_format);
+
 /**
  * @brief Start the render pass
  *
@@ -335,12 +812,113 @@ vut_begin_command_buffer(VkCommandBuffer command_buffer);
  * @param[in] render_pass The render pass handle
  * @param[in] framebuffer The framebuffer where the drawing will happen
  * @param[in] extent The extent of the swapchain
+ * @param[in] contents Whether the draws are recorded inline or in secondary command buffers
  * @return VkResult
  */
 VkResult
 vut_begin_render_pass(VkCommandBuffer buffer,
                       VkRenderPass render_pass,
                       VkFramebuffer framebuffer,
-                      VkExtent2D extent);
+                      VkExtent2D extent,
+                      VkSubpassContents contents);
+
+/**
+ * @brief Start rendering to a single color attachment with VK_KHR_dynamic_rendering,
+ * which needs no render pass or framebuffer. The image must be in
+ * VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL.
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] image_view The image view that is drawn to, cleared first
+ * @param[in] extent The extent of the image
+ * @param[in] contents Whether the draws are recorded inline or in secondary command buffers
+ */
+void
+vut_begin_rendering(VkCommandBuffer buffer,
+                    VkImageView image_view,
+                    VkExtent2D extent,
+                    VkSubpassContents contents);
+
+/**
+ * @brief End rendering started with vut_begin_rendering
+ *
+ * @param[in] buffer The command buffer to record to
+ */
+void
+vut_end_rendering(VkCommandBuffer buffer);
+
+/**
+ * @brief Get the aspects of an image in a format, depth and stencil formats have both
+ *
+ * @param[in] format The format of the image
+ * @return VkImageAspectFlags The aspects
+ */
+VkImageAspectFlags
+vut_get_format_aspect(VkFormat format);
+
+/**
+ * @brief Record a layout transition of an image
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] image The image to transition
+ * @param[in] aspect Every aspect of the image, see vut_get_format_aspect
+ * @param[in] old_layout The current layout, VK_IMAGE_LAYOUT_UNDEFINED discards the contents
+ * @param[in] new_layout The layout after the barrier
+ * @param[in] src_stage The stages that must finish before the transition
+ * @param[in] src_access The writes that must be available
+ * @param[in] dst_stage The stages that wait on the transition
+ * @param[in] dst_access The accesses that wait on the transition
+ */
+void
+vut_transition_image(VkCommandBuffer buffer,
+                     VkImage image,
+                     VkImageAspectFlags aspect,
+                     VkImageLayout old_layout,
+                     VkImageLayout new_layout,
+                     VkPipelineStageFlags src_stage,
+                     VkAccessFlags src_access,
+                     VkPipelineStageFlags dst_stage,
+                     VkAccessFlags dst_access);
+
+/**
+ * @brief Record a global memory barrier, like between a dispatch that writes a buffer and
+ * the host or a later stage reading it
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] src_stage The stages that must finish before the barrier
+ * @param[in] src_access The writes that must be available
+ * @param[in] dst_stage The stages that wait on the barrier
+ * @param[in] dst_access The accesses that wait on the barrier
+ */
+void
+vut_memory_barrier(VkCommandBuffer buffer,
+                   VkPipelineStageFlags src_stage,
+                   VkAccessFlags src_access,
+                   VkPipelineStageFlags dst_stage,
+                   VkAccessFlags dst_access);
+
+/**
+ * @brief Record a dispatch of the bound compute pipeline
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] group_count_x Amount of workgroups in x
+ * @param[in] group_count_y Amount of workgroups in y
+ * @param[in] group_count_z Amount of workgroups in z
+ */
+void
+vut_dispatch(VkCommandBuffer buffer,
+             uint32_t group_count_x,
+             uint32_t group_count_y,
+             uint32_t group_count_z);
+
+/**
+ * @brief Record a dispatch whose workgroup counts are read from a buffer, so a previous
+ * dispatch can decide how much work follows
+ *
+ * @param[in] buffer The command buffer to record to
+ * @param[in] indirect_buffer Buffer created with VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+ * @param[in] offset Offset of a VkDispatchIndirectCommand in the buffer, a multiple of 4
+ */
+void
+vut_dispatch_indirect(VkCommandBuffer buffer, VkBuffer indirect_buffer, VkDeviceSize offset);
 
 #endif // HELPER_H
\ No newline at end of file
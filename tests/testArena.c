@@ -0,0 +1,64 @@
+/**
+ * @file testArena.c
+ * @brief Tests of the linear arena allocator
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "arena.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static void
+test_arena(void)
+{
+    Arena arena;
+    vut_arena_init(1024, &arena);
+    assert(arena.head == 0);
+
+    uint8_t* byte = vut_arena_alloc(&arena, 3, 1);
+    double* number = VUT_ARENA_ALLOC(&arena, double, 4);
+    assert((uintptr_t)number % _Alignof(double) == 0);
+    assert((uint8_t*)number >= byte + 3);
+
+    void* line = vut_arena_alloc(&arena, 10, 64);
+    assert((uintptr_t)line % 64 == 0);
+    size_t head = arena.head;
+
+    // A scope frees only what was allocated inside it
+    ArenaScope scope = vut_arena_begin_scope(&arena);
+    uint32_t* inner = VUT_ARENA_ALLOC(&arena, uint32_t, 100);
+    assert((uint8_t*)inner >= (uint8_t*)line + 10);
+    size_t peak = arena.head;
+    vut_arena_end_scope(scope);
+    assert(arena.head == head);
+    assert(arena.peak == peak);
+
+    // The memory is reused
+    assert(VUT_ARENA_ALLOC(&arena, uint32_t, 100) == inner);
+
+    vut_arena_reset(&arena);
+    assert(arena.head == 0);
+    assert(arena.peak == peak);
+    assert(vut_arena_alloc(&arena, 1, 1) == byte);
+
+    // The whole capacity is usable
+    vut_arena_reset(&arena);
+    vut_arena_alloc(&arena, 1024, 1);
+    assert(arena.head == 1024);
+
+    vut_arena_destroy(&arena);
+}
+
+int
+main(void)
+{
+    test_arena();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/**
+ * @file testCapture.c
+ * @brief Tests of the frame capture, decoding the PNG files it writes
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "capture.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Wide enough that the image data needs more than one stored deflate block
+#define CAPTURE_WIDTH 200
+#define CAPTURE_HEIGHT 120
+
+static uint32_t
+read_u32_be(const uint8_t* data)
+{
+    return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+static uint32_t
+png_crc(const uint8_t* data, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        }
+    }
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static uint8_t
+capture_texel(uint32_t x, uint32_t y, uint32_t channel)
+{
+    return (uint8_t)(x * 3 + y * 7 + channel * 50);
+}
+
+// Checks the chunks and returns the inflated image data
+static uint8_t*
+png_inflate_stored(const uint8_t* file, size_t size, size_t* raw_size)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    assert(size > sizeof(signature));
+    assert(memcmp(file, signature, sizeof(signature)) == 0);
+
+    const uint8_t* idat = NULL;
+    uint32_t idat_size = 0;
+    bool ended = false;
+    for (size_t offset = sizeof(signature); offset < size;) {
+        assert(!ended);
+        assert(offset + 12 <= size);
+        uint32_t length = read_u32_be(file + offset);
+        const uint8_t* type = file + offset + 4;
+        const uint8_t* data = type + 4;
+        assert(offset + 12 + length <= size);
+        assert(read_u32_be(data + length) == png_crc(type, length + 4));
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            assert(offset == sizeof(signature));
+            assert(length == 13);
+            assert(read_u32_be(data) == CAPTURE_WIDTH);
+            assert(read_u32_be(data + 4) == CAPTURE_HEIGHT);
+            // 8 bit RGB, deflate, adaptive filtering, no interlace
+            assert(data[8] == 8 && data[9] == 2);
+            assert(data[10] == 0 && data[11] == 0 && data[12] == 0);
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            idat = data;
+            idat_size = length;
+        } else {
+            assert(memcmp(type, "IEND", 4) == 0);
+            assert(length == 0);
+            ended = true;
+        }
+        offset += 12 + length;
+    }
+    assert(ended);
+    assert(idat != NULL);
+
+    // zlib header, stored blocks and the Adler-32 of the inflated data
+    assert(idat_size >= 6);
+    assert(idat[0] == 0x78 && ((idat[0] << 8) | idat[1]) % 31 == 0);
+
+    uint8_t* raw = malloc(idat_size);
+    size_t raw_offset = 0;
+    size_t offset = 2;
+    uint32_t block_count = 0;
+    bool final = false;
+    while (!final) {
+        assert(offset + 5 <= idat_size - 4);
+        final = idat[offset] & 1;
+        // Stored block
+        assert((idat[offset] >> 1) == 0);
+        uint16_t length = idat[offset + 1] | idat[offset + 2] << 8;
+        uint16_t inverse = idat[offset + 3] | idat[offset + 4] << 8;
+        assert(length + inverse == 0xFFFF);
+        offset += 5;
+        assert(offset + length <= idat_size - 4);
+        memcpy(raw + raw_offset, idat + offset, length);
+        raw_offset += length;
+        offset += length;
+        block_count++;
+    }
+    assert(offset + 4 == idat_size);
+    assert(block_count > 1);
+
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw_offset; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    assert(read_u32_be(idat + offset) == ((b << 16) | a));
+
+    *raw_size = raw_offset;
+    return raw;
+}
+
+// B8G8R8A8 texels, the file is RGB
+static void
+fill_slot(CaptureSlot* slot)
+{
+    for (uint32_t y = 0; y < CAPTURE_HEIGHT; y++) {
+        for (uint32_t x = 0; x < CAPTURE_WIDTH; x++) {
+            uint8_t* texel = slot->pixels + ((size_t)y * CAPTURE_WIDTH + x) * 4;
+            texel[0] = capture_texel(x, y, 2);
+            texel[1] = capture_texel(x, y, 1);
+            texel[2] = capture_texel(x, y, 0);
+            texel[3] = 255;
+        }
+    }
+}
+
+static void
+check_file(const char prefix[], uint32_t frame)
+{
+    char path[VUR_MAX_CAPTURE_PATH + 16];
+    snprintf(path, sizeof(path), "%s%06u.png", prefix, frame);
+    FILE* file = fopen(path, "rb");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = malloc(size);
+    assert(fread(data, 1, size, file) == size);
+    fclose(file);
+
+    size_t raw_size = 0;
+    uint8_t* raw = png_inflate_stored(data, size, &raw_size);
+    assert(raw_size == CAPTURE_HEIGHT * (1 + CAPTURE_WIDTH * 3));
+
+    for (uint32_t y = 0; y < CAPTURE_HEIGHT; y++) {
+        const uint8_t* row = raw + (size_t)y * (1 + CAPTURE_WIDTH * 3);
+        // No filter
+        assert(row[0] == 0);
+        for (uint32_t x = 0; x < CAPTURE_WIDTH; x++) {
+            for (uint32_t channel = 0; channel < 3; channel++) {
+                assert(row[1 + x * 3 + channel] == capture_texel(x, y, channel));
+            }
+        }
+    }
+
+    free(raw);
+    free(data);
+    remove(path);
+}
+
+static void
+test_capture_png(void)
+{
+    char directory[] = "/tmp/testVuR_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char prefix[VUR_MAX_CAPTURE_PATH];
+    snprintf(prefix, sizeof(prefix), "%s/frame", directory);
+
+    // A single slot, so every frame waits for the one before it
+    FrameCapture* capture = malloc(sizeof(FrameCapture));
+    assert(vur_capture_init(prefix, VUR_CAPTURE_PNG, true, 1, 1, capture));
+
+    CaptureSlot* slot = vur_capture_acquire(capture, CAPTURE_WIDTH, CAPTURE_HEIGHT);
+    assert(slot != NULL);
+    // The slot is still being read, no worker could free it
+    assert(vur_capture_acquire(capture, CAPTURE_WIDTH, CAPTURE_HEIGHT) == NULL);
+    fill_slot(slot);
+    vur_capture_submit(capture, slot);
+
+    // Waits for the worker to write the first frame, no frame number is skipped
+    slot = vur_capture_acquire(capture, CAPTURE_WIDTH, CAPTURE_HEIGHT);
+    assert(slot != NULL);
+    assert(slot->frame == 1);
+    fill_slot(slot);
+    vur_capture_submit(capture, slot);
+
+    // Writes the queued frame before the workers stop
+    vur_capture_destroy(capture);
+    free(capture);
+
+    check_file(prefix, 0);
+    check_file(prefix, 1);
+    rmdir(directory);
+}
+
+int
+main(void)
+{
+    test_capture_png();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file testDrawSort.c
+ * @brief Tests of the draw sort keys and the radix sort
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "draw_sort.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SORT_COUNT 10000
+
+static int
+compare_u64(const void* a, const void* b)
+{
+    uint64_t left = *(const uint64_t*)a;
+    uint64_t right = *(const uint64_t*)b;
+    return (left > right) - (left < right);
+}
+
+static void
+test_draw_sort(void)
+{
+    // Opaque first, then by pipeline, material, mesh and front to back
+    uint64_t opaque = vur_draw_key(VUR_PASS_OPAQUE, 5, 5, 5, 10.0f);
+    assert(opaque < vur_draw_key(VUR_PASS_TRANSPARENT, 0, 0, 0, 0.0f));
+    assert(opaque < vur_draw_key(VUR_PASS_OPAQUE, 6, 0, 0, 0.0f));
+    assert(opaque < vur_draw_key(VUR_PASS_OPAQUE, 5, 6, 0, 0.0f));
+    assert(opaque < vur_draw_key(VUR_PASS_OPAQUE, 5, 5, 6, 0.0f));
+    assert(opaque < vur_draw_key(VUR_PASS_OPAQUE, 5, 5, 5, 20.0f));
+    assert(opaque > vur_draw_key(VUR_PASS_OPAQUE, 5, 5, 5, 5.0f));
+
+    // Transparent back to front before the state
+    uint64_t transparent = vur_draw_key(VUR_PASS_TRANSPARENT, 5, 5, 5, 10.0f);
+    assert(transparent < vur_draw_key(VUR_PASS_TRANSPARENT, 0, 0, 0, 5.0f));
+    assert(transparent > vur_draw_key(VUR_PASS_TRANSPARENT, 9, 9, 9, 20.0f));
+    assert(transparent < vur_draw_key(VUR_PASS_TRANSPARENT, 6, 0, 0, 10.0f));
+
+    // Negative depths count as 0, fields are truncated to their bits
+    assert(vur_draw_key(VUR_PASS_OPAQUE, 1, 2, 3, -4.0f) ==
+           vur_draw_key(VUR_PASS_OPAQUE, 1, 2, 3, 0.0f));
+    assert(vur_draw_key(VUR_PASS_OPAQUE, 1u << VUR_DRAW_KEY_PIPELINE_BITS, 0, 0, 0.0f) ==
+           vur_draw_key(VUR_PASS_OPAQUE, 0, 0, 0, 0.0f));
+    assert(vur_draw_key(VUR_PASS_OPAQUE, 0, 0, (1u << VUR_DRAW_KEY_MESH_BITS) + 7, 0.0f) ==
+           vur_draw_key(VUR_PASS_OPAQUE, 0, 0, 7, 0.0f));
+    assert(VUR_DRAW_KEY_PASS_BITS + VUR_DRAW_KEY_PIPELINE_BITS + VUR_DRAW_KEY_MATERIAL_BITS +
+               VUR_DRAW_KEY_MESH_BITS + VUR_DRAW_KEY_DEPTH_BITS <=
+           64);
+
+    uint64_t* keys = malloc(2 * SORT_COUNT * sizeof(uint64_t));
+    uint64_t* expected = malloc(SORT_COUNT * sizeof(uint64_t));
+    uint32_t* values = malloc(2 * SORT_COUNT * sizeof(uint32_t));
+
+    // Nothing to sort
+    vut_radix_sort(keys, values, 0, keys + SORT_COUNT, values + SORT_COUNT);
+    keys[0] = 42;
+    values[0] = 7;
+    vut_radix_sort(keys, values, 1, keys + SORT_COUNT, values + SORT_COUNT);
+    assert(keys[0] == 42 && values[0] == 7);
+
+    // Full width keys with few distinct values, so equal keys show whether the sort is stable
+    srand(1);
+    for (uint32_t i = 0; i < SORT_COUNT; i++) {
+        uint64_t key = (uint64_t)(rand() % 64);
+        keys[i] = (key << 58) | (key << 29) | key;
+        expected[i] = keys[i];
+        values[i] = i;
+    }
+    vut_radix_sort(keys, values, SORT_COUNT, keys + SORT_COUNT, values + SORT_COUNT);
+    qsort(expected, SORT_COUNT, sizeof(uint64_t), compare_u64);
+
+    assert(memcmp(keys, expected, SORT_COUNT * sizeof(uint64_t)) == 0);
+    for (uint32_t i = 1; i < SORT_COUNT; i++) {
+        if (keys[i - 1] == keys[i]) {
+            assert(values[i - 1] < values[i]);
+        }
+    }
+
+    // Keys that only differ in one byte skip the other passes and still end up in keys
+    for (uint32_t i = 0; i < SORT_COUNT; i++) {
+        keys[i] = 0xAB00000000000000ull | ((uint64_t)(SORT_COUNT - i) << 8 & 0xFF00);
+        values[i] = i;
+    }
+    vut_radix_sort(keys, values, SORT_COUNT, keys + SORT_COUNT, values + SORT_COUNT);
+    for (uint32_t i = 1; i < SORT_COUNT; i++) {
+        assert(keys[i - 1] <= keys[i]);
+        assert((keys[i] & 0xFF00000000000000ull) == 0xAB00000000000000ull);
+    }
+
+    free(values);
+    free(expected);
+    free(keys);
+}
+
+int
+main(void)
+{
+    test_draw_sort();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file testHostAllocator.c
+ * @brief Tests of the pooled VkAllocationCallbacks
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "host_allocator.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_ALLOCATION_COUNT 100
+
+static void
+test_host_allocator(void)
+{
+    HostAllocator* allocator = malloc(sizeof(HostAllocator));
+    vut_host_allocator_init(allocator);
+    const VkAllocationCallbacks* callbacks = &allocator->callbacks;
+    void* user_data = callbacks->pUserData;
+
+    static const VkSystemAllocationScope scopes[] = {
+        VK_SYSTEM_ALLOCATION_SCOPE_OBJECT,
+        VK_SYSTEM_ALLOCATION_SCOPE_COMMAND,
+    };
+    static const size_t sizes[] = { 1, 24, 100, 4096, 5000 };
+
+    for (uint32_t s = 0; s < sizeof(scopes) / sizeof(scopes[0]); s++) {
+        VkSystemAllocationScope scope = scopes[s];
+        void* memory[HOST_ALLOCATION_COUNT];
+        size_t total = 0;
+
+        // Every alignment from 1 to 128 is honoured, by the arena as well as the pools
+        for (uint32_t i = 0; i < HOST_ALLOCATION_COUNT; i++) {
+            size_t size = sizes[i % 5];
+            size_t alignment = (size_t)1 << (i % 8);
+            memory[i] = callbacks->pfnAllocation(user_data, size, alignment, scope);
+            assert(memory[i] != NULL);
+            assert((uintptr_t)memory[i] % alignment == 0);
+            memset(memory[i], (int)i, size);
+            total += size;
+        }
+
+        HostAllocationStats stats = vut_host_allocator_get_stats(allocator, scope);
+        assert(stats.bytes == total);
+        assert(stats.peak_bytes == total);
+        assert(stats.allocation_count == HOST_ALLOCATION_COUNT);
+
+        // Nothing overlaps
+        for (uint32_t i = 0; i < HOST_ALLOCATION_COUNT; i++) {
+            const uint8_t* bytes = memory[i];
+            for (size_t b = 0; b < sizes[i % 5]; b++) {
+                assert(bytes[b] == (uint8_t)i);
+            }
+        }
+
+        // Reallocation keeps the contents and the alignment
+        memory[0] = callbacks->pfnReallocation(user_data, memory[0], 8000, 64, scope);
+        assert(memory[0] != NULL);
+        assert((uintptr_t)memory[0] % 64 == 0);
+        assert(((uint8_t*)memory[0])[0] == 0);
+        total += 8000 - sizes[0];
+        assert(vut_host_allocator_get_stats(allocator, scope).bytes == total);
+
+        for (uint32_t i = 0; i < HOST_ALLOCATION_COUNT; i++) {
+            callbacks->pfnFree(user_data, memory[i]);
+        }
+        assert(vut_host_allocator_get_stats(allocator, scope).bytes == 0);
+
+        // The arena starts over, and stays aligned once it does
+        vut_host_allocator_begin_frame(allocator);
+    }
+    callbacks->pfnFree(user_data, NULL);
+
+    callbacks->pfnInternalAllocation(user_data, 256, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE,
+                                     VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+    assert(vut_host_allocator_get_stats(allocator, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE)
+               .internal_bytes == 256);
+    callbacks->pfnInternalFree(user_data, 256, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE,
+                               VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+    assert(vut_host_allocator_get_stats(allocator, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE)
+               .internal_bytes == 0);
+
+    vut_host_allocator_destroy(allocator);
+    free(allocator);
+}
+
+int
+main(void)
+{
+    test_host_allocator();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file testJobs.c
+ * @brief Tests of the work stealing job system
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "jobs.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define JOB_COUNT 1000
+#define CHILD_JOB_COUNT 10
+
+typedef struct
+{
+    JobSystem* jobs;
+    atomic_int* ran;
+    atomic_int* first_done;
+    atomic_int* early;
+} JobTest;
+
+static void
+job_count(void* data, uint32_t thread_index)
+{
+    JobTest* test = data;
+    assert(thread_index <= test->jobs->thread_count);
+    atomic_fetch_add(test->ran, 1);
+}
+
+// Waits on jobs of its own, the worker runs them while it waits
+static void
+job_spawn(void* data, uint32_t thread_index)
+{
+    JobTest* test = data;
+
+    JobDecl children[CHILD_JOB_COUNT];
+    for (uint32_t i = 0; i < CHILD_JOB_COUNT; i++) {
+        children[i] = (JobDecl){ .function = job_count, .data = test };
+    }
+
+    JobCounter counter = { 0 };
+    vut_jobs_run(test->jobs, children, CHILD_JOB_COUNT, &counter);
+    vut_jobs_wait(test->jobs, &counter);
+    assert(vut_jobs_done(&counter));
+}
+
+static void
+job_first(void* data, uint32_t thread_index)
+{
+    JobTest* test = data;
+    atomic_fetch_add(test->first_done, 1);
+}
+
+static void
+job_second(void* data, uint32_t thread_index)
+{
+    JobTest* test = data;
+    if (atomic_load(test->first_done) != JOB_COUNT) {
+        atomic_fetch_add(test->early, 1);
+    }
+}
+
+static void
+test_jobs(void)
+{
+    JobSystem* jobs = malloc(sizeof(JobSystem));
+    assert(vut_jobs_init(4, false, jobs));
+    assert(jobs->thread_count == 4);
+
+    atomic_int ran = 0;
+    atomic_int first_done = 0;
+    atomic_int early = 0;
+    JobTest test = {
+        .jobs = jobs,
+        .ran = &ran,
+        .first_done = &first_done,
+        .early = &early,
+    };
+
+    // More jobs than a deque holds spill to the shared queue
+    JobDecl* decls = malloc(VUT_JOB_DEQUE_SIZE * 2 * sizeof(JobDecl));
+    for (uint32_t i = 0; i < VUT_JOB_DEQUE_SIZE * 2; i++) {
+        decls[i] = (JobDecl){ .function = job_count, .data = &test };
+    }
+    JobCounter counter = { 0 };
+    vut_jobs_run(jobs, decls, VUT_JOB_DEQUE_SIZE * 2, &counter);
+    vut_jobs_wait(jobs, &counter);
+    assert(vut_jobs_done(&counter));
+    assert(atomic_load(&ran) == VUT_JOB_DEQUE_SIZE * 2);
+
+    // Nested waits
+    atomic_store(&ran, 0);
+    for (uint32_t i = 0; i < JOB_COUNT; i++) {
+        decls[i] = (JobDecl){ .function = job_spawn, .data = &test };
+    }
+    vut_jobs_run(jobs, decls, JOB_COUNT, &counter);
+    vut_jobs_wait(jobs, &counter);
+    assert(atomic_load(&ran) == JOB_COUNT * CHILD_JOB_COUNT);
+
+    // Dependencies, the second batch is queued before the first one can have finished
+    JobCounter first = { 0 };
+    JobCounter second = { 0 };
+    for (uint32_t i = 0; i < JOB_COUNT; i++) {
+        decls[i] = (JobDecl){ .function = job_first, .data = &test };
+        decls[JOB_COUNT + i] = (JobDecl){ .function = job_second, .data = &test };
+    }
+    vut_jobs_run(jobs, decls, JOB_COUNT, &first);
+    vut_jobs_run_after(jobs, &first, decls + JOB_COUNT, JOB_COUNT, &second);
+    vut_jobs_wait(jobs, &second);
+    vut_jobs_wait(jobs, &first);
+    assert(atomic_load(&first_done) == JOB_COUNT);
+    assert(atomic_load(&early) == 0);
+
+    // A dependency that is already done starts the jobs right away
+    vut_jobs_run_after(jobs, &first, decls + JOB_COUNT, JOB_COUNT, &second);
+    vut_jobs_wait(jobs, &second);
+    assert(atomic_load(&early) == 0);
+
+    free(decls);
+    vut_jobs_destroy(jobs);
+    free(jobs);
+}
+
+int
+main(void)
+{
+    test_jobs();
+
+    return EXIT_SUCCESS;
+}
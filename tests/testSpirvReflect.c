@@ -0,0 +1,230 @@
+/**
+ * @file testSpirvReflect.c
+ * @brief Tests of the SPIR-V reflection with a hand assembled shader
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "spirv_reflect.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPIRV_OP(opcode, length) ((uint32_t)(length) << 16 | (opcode))
+
+/*
+ * A vertex shader written by hand, like glslang would compile:
+ *
+ * layout(constant_id = 7) const uint COUNT = 8;
+ * layout(set = 1, binding = 3) uniform Camera { mat4 view; vec4 tint; };
+ * layout(set = 0, binding = 1) uniform sampler2D textures[4];
+ * layout(push_constant) uniform Push { vec4 color; };
+ * layout(location = 0) in vec3 position;
+ * layout(location = 1) in vec4 color;
+ *
+ * The id bound is below the values of the Location, Binding and DescriptorSet decorations,
+ * so literals that are mistaken for ids are rejected.
+ */
+static const uint32_t reflection_fixture[] = {
+    // Magic, version 1.0, generator, id bound, schema
+    0x07230203, 0x00010000, 0, 24, 0,
+    // OpCapability Shader
+    SPIRV_OP(17, 2), 1,
+    // OpMemoryModel Logical GLSL450
+    SPIRV_OP(14, 3), 0, 1,
+    // OpEntryPoint Vertex %1 "main" %15 %16
+    SPIRV_OP(15, 7), 0, 1, 0x6E69616D, 0, 15, 16,
+    // Decorations
+    SPIRV_OP(71, 4), 15, 30, 0,
+    SPIRV_OP(71, 4), 16, 30, 1,
+    SPIRV_OP(71, 3), 10, 2,
+    SPIRV_OP(72, 5), 10, 0, 35, 0,
+    SPIRV_OP(72, 5), 10, 0, 7, 16,
+    SPIRV_OP(72, 5), 10, 1, 35, 64,
+    SPIRV_OP(71, 4), 12, 34, 1,
+    SPIRV_OP(71, 4), 12, 33, 3,
+    SPIRV_OP(71, 4), 18, 34, 0,
+    SPIRV_OP(71, 4), 18, 33, 1,
+    SPIRV_OP(71, 4), 19, 1, 7,
+    SPIRV_OP(71, 3), 21, 2,
+    SPIRV_OP(72, 5), 21, 0, 35, 0,
+    // %2 float, %3 vec4, %4 vec3, %5 mat4, %6 uint
+    SPIRV_OP(22, 3), 2, 32,
+    SPIRV_OP(23, 4), 3, 2, 4,
+    SPIRV_OP(23, 4), 4, 2, 3,
+    SPIRV_OP(24, 4), 5, 3, 4,
+    SPIRV_OP(21, 4), 6, 32, 0,
+    // %7 uint 4, %19 spec constant uint 8
+    SPIRV_OP(43, 4), 6, 7, 4,
+    SPIRV_OP(50, 4), 6, 19, 8,
+    // %8 image 2D sampled, %9 sampled image, %17 array of 4
+    SPIRV_OP(25, 9), 8, 2, 1, 0, 0, 0, 1, 0,
+    SPIRV_OP(27, 3), 9, 8,
+    SPIRV_OP(28, 4), 17, 9, 7,
+    // %10 Camera, %21 Push
+    SPIRV_OP(30, 4), 10, 5, 3,
+    SPIRV_OP(30, 3), 21, 3,
+    // Pointers
+    SPIRV_OP(32, 4), 11, 2, 10,
+    SPIRV_OP(32, 4), 13, 1, 4,
+    SPIRV_OP(32, 4), 14, 1, 3,
+    SPIRV_OP(32, 4), 20, 0, 17,
+    SPIRV_OP(32, 4), 22, 9, 21,
+    // Variables
+    SPIRV_OP(59, 4), 11, 12, 2,
+    SPIRV_OP(59, 4), 13, 15, 1,
+    SPIRV_OP(59, 4), 14, 16, 1,
+    SPIRV_OP(59, 4), 20, 18, 0,
+    SPIRV_OP(59, 4), 22, 23, 9,
+};
+
+/*
+ * A fragment shader with a push constant block that starts past 0, as the second stage of
+ * a split range would declare it. The MatrixStride of the last member comes before the
+ * offsets, and its columns are padded from 12 to 16 bytes:
+ *
+ * layout(push_constant) uniform Push { layout(offset = 16) vec4 tint; mat3 normal; };
+ * layout(set = 0, binding = 0) uniform texture2D textures[];
+ */
+static const uint32_t push_constant_fixture[] = {
+    // Magic, version 1.0, generator, id bound, schema
+    0x07230203, 0x00010000, 0, 13, 0,
+    // OpCapability Shader
+    SPIRV_OP(17, 2), 1,
+    // OpMemoryModel Logical GLSL450
+    SPIRV_OP(14, 3), 0, 1,
+    // OpEntryPoint Fragment %1 "main"
+    SPIRV_OP(15, 5), 4, 1, 0x6E69616D, 0,
+    // Decorations
+    SPIRV_OP(71, 3), 7, 2,
+    SPIRV_OP(72, 5), 7, 1, 7, 16,
+    SPIRV_OP(72, 5), 7, 1, 35, 32,
+    SPIRV_OP(72, 5), 7, 0, 35, 16,
+    SPIRV_OP(71, 4), 12, 34, 0,
+    SPIRV_OP(71, 4), 12, 33, 0,
+    // %2 float, %3 vec4, %4 vec3, %5 mat3
+    SPIRV_OP(22, 3), 2, 32,
+    SPIRV_OP(23, 4), 3, 2, 4,
+    SPIRV_OP(23, 4), 4, 2, 3,
+    SPIRV_OP(24, 4), 5, 4, 3,
+    // %6 image 2D sampled, %10 runtime array of it
+    SPIRV_OP(25, 9), 6, 2, 1, 0, 0, 0, 1, 0,
+    SPIRV_OP(29, 3), 10, 6,
+    // %7 Push
+    SPIRV_OP(30, 4), 7, 3, 5,
+    // Pointers
+    SPIRV_OP(32, 4), 8, 9, 7,
+    SPIRV_OP(32, 4), 11, 0, 10,
+    // Variables
+    SPIRV_OP(59, 4), 8, 9, 9,
+    SPIRV_OP(59, 4), 11, 12, 0,
+};
+
+static void
+test_spirv_reflect_push_constants(void)
+{
+    ShaderReflection reflection;
+    assert(vut_reflect_shader(push_constant_fixture, sizeof(push_constant_fixture),
+                              &reflection) == VK_SUCCESS);
+    assert(reflection.stages == VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    // From the tint to the end of the three padded columns
+    assert(reflection.push_constant_range_count == 1);
+    assert(reflection.push_constant_range.offset == 16);
+    assert(reflection.push_constant_range.size == 32 + 3 * 16 - 16);
+
+    // The runtime array has no count until the bindless set replaces it
+    assert(reflection.set_count == 1);
+    assert(reflection.sets[0].unsized);
+    assert(reflection.sets[0].bindings[0].descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+    assert(reflection.sets[0].bindings[0].descriptorCount == 0);
+}
+
+static void
+test_spirv_reflect(void)
+{
+    ShaderReflection reflection;
+    assert(vut_reflect_shader(reflection_fixture, sizeof(reflection_fixture), &reflection) ==
+           VK_SUCCESS);
+    assert(reflection.stages == VK_SHADER_STAGE_VERTEX_BIT);
+
+    assert(reflection.set_count == 2);
+    assert(reflection.sets[0].binding_count == 1);
+    const VkDescriptorSetLayoutBinding* textures = &reflection.sets[0].bindings[0];
+    assert(textures->binding == 1);
+    assert(textures->descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    assert(textures->descriptorCount == 4);
+    assert(textures->stageFlags == VK_SHADER_STAGE_VERTEX_BIT);
+    assert(!reflection.sets[0].unsized);
+
+    assert(reflection.sets[1].binding_count == 1);
+    const VkDescriptorSetLayoutBinding* camera = &reflection.sets[1].bindings[0];
+    assert(camera->binding == 3);
+    assert(camera->descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    assert(camera->descriptorCount == 1);
+
+    assert(reflection.push_constant_range_count == 1);
+    assert(reflection.push_constant_range.offset == 0);
+    assert(reflection.push_constant_range.size == 16);
+
+    assert(reflection.vertex_attribute_count == 2);
+    assert(reflection.vertex_attributes[0].location == 0);
+    assert(reflection.vertex_attributes[0].format == VK_FORMAT_R32G32B32_SFLOAT);
+    assert(reflection.vertex_attributes[0].offset == 0);
+    assert(reflection.vertex_attributes[1].location == 1);
+    assert(reflection.vertex_attributes[1].format == VK_FORMAT_R32G32B32A32_SFLOAT);
+    assert(reflection.vertex_attributes[1].offset == 12);
+    assert(reflection.vertex_stride == 28);
+
+    assert(reflection.spec_constant_count == 1);
+    assert(reflection.spec_constants[0].constantID == 7);
+    assert(reflection.spec_constants[0].size == 4);
+    assert(reflection.spec_data_size == 4);
+
+    // Another stage using the same set adds its stage to the binding
+    ShaderReflection fragment = reflection;
+    fragment.stages = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragment.sets[0].bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    assert(vut_reflect_merge(&reflection, &fragment) == VK_SUCCESS);
+    assert(reflection.stages == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT));
+    assert(reflection.sets[0].bindings[0].stageFlags ==
+           (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT));
+    assert(reflection.spec_constant_count == 1);
+
+    // But not with another type
+    fragment.sets[1].bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    assert(vut_reflect_merge(&reflection, &fragment) == VK_ERROR_INITIALIZATION_FAILED);
+
+    // Broken modules
+    uint32_t broken[sizeof(reflection_fixture) / sizeof(uint32_t)];
+    memcpy(broken, reflection_fixture, sizeof(broken));
+    assert(vut_reflect_shader(broken, 4 * sizeof(uint32_t), &reflection) ==
+           VK_ERROR_INITIALIZATION_FAILED);
+    broken[0] = 0;
+    assert(vut_reflect_shader(broken, sizeof(broken), &reflection) ==
+           VK_ERROR_INITIALIZATION_FAILED);
+
+    // The last instruction runs past the end
+    memcpy(broken, reflection_fixture, sizeof(broken));
+    assert(vut_reflect_shader(broken, sizeof(broken) - sizeof(uint32_t), &reflection) ==
+           VK_ERROR_INITIALIZATION_FAILED);
+
+    // An id beyond the bound is ignored instead of written
+    broken[3] = 12;
+    assert(vut_reflect_shader(broken, sizeof(broken), &reflection) == VK_SUCCESS);
+    assert(reflection.set_count == 0);
+    assert(reflection.vertex_attribute_count == 0);
+}
+
+int
+main(void)
+{
+    test_spirv_reflect();
+    test_spirv_reflect_push_constants();
+
+    return EXIT_SUCCESS;
+}
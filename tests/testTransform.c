@@ -0,0 +1,126 @@
+/**
+ * @file testTransform.c
+ * @brief Tests of the transform hierarchy against matrices built with cglm
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "transform.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define TRANSFORM_NODE_COUNT 5
+
+typedef struct
+{
+    uint32_t parent;
+    vec3 position;
+    vec3 axis;
+    float angle;
+    vec3 scale;
+} TestNode;
+
+static void
+transform_expected(const TestNode nodes[], uint32_t node, mat4 dest)
+{
+    mat4 local;
+    versor rotation;
+    glm_quatv(rotation, nodes[node].angle, (float*)nodes[node].axis);
+    glm_translate_make(local, (float*)nodes[node].position);
+    glm_quat_rotate(local, rotation, local);
+    glm_scale(local, (float*)nodes[node].scale);
+
+    if (nodes[node].parent == VUT_TRANSFORM_ROOT) {
+        glm_mat4_copy(local, dest);
+        return;
+    }
+
+    mat4 parent;
+    transform_expected(nodes, nodes[node].parent, parent);
+    glm_mat4_mul(parent, local, dest);
+}
+
+static void
+transform_check(const TransformHierarchy* hierarchy, const TestNode nodes[])
+{
+    for (uint32_t node = 0; node < TRANSFORM_NODE_COUNT; node++) {
+        mat4 world;
+        mat4 expected;
+        vut_transform_world_mat4(hierarchy, node, world);
+        transform_expected(nodes, node, expected);
+
+        for (uint32_t column = 0; column < 4; column++) {
+            for (uint32_t row = 0; row < 4; row++) {
+                assert(fabsf(world[column][row] - expected[column][row]) < 1e-4f);
+            }
+        }
+    }
+}
+
+static void
+transform_apply(TransformHierarchy* hierarchy, TestNode nodes[], uint32_t node)
+{
+    versor rotation;
+    glm_quatv(rotation, nodes[node].angle, nodes[node].axis);
+    vut_transform_set_position(hierarchy, node, nodes[node].position);
+    vut_transform_set_rotation(hierarchy, node, rotation);
+    vut_transform_set_scale(hierarchy, node, nodes[node].scale);
+}
+
+static void
+test_transform(void)
+{
+    // The last node goes below the root after deeper nodes exist, so the update sorts
+    TestNode nodes[TRANSFORM_NODE_COUNT] = {
+        { VUT_TRANSFORM_ROOT, { 1.0f, 2.0f, 3.0f }, { 0.0f, 0.0f, 1.0f }, 1.5f, { 1, 1, 1 } },
+        { 0, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 0.0f, { 2, 2, 2 } },
+        { 1, { 3.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 0.7f, { 1, 0.5f, 1 } },
+        { 2, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 1.0f }, -0.3f, { 1, 1, 3 } },
+        { 0, { -2.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, 2.0f, { 0.5f, 1, 1 } },
+    };
+
+    // A small capacity so the arrays have to grow
+    TransformHierarchy hierarchy;
+    vut_transform_hierarchy_init(2, &hierarchy);
+
+    for (uint32_t node = 0; node < TRANSFORM_NODE_COUNT; node++) {
+        assert(vut_transform_add(&hierarchy, nodes[node].parent) == node);
+        transform_apply(&hierarchy, nodes, node);
+    }
+    vut_transform_hierarchy_update(&hierarchy);
+    transform_check(&hierarchy, nodes);
+
+    // Parents are sorted before their children
+    for (uint32_t node = 1; node < TRANSFORM_NODE_COUNT; node++) {
+        assert(vut_transform_index(&hierarchy, nodes[node].parent) <
+               vut_transform_index(&hierarchy, node));
+    }
+
+    // Moving the root moves every descendant
+    nodes[0].position[0] = -5.0f;
+    nodes[0].angle = 0.25f;
+    transform_apply(&hierarchy, nodes, 0);
+    vut_transform_hierarchy_update(&hierarchy);
+    transform_check(&hierarchy, nodes);
+
+    // A change in the middle leaves the other branch alone
+    nodes[2].scale[1] = 4.0f;
+    transform_apply(&hierarchy, nodes, 2);
+    vut_transform_hierarchy_update(&hierarchy);
+    transform_check(&hierarchy, nodes);
+
+    vut_transform_hierarchy_destroy(&hierarchy);
+}
+
+int
+main(void)
+{
+    test_transform();
+
+    return EXIT_SUCCESS;
+}
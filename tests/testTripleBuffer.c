@@ -0,0 +1,98 @@
+/**
+ * @file testTripleBuffer.c
+ * @brief Tests of the triple buffer with a writer and a reader thread
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+#include "triple_buffer.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define TRIPLE_BUFFER_VERSIONS 100000
+
+typedef struct
+{
+    uint64_t version;
+    // Always the version again, differs when a buffer is read while it is written
+    uint64_t check;
+} Versioned;
+
+static void*
+triple_buffer_writer(void* data)
+{
+    TripleBuffer* buffer = data;
+    for (uint64_t version = 1; version <= TRIPLE_BUFFER_VERSIONS; version++) {
+        Versioned* versioned = vut_triple_buffer_write(buffer);
+        versioned->version = version;
+        versioned->check = version;
+        vut_triple_buffer_publish(buffer);
+    }
+
+    return NULL;
+}
+
+static void
+test_triple_buffer(void)
+{
+    TripleBuffer buffer;
+    vut_triple_buffer_init(sizeof(Versioned), &buffer);
+
+    bool fresh = true;
+    const Versioned* read = vut_triple_buffer_read(&buffer, &fresh);
+    assert(!fresh);
+    assert(read->version == 0);
+
+    Versioned* written = vut_triple_buffer_write(&buffer);
+    written->version = 1;
+    vut_triple_buffer_publish(&buffer);
+    read = vut_triple_buffer_read(&buffer, &fresh);
+    assert(fresh);
+    assert(read->version == 1);
+
+    // Nothing new, the same buffer again
+    assert(vut_triple_buffer_read(&buffer, &fresh) == read);
+    assert(!fresh);
+
+    // Only the latest of several publishes is seen
+    for (uint64_t version = 2; version <= 4; version++) {
+        written = vut_triple_buffer_write(&buffer);
+        assert(written != read);
+        written->version = version;
+        vut_triple_buffer_publish(&buffer);
+    }
+    read = vut_triple_buffer_read(&buffer, &fresh);
+    assert(fresh);
+    assert(read->version == 4);
+    vut_triple_buffer_destroy(&buffer);
+
+    // Versions only go up and are never torn
+    vut_triple_buffer_init(sizeof(Versioned), &buffer);
+    pthread_t writer;
+    assert(pthread_create(&writer, NULL, triple_buffer_writer, &buffer) == 0);
+
+    uint64_t last = 0;
+    while (last != TRIPLE_BUFFER_VERSIONS) {
+        read = vut_triple_buffer_read(&buffer, &fresh);
+        assert(read->version == read->check);
+        assert(read->version >= last);
+        assert(!fresh || read->version > last || read->version == 0);
+        last = read->version;
+    }
+
+    pthread_join(writer, NULL);
+    vut_triple_buffer_destroy(&buffer);
+}
+
+int
+main(void)
+{
+    test_triple_buffer();
+
+    return EXIT_SUCCESS;
+}
@@ -1,7 +1,285 @@
+/**
+ * @file testVuR.c
+ * @brief Tests of the renderer that need a Vulkan device: compute dispatches read back
+ * on the CPU
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2019
+ *
+ * Runs headless, so lavapipe is enough:
+ *     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./bin/testVuR
+ */
+
+#include "compute.h"
+#include "vk_util.h"
+
+#include "shaders.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Not a multiple of the group size, the invocations past the end must not write
+#define VALUE_COUNT 1000
+#define BUFFER_COUNT 1024
+#define GROUP_SIZE 64
+
+typedef struct
+{
+    float scale;
+    uint32_t count;
+} ScaleParams;
+
+typedef struct
+{
+    VkPhysicalDevice gpu;
+    VkDevice device;
+    VkQueue queue;
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffer;
+    VkFence fence;
+
+    // Host visible, so the results are read straight from the mapping
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    float* values;
+} Device;
+
+static uint32_t
+find_graphics_queue_family(VkPhysicalDevice gpu)
+{
+    uint32_t family_count;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, NULL);
+    ArenaScope scope = vut_arena_begin_scope(vut_get_scratch_arena());
+    VkQueueFamilyProperties* families =
+        VUT_ARENA_ALLOC(vut_get_scratch_arena(), VkQueueFamilyProperties, family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, families);
+
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < family_count; i++) {
+        if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            index = i;
+            break;
+        }
+    }
+
+    vut_arena_end_scope(scope);
+    return index;
+}
+
+static void
+check_reflection(const ComputeProgram* program)
+{
+    const ShaderReflection* reflection = &program->reflection;
+    assert(reflection->stages == VK_SHADER_STAGE_COMPUTE_BIT);
+    assert(reflection->set_count == 1);
+    assert(reflection->sets[0].binding_count == 1);
+    assert(reflection->sets[0].bindings[0].binding == 0);
+    assert(reflection->sets[0].bindings[0].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    assert(reflection->push_constant_range_count == 1);
+    assert(reflection->push_constant_range.size == sizeof(ScaleParams));
+}
+
+static void
+begin_dispatch(Device* device)
+{
+    for (uint32_t i = 0; i < BUFFER_COUNT; i++) {
+        device->values[i] = (float)i;
+    }
+
+    vkResetCommandPool(device->device, device->command_pool, 0);
+    vut_begin_command_buffer(device->command_buffer);
+}
+
+// Scales the values by 3 and checks that only the first VALUE_COUNT changed
+static void
+end_dispatch(Device* device, const ComputeProgram* program)
+{
+    const ScaleParams params = {
+        .scale = 3.0f,
+        .count = VALUE_COUNT,
+    };
+    vur_compute_push_constants(device->command_buffer, program, sizeof(params), &params);
+    vut_dispatch(device->command_buffer, BUFFER_COUNT / GROUP_SIZE, 1, 1);
+    vut_memory_barrier(device->command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                       VK_ACCESS_HOST_READ_BIT);
+    assert(vkEndCommandBuffer(device->command_buffer) == VK_SUCCESS);
+
+    const VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &device->command_buffer,
+    };
+    assert(vkResetFences(device->device, 1, &device->fence) == VK_SUCCESS);
+    assert(vkQueueSubmit(device->queue, 1, &submit_info, device->fence) == VK_SUCCESS);
+    assert(vkWaitForFences(device->device, 1, &device->fence, VK_TRUE, UINT64_MAX) ==
+           VK_SUCCESS);
+
+    for (uint32_t i = 0; i < BUFFER_COUNT; i++) {
+        assert(device->values[i] == (i < VALUE_COUNT ? 3.0f * i : (float)i));
+    }
+}
+
+static void
+test_compute_sets(Device* device)
+{
+    LayoutCache layout_cache;
+    vut_layout_cache_init(device->device, false, &layout_cache);
+    ComputeProgram program;
+    assert(vur_init_compute_program(device->device, &layout_cache, VK_NULL_HANDLE, NULL,
+                                    scale_comp_spv, scale_comp_spv_size,
+                                    &program) == VK_SUCCESS);
+    check_reflection(&program);
+    assert(!program.descriptor_buffer);
+
+    const VkDescriptorPoolSize pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+    };
+    DescriptorAllocator allocator;
+    vur_descriptor_allocator_init(device->device, 1, 1, &pool_size, &allocator);
+    VkDescriptorSet set;
+    assert(vur_compute_alloc_set(&program, &allocator, 0, &set) == VK_SUCCESS);
+    vut_write_buffer_descriptor(device->device, set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                device->buffer, VK_WHOLE_SIZE);
+
+    // The descriptor buffer path refuses the program before it touches the buffer
+    VkDeviceSize offset;
+    assert(vur_compute_alloc_buffer_set(&program, NULL, 0, &offset) ==
+           VK_ERROR_FEATURE_NOT_PRESENT);
+
+    begin_dispatch(device);
+    vur_compute_bind(device->command_buffer, &program, 0, 1, &set);
+    end_dispatch(device, &program);
+
+    vur_descriptor_allocator_destroy(&allocator);
+    vur_destroy_compute_program(device->device, &program);
+    vut_layout_cache_destroy(&layout_cache);
+}
+
+static void
+test_compute_descriptor_buffer(Device* device)
+{
+    LayoutCache layout_cache;
+    vut_layout_cache_init(device->device, true, &layout_cache);
+    ComputeProgram program;
+    assert(vur_init_compute_program(device->device, &layout_cache, VK_NULL_HANDLE, NULL,
+                                    scale_comp_spv, scale_comp_spv_size,
+                                    &program) == VK_SUCCESS);
+    check_reflection(&program);
+    assert(program.descriptor_buffer);
+
+    // Sets can not come from pools for it
+    VkDescriptorSet set;
+    assert(vur_compute_alloc_set(&program, NULL, 0, &set) == VK_ERROR_FEATURE_NOT_PRESENT);
+
+    DescriptorBuffer descriptors;
+    assert(vur_descriptor_buffer_init(device->device, device->gpu, 4096, &descriptors) ==
+           VK_SUCCESS);
+    VkDeviceSize set_offset;
+    assert(vur_compute_alloc_buffer_set(&program, &descriptors, 0, &set_offset) == VK_SUCCESS);
+    VkDeviceSize binding_offset =
+        vut_get_descriptor_binding_offset(device->device, program.set_layouts[0], 0);
+    vur_descriptor_buffer_write_buffer(&descriptors, set_offset + binding_offset,
+                                       VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                       vut_get_buffer_address(device->device, device->buffer),
+                                       BUFFER_COUNT * sizeof(float));
+
+    begin_dispatch(device);
+    const VkDescriptorBufferBindingInfoEXT binding = vur_descriptor_buffer_binding(&descriptors);
+    const uint32_t buffer_index = 0;
+    vur_compute_bind_buffers(device->command_buffer, &program, 1, &binding, 0, 1,
+                             &buffer_index, &set_offset);
+    end_dispatch(device, &program);
+
+    vur_descriptor_buffer_destroy(&descriptors);
+    vur_destroy_compute_program(device->device, &program);
+    vut_layout_cache_destroy(&layout_cache);
+}
+
 int
-main(int argc, char const* argv[])
+main(void)
 {
-    
+    // Enumerations of the vut_ functions allocate their arrays from it
+    Arena arena;
+    vut_arena_init(64 * 1024, &arena);
+    vut_set_scratch_arena(&arena);
+
+    const VkApplicationInfo app_info = {
+        .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+        .pNext = NULL,
+        .pApplicationName = "testVuR",
+        .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
+        .apiVersion = VK_API_VERSION_1_2,
+        .pEngineName = "No Engine",
+    };
+    const VkInstanceCreateInfo instance_info = {
+        .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .pApplicationInfo = &app_info,
+        .enabledExtensionCount = 0,
+        .ppEnabledExtensionNames = NULL,
+        .enabledLayerCount = 0,
+        .ppEnabledLayerNames = NULL,
+    };
+    VkInstance instance;
+    assert(vkCreateInstance(&instance_info, NULL, &instance) == VK_SUCCESS);
+
+    uint32_t gpu_count;
+    vut_get_physical_devices(instance, &gpu_count, NULL);
+    assert(gpu_count > 0);
+    VkPhysicalDevice* gpus = VUT_ARENA_ALLOC(&arena, VkPhysicalDevice, gpu_count);
+    vut_get_physical_devices(instance, &gpu_count, gpus);
+
+    Device device = { 0 };
+    vut_pick_physical_device(gpus, gpu_count, &device.gpu);
+
+    // Only descriptor buffers are enabled, the other path is tested when the device has them
+    DeviceFeatures supported;
+    vut_query_device_features(device.gpu, &supported);
+    const DeviceFeatures features = {
+        .descriptor_buffer = supported.descriptor_buffer,
+    };
+
+    // The queue the renderer would use for async compute
+    uint32_t graphics_family = find_graphics_queue_family(device.gpu);
+    uint32_t compute_family, compute_index;
+    vut_get_compute_queue(device.gpu, graphics_family, &compute_family, &compute_index);
+    assert(vut_init_device(device.gpu, graphics_family, compute_family, compute_index, &features,
+                           &device.device) == VK_SUCCESS);
+    vkGetDeviceQueue(device.device, compute_family, compute_index, &device.queue);
+
+    vut_init_command_pool(device.device, compute_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                          &device.command_pool);
+    vut_alloc_command_buffer(device.device, device.command_pool, 1, &device.command_buffer);
+    vut_init_fence(device.device, 0, &device.fence);
+
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (features.descriptor_buffer) {
+        usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+    assert(vut_init_buffer(device.device, device.gpu, BUFFER_COUNT * sizeof(float), usage,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           &device.buffer, &device.memory) == VK_SUCCESS);
+    assert(vkMapMemory(device.device, device.memory, 0, VK_WHOLE_SIZE, 0,
+                       (void**)&device.values) == VK_SUCCESS);
+
+    test_compute_sets(&device);
+    if (features.descriptor_buffer) {
+        test_compute_descriptor_buffer(&device);
+    }
+
+    vkDestroyBuffer(device.device, device.buffer, NULL);
+    vkFreeMemory(device.device, device.memory, NULL);
+    vkDestroyFence(device.device, device.fence, NULL);
+    vkDestroyCommandPool(device.device, device.command_pool, NULL);
+    vkDestroyDevice(device.device, NULL);
+    vkDestroyInstance(instance, NULL);
+    vut_set_scratch_arena(NULL);
+    vut_arena_destroy(&arena);
 
-    return 0;
-}
\ No newline at end of file
+    return EXIT_SUCCESS;
+}